@@ -54,6 +54,28 @@ std::shared_ptr<ChartFormatBase> ChartFormatBase::createFromFile(const Path& pat
     }
 }
 
+std::shared_ptr<ChartFormatBase> ChartFormatBase::createMetaFromFile(const Path& path, uint64_t randomSeed)
+{
+    Path filePath = fs::absolute(path);
+    std::ifstream fs{filePath};
+    if (fs.fail())
+    {
+        LOG_WARNING << "[Chart] File invalid: " << filePath;
+        return nullptr;
+    }
+
+    switch (analyzeChartType(path))
+    {
+    case eChartFormat::BMS:
+        return std::static_pointer_cast<ChartFormatBase>(
+            std::make_shared<ChartFormatBMSMetaScan>(filePath, randomSeed));
+
+    case eChartFormat::UNKNOWN: LOG_WARNING << "[Chart] File type unknown: " << filePath; return nullptr;
+
+    default: LOG_WARNING << "[Chart] File type unsupported: " << filePath; return nullptr;
+    }
+}
+
 std::string ChartFormatBase::formatReadmeText(const std::vector<std::pair<std::string, std::string>>& files)
 {
     std::string out;
@@ -35,6 +35,8 @@ public:
     ChartFormatBase() = default;
     virtual ~ChartFormatBase() = default;
     static std::shared_ptr<ChartFormatBase> createFromFile(const Path& path, uint64_t randomSeed);
+    // Only header and statistics are read, notes are not kept. Enough for the song database.
+    static std::shared_ptr<ChartFormatBase> createMetaFromFile(const Path& path, uint64_t randomSeed);
 
 protected:
     bool loaded = false;
@@ -1,9 +1,11 @@
 #include "chartformat_bms.h"
 #include "common/log.h"
+#include <algorithm>
 #include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <numeric>
 #include <optional>
 #include <random>
@@ -11,6 +13,7 @@
 #include <utility>
 
 #include "common/encoding.h"
+#include "common/mapped_file.h"
 #include "common/utils.h"
 #include <common/assert.h>
 #include <common/u8.h>
@@ -22,6 +25,85 @@ class noteLineException : public std::exception
 {
 };
 
+// #[\d]{3}[0-9A-Za-z]{2}:.*
+static bool isChannelLine(StringContentView buf)
+{
+    auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+    auto isAlnum = [&](char c) { return isDigit(c) || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'); };
+    return buf.length() >= 7 && buf[0] == '#' && isDigit(buf[1]) && isDigit(buf[2]) && isDigit(buf[3]) &&
+           isAlnum(buf[4]) && isAlnum(buf[5]) && buf[6] == ':';
+}
+
+// Lines without NUL or non-ASCII bytes come out of to_utf8 unchanged, no need to convert them.
+static bool needsConversion(StringContentView buf)
+{
+    return std::any_of(buf.begin(), buf.end(),
+                       [](char c) { return c == '\0' || static_cast<unsigned char>(c) > 0x7f; });
+}
+
+// Tokenize like seqToLane36/seqToLane16 without building a channel.
+template <typename Fn> static void forEachObject(StringContentView str, bool hex, Fn&& fn)
+{
+    const unsigned resolution = static_cast<unsigned>(str.length() / 2);
+    for (unsigned i = 0; i < resolution; i++)
+    {
+        const unsigned value = hex ? base16(str[i * 2], str[i * 2 + 1]) : base36(str[i * 2], str[i * 2 + 1]);
+        if (value != 0)
+            fn(i, resolution, value);
+    }
+}
+
+// What is left of the channel lines after a meta scan.
+struct ChartFormatBMS::ChannelStats
+{
+    // lane index is idx + 10 * side, PMS indices go up to 35
+    static constexpr size_t LANE_COUNT = 46;
+
+    struct Note
+    {
+        unsigned bar;
+        unsigned segment;
+        unsigned resolution;
+        unsigned value;
+        bool ln;
+    };
+    // Regular notes of lanes which may contain LNs, in file order. Only position and value are kept for pairing.
+    std::array<std::vector<Note>, 20> regularNotes;
+    std::array<unsigned long, LANE_COUNT> regularCount{};
+    std::array<unsigned long, LANE_COUNT> lnCount{};
+    std::array<unsigned long, LANE_COUNT> lnPairCount{};
+    unsigned long mineCount = 0;
+
+    // -1 if the lane has no object
+    std::array<int, LANE_COUNT> lastObjectBar;
+    int lastBgmBar = -1;
+
+    struct TimingEvent
+    {
+        // Same order as ChartObjectBMS handles them on the same segment.
+        enum Type : unsigned
+        {
+            BPM,
+            EXBPM,
+            STOP,
+        } type;
+        unsigned bar;
+        unsigned segment;
+        unsigned resolution;
+        unsigned value;
+    };
+    std::vector<TimingEvent> timing;
+
+    ChannelStats() { lastObjectBar.fill(-1); }
+};
+
+template <typename T> static bool isEarlierPosition(const T& lhs, const T& rhs)
+{
+    if (lhs.bar != rhs.bar)
+        return lhs.bar < rhs.bar;
+    return uint64_t(lhs.segment) * rhs.resolution < uint64_t(rhs.segment) * lhs.resolution;
+}
+
 using lunaticvibes::parser_bms::JudgeDifficulty;
 
 // https://hitkey.nekokan.dyndns.info/cmds.htm#RANK
@@ -49,15 +131,24 @@ ChartFormatBMS::ChartFormatBMS() : ChartFormatBMSMeta()
     metres.resize(MAXBARIDX + 1);
 }
 
-ChartFormatBMS::ChartFormatBMS(const Path& filePath, uint64_t randomSeed) : ChartFormatBMSMeta()
+ChartFormatBMS::ChartFormatBMS(const Path& filePath, uint64_t randomSeed, ParseMode mode) : ChartFormatBMSMeta()
 {
     wavFiles.resize(MAXSAMPLEIDX + 1);
     bgaFiles.resize(MAXSAMPLEIDX + 1);
     metres.resize(MAXBARIDX + 1);
+    initWithFile(filePath, randomSeed, mode);
+}
+
+ChartFormatBMS::~ChartFormatBMS() = default;
+
+ChartFormatBMSMetaScan::ChartFormatBMSMetaScan(const Path& filePath, uint64_t randomSeed) : ChartFormatBMS()
+{
+    channelStats = std::make_unique<ChannelStats>();
     initWithFile(filePath, randomSeed);
+    channelStats.reset();
 }
 
-int ChartFormatBMS::initWithFile(const Path& filePath, uint64_t randomSeed)
+int ChartFormatBMS::initWithFile(const Path& filePath, uint64_t randomSeed, ParseMode mode)
 {
     using err = ErrorCode;
     if (loaded)
@@ -69,22 +160,33 @@ int ChartFormatBMS::initWithFile(const Path& filePath, uint64_t randomSeed)
 
     fileName = filePath.filename();
     absolutePath = std::filesystem::absolute(filePath);
-    std::ifstream ifsFile{absolutePath};
-    if (ifsFile.fail())
+
+    // the whole file is in ram once for all, lines are views into it
+    lunaticvibes::MappedFile mappedFile;
+    StringContent streamBuffer;
+    StringContentView bmsFile;
+    if (mode == ParseMode::Mapped && mappedFile.open(absolutePath))
     {
-        errorCode = err::FILE_ERROR;
-        errorLine = 0;
-        LOG_WARNING << "[BMS] " << absolutePath << " File ERROR";
-        return 1;
+        bmsFile = mappedFile.view();
     }
+    else
+    {
+        if (mode == ParseMode::Mapped)
+            LOG_DEBUG << "[BMS] " << absolutePath << " cannot be mapped, reading it instead";
 
-    // copy the whole file into ram, once for all
-    std::stringstream bmsFile;
-    bmsFile << ifsFile.rdbuf();
-    bmsFile.sync();
-    ifsFile.close();
+        std::ifstream ifsFile{absolutePath};
+        if (ifsFile.fail())
+        {
+            errorCode = err::FILE_ERROR;
+            errorLine = 0;
+            LOG_WARNING << "[BMS] " << absolutePath << " File ERROR";
+            return 1;
+        }
+        streamBuffer.assign(std::istreambuf_iterator<char>(ifsFile), std::istreambuf_iterator<char>());
+        bmsFile = streamBuffer;
+    }
 
-    auto encoding = getFileEncoding(bmsFile);
+    auto encoding = getBufferEncoding(bmsFile);
 
     LOG_DEBUG << "[BMS] File (" << getFileEncodingName(encoding) << "): " << absolutePath;
 
@@ -107,17 +209,27 @@ int ChartFormatBMS::initWithFile(const Path& filePath, uint64_t randomSeed)
     // implicit parameters
     bool hasDifficulty = false;
 
-    for (StringContent lineBuf, lineBuf_; std::getline(bmsFile, lineBuf_);)
+    // scratch buffers for the few lines that need to be converted
+    StringContent lineBuf, lineBuf_;
+    for (size_t lineStart = 0; lineStart < bmsFile.length();)
     {
+        const size_t lineEnd = std::min(bmsFile.find('\n', lineStart), bmsFile.length());
+        StringContentView buf = bmsFile.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
         srcLine++;
-        if (lineBuf_.length() <= 1)
+        if (buf.length() <= 1)
             continue;
 
-        lunaticvibes::trim_in_place(lineBuf_);
-        lunaticvibes::to_utf8(lineBuf_, encoding, lineBuf);
+        buf = lunaticvibes::trim(buf);
+        if (needsConversion(buf))
+        {
+            lineBuf_.assign(buf);
+            lunaticvibes::to_utf8(lineBuf_, encoding, lineBuf);
+            buf = lineBuf;
+        }
 
-        StringContentView buf(lineBuf);
-        if (buf[0] != '#')
+        if (buf.empty() || buf[0] != '#')
             continue;
 
         // parsing
@@ -257,8 +369,7 @@ int ChartFormatBMS::initWithFile(const Path& filePath, uint64_t randomSeed)
                 }
             }
 
-            static LazyRE2 regexNote{R"(#[\d]{3}[0-9A-Za-z]{2}:.*)"};
-            if (!RE2::FullMatch(re2::StringPiece(buf.data(), buf.length()), *regexNote))
+            if (!isChannelLine(buf))
             {
                 auto spacePos = std::min(buf.length(), buf.find_first_of(' '));
                 if (spacePos <= 1)
@@ -425,6 +536,12 @@ int ChartFormatBMS::initWithFile(const Path& filePath, uint64_t randomSeed)
                     const auto x_ = static_cast<int>(base36(key[3]));
                     const auto _y = static_cast<int>(base36(key[4]));
 
+                    if (channelStats)
+                    {
+                        scanChannel(bar, x_, _y, value);
+                        continue;
+                    }
+
                     if (x_ == 0) // 0x: basic info
                     {
                         switch (_y)
@@ -647,114 +764,195 @@ int ChartFormatBMS::initWithFile(const Path& filePath, uint64_t randomSeed)
         if (metres[i].toDouble() == 0.0)
             metres[i] = Metre(4, 4);
 
+    if (channelStats)
+        collectScanStatistics();
+    else
+        collectNoteStatistics();
+
+    // Notes swapped by https://hitkey.nekokan.dyndns.info/cmds.htm#PMS
+    // Sometimes there is a mix of those note channels, for example `Calamity Fortune [9 THOUGHTLESS]`.
+    // LR2 seems to merge together at the same time.
+    if (isPMS)
+    {
+        gamemode = 9;
+        player = 1;
+
+        // 11	12	13	14	15	18	19	16	17	not known or well known
+        std::swap(chNotesRegular[6], chNotesRegular[8]);
+        std::swap(chNotesRegular[7], chNotesRegular[9]);
+        std::swap(chNotesInvisible[6], chNotesInvisible[8]);
+        std::swap(chNotesInvisible[7], chNotesInvisible[9]);
+        std::swap(chNotesLN[6], chNotesLN[8]);
+        std::swap(chNotesLN[7], chNotesLN[9]);
+        std::swap(chMines[6], chMines[8]);
+        std::swap(chMines[7], chMines[9]);
+        have67 = true;
+        have67_2 = false;
+        have89 = true;
+        have89_2 = false;
+        haveAny_2 = false;
+        if (have67_2)
+        {
+            // 21	22	23	24	25	28	29	26	27	2P-side (right)
+            LOG_DEBUG << "[BMS] 18KEYS is not supported, parsing as 9KEYS";
+            std::swap(chNotesRegular[16], chNotesRegular[18]);
+            std::swap(chNotesRegular[17], chNotesRegular[19]);
+            std::swap(chNotesInvisible[16], chNotesInvisible[18]);
+            std::swap(chNotesInvisible[17], chNotesInvisible[19]);
+            std::swap(chNotesLN[16], chNotesLN[18]);
+            std::swap(chNotesLN[17], chNotesLN[19]);
+            std::swap(chMines[16], chMines[18]);
+            std::swap(chMines[17], chMines[19]);
+            have67_2 = true;
+        }
+
+        // 11	12	13	14	15	22	23	24	25	standard PMS
+        auto imbue = [](LaneMap& lhs, LaneMap& rhs) {
+            if (lhs.empty())
+                std::swap(lhs, rhs);
+            for (auto& [k, rv] : rhs)
+                lhs[k].imbue(rv);
+        };
+        imbue(chNotesRegular[6], chNotesRegular[12]);
+        imbue(chNotesRegular[7], chNotesRegular[13]);
+        imbue(chNotesRegular[8], chNotesRegular[14]);
+        imbue(chNotesRegular[9], chNotesRegular[15]);
+        imbue(chNotesInvisible[6], chNotesInvisible[12]);
+        imbue(chNotesInvisible[7], chNotesInvisible[13]);
+        imbue(chNotesInvisible[8], chNotesInvisible[14]);
+        imbue(chNotesInvisible[9], chNotesInvisible[15]);
+        imbue(chNotesLN[6], chNotesLN[12]);
+        imbue(chNotesLN[7], chNotesLN[13]);
+        imbue(chNotesLN[8], chNotesLN[14]);
+        imbue(chNotesLN[9], chNotesLN[15]);
+        imbue(chMines[6], chMines[12]);
+        imbue(chMines[7], chMines[13]);
+        imbue(chMines[8], chMines[14]);
+        imbue(chMines[9], chMines[15]);
+    }
+    else
+    {
+        player = (have67_2 || haveAny_2) ? 3 : 1;
+        if (have67 || have67_2)
+        {
+            gamemode = (player == 1 ? 7 : 14);
+        }
+        else
+        {
+            gamemode = (player == 1 ? 5 : 10);
+        }
+    }
+
+    if (channelStats)
+        scanTotalLength();
+
+    fileHash = mode == ParseMode::Mapped ? md5(bmsFile) : md5file(absolutePath);
+    LOG_INFO << "[BMS] File (" << getFileEncodingName(encoding) << "): " << absolutePath
+             << " MD5: " << fileHash.hexdigest();
+
+    loaded = true;
+
+    return 0;
+}
+
+void ChartFormatBMS::collectNoteStatistics()
+{
+    // Lookups below go through find(), operator[] would add an empty channel for every bar it is asked about.
+
     // pick LNs out of notes for each lane
     if (!lnobjSet.empty() || haveLNchannels)
     {
-        for (unsigned chIdx = 0; chIdx < 20; ++chIdx)
+        for (auto& [chIdx, lane] : chNotesRegular)
         {
-            if (chNotesRegular.find(chIdx) == chNotesRegular.end())
-                continue;
+            if (chIdx >= 20)
+                break;
 
-            decltype(std::declval<channel>().notes.begin()) LNhead;
+            channel* head = nullptr; // channel of the pending LN head
+            size_t LNhead = 0;       // index into head->notes
             unsigned bar_head = 0;
             unsigned resolution_head = 1;
-            unsigned bar_curr = 0;
-            bool hasHead = false;
 
             // find next LN head
-            for (; bar_curr <= lastBarIdx; bar_curr++)
+            for (auto& [bar_curr, ch] : lane)
             {
-                if (chNotesRegular[chIdx][bar_curr].notes.empty())
-                    continue;
+                if (bar_curr > lastBarIdx)
+                    break;
 
-                auto& noteList = chNotesRegular[chIdx][bar_curr].notes;
-                auto itNote = noteList.begin();
-                while (itNote != noteList.end())
+                auto& noteList = ch.notes;
+                size_t itNote = 0;
+                while (itNote < noteList.size())
                 {
                     // Regular note inside a LN (can be seen with o2mania + #LNTYPE 1) is not allowed. Handle any
                     // following note as LN tail.
-                    if (hasHead && (lnobjSet.count(itNote->value) || (LNhead->flags & channel::NoteParseValue::LN)))
+                    if (head != nullptr && (lnobjSet.count(noteList[itNote].value) ||
+                                            (head->notes[LNhead].flags & channel::NoteParseValue::LN)))
                     {
-                        unsigned segment =
-                            LNhead->segment * chNotesLN[chIdx][bar_head].relax(resolution_head) / resolution_head;
-                        unsigned value = LNhead->value;
-                        unsigned resolution_tail = chNotesRegular[chIdx][bar_curr].resolution;
-                        unsigned segment2 =
-                            itNote->segment * chNotesLN[chIdx][bar_curr].relax(resolution_tail) / resolution_tail;
-                        unsigned value2 = itNote->value;
-                        chNotesLN[chIdx][bar_head].notes.push_back({segment, value});
-                        chNotesLN[chIdx][bar_curr].notes.push_back({segment2, value2});
+                        auto& headList = head->notes;
+                        channel& lnHead = chNotesLN[chIdx][bar_head];
+                        channel& lnTail = chNotesLN[chIdx][bar_curr];
+                        unsigned segment = headList[LNhead].segment * lnHead.relax(resolution_head) / resolution_head;
+                        unsigned value = headList[LNhead].value;
+                        unsigned resolution_tail = ch.resolution;
+                        unsigned segment2 = noteList[itNote].segment * lnTail.relax(resolution_tail) / resolution_tail;
+                        unsigned value2 = noteList[itNote].value;
+                        lnHead.notes.push_back({segment, value});
+                        lnTail.notes.push_back({segment2, value2});
 
                         haveLN = true;
 
-                        chNotesRegular[chIdx][bar_head].notes.erase(LNhead);
-                        auto itPrev = itNote;
-                        bool resetItNote = (itNote == noteList.begin());
-                        if (!resetItNote)
-                            itPrev--;
-                        chNotesRegular[chIdx][bar_curr].notes.erase(itNote);
-                        itNote = resetItNote ? noteList.begin() : ++itPrev;
+                        // head is always before the tail, so removing it shifts the tail by one within the same bar
+                        headList.erase(headList.begin() + LNhead);
+                        if (bar_head == bar_curr)
+                            --itNote;
+                        noteList.erase(noteList.begin() + itNote);
+                        // itNote now points to the note following the tail
 
+                        head = nullptr;
                         bar_head = 0;
                         resolution_head = 1;
-                        hasHead = false;
                     }
                     else
                     {
+                        head = &ch;
                         LNhead = itNote;
                         bar_head = bar_curr;
-                        resolution_head = chNotesRegular[chIdx][bar_curr].resolution;
-                        hasHead = true;
+                        resolution_head = ch.resolution;
 
                         ++itNote;
                     }
                 }
             }
 
-            if (bar_head <= lastBarIdx)
-                chNotesLN[chIdx][bar_head].sortNotes();
-            if (bar_curr <= lastBarIdx)
-                chNotesLN[chIdx][bar_curr].sortNotes();
+            if (auto ln = chNotesLN.find(chIdx); ln != chNotesLN.end())
+                if (auto it = ln->second.find(bar_head); it != ln->second.end())
+                    it->second.sortNotes();
         }
     }
 
-    // Get statistics
-    if (haveNote)
-    {
-        for (unsigned bar = 0; bar <= lastBarIdx; bar++)
-        {
-            notes_scratch += chNotesRegular[0][bar].notes.size() + chNotesRegular[10][bar].notes.size();
-        }
-
-        for (unsigned lane = 0; lane < chNotesRegular.size(); ++lane)
+    // Get statistics. Lanes 0 and 10 are the scratches.
+    auto countNotes = [this](const std::map<unsigned, LaneMap>& lanes, unsigned long& scratch, unsigned long& key) {
+        for (const auto& [lane, bars] : lanes)
         {
-            if (lane == 0 || lane == 10)
-                continue;
-            for (const auto& [barIdx, ch] : chNotesRegular[lane])
+            for (const auto& [barIdx, ch] : bars)
             {
-                notes_key += ch.notes.size();
+                if (lane != 0 && lane != 10)
+                    key += ch.notes.size();
+                else if (barIdx <= lastBarIdx)
+                    scratch += ch.notes.size();
             }
         }
+    };
+
+    if (haveNote)
+    {
+        countNotes(chNotesRegular, notes_scratch, notes_key);
         notes_total += notes_scratch + notes_key;
     }
 
     if (haveLN)
     {
-        for (unsigned bar = 0; bar <= lastBarIdx; bar++)
-        {
-            notes_scratch_ln += chNotesLN[0][bar].notes.size() + chNotesLN[10][bar].notes.size();
-        }
+        countNotes(chNotesLN, notes_scratch_ln, notes_key_ln);
         notes_scratch_ln /= 2;
-
-        for (unsigned lane = 0; lane < chNotesLN.size(); ++lane)
-        {
-            if (lane == 0 || lane == 10)
-                continue;
-            for (const auto& [barIdx, ch] : chNotesLN[lane])
-            {
-                notes_key_ln += ch.notes.size();
-            }
-        }
         notes_key_ln /= 2;
 
         notes_total += notes_scratch_ln + notes_key_ln;
@@ -776,16 +974,23 @@ int ChartFormatBMS::initWithFile(const Path& filePath, uint64_t randomSeed)
     startBPM = bpm;
     if (haveBPMChange)
     {
-        for (unsigned m = 0; m <= lastBarIdx; m++)
+        for (const auto& [m, ch] : chBPMChange)
         {
-            for (const auto& ns : chBPMChange[m].notes)
+            if (m > lastBarIdx)
+                break;
+            for (const auto& ns : ch.notes)
             {
                 if (ns.value > maxBPM)
                     maxBPM = ns.value;
                 if (ns.value < minBPM)
                     minBPM = ns.value;
             }
-            for (const auto& ns : chExBPMChange[m].notes)
+        }
+        for (const auto& [m, ch] : chExBPMChange)
+        {
+            if (m > lastBarIdx)
+                break;
+            for (const auto& ns : ch.notes)
             {
                 if (exBPM[ns.value] > maxBPM)
                     maxBPM = exBPM[ns.value];
@@ -794,88 +999,311 @@ int ChartFormatBMS::initWithFile(const Path& filePath, uint64_t randomSeed)
             }
         }
     }
+}
 
-    // Notes swapped by https://hitkey.nekokan.dyndns.info/cmds.htm#PMS
-    // Sometimes there is a mix of those note channels, for example `Calamity Fortune [9 THOUGHTLESS]`.
-    // LR2 seems to merge together at the same time.
-    if (isPMS)
+void ChartFormatBMS::scanChannel(unsigned bar, int x_, int _y, StringContentView value)
+{
+    auto& stats = *channelStats;
+
+    auto pushTiming = [&](ChannelStats::TimingEvent::Type type, bool hex) {
+        forEachObject(value, hex, [&](unsigned segment, unsigned resolution, unsigned v) {
+            stats.timing.push_back({type, bar, segment, resolution, v});
+        });
+    };
+
+    if (x_ == 0) // 0x: basic info
     {
-        gamemode = 9;
-        player = 1;
+        switch (_y)
+        {
+        case 1: // 01: BGM
+            forEachObject(value, false, [&](unsigned, unsigned, unsigned) {
+                stats.lastBgmBar = std::max(stats.lastBgmBar, static_cast<int>(bar));
+            });
+            ++bgmLayersCount[bar];
+            break;
+        case 2: // 02: Bar Length
+            metres[bar] = toDouble(value);
+            haveMetricMod = true;
+            break;
+        case 3: // 03: BPM change
+            pushTiming(ChannelStats::TimingEvent::BPM, true);
+            haveBPMChange = true;
+            break;
+        case 4: // 04: BGA Base
+        case 6: // 06: BGA Poor
+        case 7: // 07: BGA Layer
+            haveBGA = true;
+            break;
+        case 8: // 08: ExBPM
+            pushTiming(ChannelStats::TimingEvent::EXBPM, false);
+            haveBPMChange = true;
+            break;
+        case 9: // 09: Stop
+            pushTiming(ChannelStats::TimingEvent::STOP, false);
+            haveStop = true;
+            break;
+        default: break;
+        }
+        return;
+    }
 
-        // 11	12	13	14	15	18	19	16	17	not known or well known
-        std::swap(chNotesRegular[6], chNotesRegular[8]);
-        std::swap(chNotesRegular[7], chNotesRegular[9]);
-        std::swap(chNotesInvisible[6], chNotesInvisible[8]);
-        std::swap(chNotesInvisible[7], chNotesInvisible[9]);
-        std::swap(chNotesLN[6], chNotesLN[8]);
-        std::swap(chNotesLN[7], chNotesLN[9]);
-        std::swap(chMines[6], chMines[8]);
-        std::swap(chMines[7], chMines[9]);
-        have67 = true;
-        have67_2 = false;
-        have89 = true;
-        have89_2 = false;
-        haveAny_2 = false;
-        if (have67_2)
+    // #xxxX7 lanes are not supported
+    if (!isPMS && _y == 7)
+        return;
+
+    auto [side, idx] = isPMS ? getLaneIndexPMS(x_, _y) : getLaneIndexBME(x_, _y);
+    if (side < 0)
+        return;
+    const unsigned chIdx = idx + (side == 1 ? 10 : 0);
+
+    auto scanObjects = [&](auto&& fn) {
+        forEachObject(value, false, [&](unsigned segment, unsigned resolution, unsigned v) {
+            stats.lastObjectBar[chIdx] = std::max(stats.lastObjectBar[chIdx], static_cast<int>(bar));
+            fn(segment, resolution, v);
+        });
+    };
+    auto addRegularNotes = [&](bool ln) {
+        scanObjects([&](unsigned segment, unsigned resolution, unsigned v) {
+            ++stats.regularCount[chIdx];
+            if (chIdx < stats.regularNotes.size())
+                stats.regularNotes[chIdx].push_back({bar, segment, resolution, v, ln});
+        });
+    };
+
+    switch (x_)
+    {
+    case 1: // 1x: 1P visible
+    case 2: // 2x: 2P visible
+        addRegularNotes(false);
+        haveNote = true;
+        if (side == 1)
+            haveAny_2 = true;
+        break;
+    case 3: // 3x: 1P invisible
+    case 4: // 4x: 2P invisible
+        scanObjects([](unsigned, unsigned, unsigned) {});
+        haveInvisible = true;
+        if (side == 1)
+            haveAny_2 = true;
+        break;
+    case 5: // 5x: 1P LN
+    case 6: // 6x: 2P LN
+        haveLNchannels = true;
+        if (!lnobjSet.empty())
         {
-            // 21	22	23	24	25	28	29	26	27	2P-side (right)
-            LOG_DEBUG << "[BMS] 18KEYS is not supported, parsing as 9KEYS";
-            std::swap(chNotesRegular[16], chNotesRegular[18]);
-            std::swap(chNotesRegular[17], chNotesRegular[19]);
-            std::swap(chNotesInvisible[16], chNotesInvisible[18]);
-            std::swap(chNotesInvisible[17], chNotesInvisible[19]);
-            std::swap(chNotesLN[16], chNotesLN[18]);
-            std::swap(chNotesLN[17], chNotesLN[19]);
-            std::swap(chMines[16], chMines[18]);
-            std::swap(chMines[17], chMines[19]);
+            addRegularNotes(true);
+        }
+        else
+        {
+            scanObjects([&](unsigned, unsigned, unsigned) { ++stats.lnCount[chIdx]; });
+            haveLN = true;
+            if (side == 1)
+                haveAny_2 = true;
+        }
+        break;
+    case 0xD: // Dx: 1P mine
+    case 0xE: // Ex: 2P mine
+        scanObjects([&](unsigned, unsigned, unsigned) { ++stats.mineCount; });
+        haveMine = true;
+        break;
+    default: break;
+    }
+
+    switch (idx)
+    {
+    case 6:
+    case 7:
+        if (side == 1)
             have67_2 = true;
+        else
+            have67 = true;
+        break;
+    case 8:
+    case 9:
+        if (side == 1)
+            have89_2 = true;
+        else
+            have89 = true;
+        break;
+    }
+}
+
+void ChartFormatBMS::collectScanStatistics()
+{
+    auto& stats = *channelStats;
+
+    // pick LNs out of notes for each lane, pairing the same way as collectNoteStatistics
+    if (!lnobjSet.empty() || haveLNchannels)
+    {
+        for (unsigned chIdx = 0; chIdx < stats.regularNotes.size(); ++chIdx)
+        {
+            auto& notes = stats.regularNotes[chIdx];
+            std::stable_sort(notes.begin(), notes.end(), isEarlierPosition<ChannelStats::Note>);
+
+            const ChannelStats::Note* head = nullptr;
+            for (const auto& note : notes)
+            {
+                if (head != nullptr && (lnobjSet.count(note.value) || head->ln))
+                {
+                    ++stats.lnPairCount[chIdx];
+                    haveLN = true;
+                    head = nullptr;
+                }
+                else
+                {
+                    head = &note;
+                }
+            }
         }
+    }
 
-        // 11	12	13	14	15	22	23	24	25	standard PMS
-        auto imbue = [](LaneMap& lhs, LaneMap& rhs) {
-            if (lhs.empty())
-                std::swap(lhs, rhs);
-            for (auto& [k, rv] : rhs)
-                lhs[k].imbue(rv);
-        };
-        imbue(chNotesRegular[6], chNotesRegular[12]);
-        imbue(chNotesRegular[7], chNotesRegular[13]);
-        imbue(chNotesRegular[8], chNotesRegular[14]);
-        imbue(chNotesRegular[9], chNotesRegular[15]);
-        imbue(chNotesInvisible[6], chNotesInvisible[12]);
-        imbue(chNotesInvisible[7], chNotesInvisible[13]);
-        imbue(chNotesInvisible[8], chNotesInvisible[14]);
-        imbue(chNotesInvisible[9], chNotesInvisible[15]);
-        imbue(chNotesLN[6], chNotesLN[12]);
-        imbue(chNotesLN[7], chNotesLN[13]);
-        imbue(chNotesLN[8], chNotesLN[14]);
-        imbue(chNotesLN[9], chNotesLN[15]);
-        imbue(chMines[6], chMines[12]);
-        imbue(chMines[7], chMines[13]);
-        imbue(chMines[8], chMines[14]);
-        imbue(chMines[9], chMines[15]);
+    // Get statistics
+    if (haveNote)
+    {
+        for (unsigned lane = 0; lane < ChannelStats::LANE_COUNT; ++lane)
+        {
+            const unsigned long count = stats.regularCount[lane] - stats.lnPairCount[lane] * 2;
+            if (lane == 0 || lane == 10)
+                notes_scratch += count;
+            else
+                notes_key += count;
+        }
+        notes_total += notes_scratch + notes_key;
     }
-    else
+
+    if (haveLN)
     {
-        player = (have67_2 || haveAny_2) ? 3 : 1;
-        if (have67 || have67_2)
+        for (unsigned lane = 0; lane < ChannelStats::LANE_COUNT; ++lane)
         {
-            gamemode = (player == 1 ? 7 : 14);
+            const unsigned long count = stats.lnCount[lane] + stats.lnPairCount[lane] * 2;
+            if (lane == 0 || lane == 10)
+                notes_scratch_ln += count;
+            else
+                notes_key_ln += count;
         }
-        else
+        notes_scratch_ln /= 2;
+        notes_key_ln /= 2;
+
+        notes_total += notes_scratch_ln + notes_key_ln;
+    }
+
+    if (haveMine)
+        notes_mine = stats.mineCount;
+
+    minBPM = bpm;
+    maxBPM = bpm;
+    startBPM = bpm;
+    if (haveBPMChange)
+    {
+        for (const auto& e : stats.timing)
         {
-            gamemode = (player == 1 ? 5 : 10);
+            double value;
+            if (e.type == ChannelStats::TimingEvent::BPM)
+                value = e.value;
+            else if (e.type == ChannelStats::TimingEvent::EXBPM)
+                value = exBPM[e.value];
+            else
+                continue;
+            if (value > maxBPM)
+                maxBPM = value;
+            if (value < minBPM)
+                minBPM = value;
         }
     }
 
-    fileHash = md5file(absolutePath);
-    LOG_INFO << "[BMS] File (" << getFileEncodingName(encoding) << "): " << absolutePath
-             << " MD5: " << fileHash.hexdigest();
+    totalNotes = static_cast<int>(notes_total);
+}
 
-    loaded = true;
+// Mirrors the timeline calculation of ChartObjectBMS::loadBMS at normal speed, without BGA objects.
+void ChartFormatBMS::scanTotalLength()
+{
+    using lunaticvibes::Time;
+    auto& stats = *channelStats;
+
+    // lanes ChartObjectBMS loads notes from, after the PMS lane merge
+    auto isLoadedLane = [this](unsigned chIdx) {
+        if (chIdx < 10)
+            return true;
+        if (isPMS)
+            return chIdx >= 12 && chIdx < 16;
+        return player != 1 && chIdx < 20;
+    };
+    int lastEventBar = stats.lastBgmBar;
+    for (unsigned chIdx = 0; chIdx < ChannelStats::LANE_COUNT; ++chIdx)
+    {
+        if (isLoadedLane(chIdx))
+            lastEventBar = std::max(lastEventBar, stats.lastObjectBar[chIdx]);
+    }
 
-    return 0;
+    std::stable_sort(stats.timing.begin(), stats.timing.end(),
+                     [](const ChannelStats::TimingEvent& lhs, const ChannelStats::TimingEvent& rhs) {
+                         if (isEarlierPosition(lhs, rhs))
+                             return true;
+                         if (isEarlierPosition(rhs, lhs))
+                             return false;
+                         return lhs.type < rhs.type;
+                     });
+
+    std::vector<Time> barTimestamp;
+    barTimestamp.reserve(lastBarIdx + 1);
+    Time basetime{0};
+    BPM currentBPM = startBPM;
+    bool bpmfucked = false;
+    auto itEvent = stats.timing.begin();
+    for (unsigned m = 0; m <= lastBarIdx; m++)
+    {
+        barTimestamp.push_back(basetime);
+
+        Segment lastBPMChangedSegment(0, 1);
+        Metre barMetre = metres[m];
+        Time beatLength = Time::singleBeatLengthFromBPM(currentBPM);
+        for (; itEvent != stats.timing.end() && itEvent->bar == m; ++itEvent)
+        {
+            if (bpmfucked)
+                continue;
+
+            const Segment noteSegment(itEvent->segment, itEvent->resolution);
+            double metreFromBPMChange = (noteSegment - lastBPMChangedSegment) * barMetre;
+            Time notetime = basetime + beatLength * (metreFromBPMChange * 4);
+
+            switch (itEvent->type)
+            {
+            case ChannelStats::TimingEvent::BPM:
+            case ChannelStats::TimingEvent::EXBPM: {
+                const BPM value = itEvent->type == ChannelStats::TimingEvent::BPM ? static_cast<BPM>(itEvent->value)
+                                                                                 : exBPM[itEvent->value];
+                if (currentBPM == value)
+                    break;
+                lastEventBar = std::max(lastEventBar, static_cast<int>(m));
+                basetime = notetime;
+                lastBPMChangedSegment = noteSegment;
+                currentBPM = value;
+                beatLength = Time::singleBeatLengthFromBPM(currentBPM);
+                if (currentBPM <= 0)
+                    bpmfucked = true;
+                break;
+            }
+            case ChannelStats::TimingEvent::STOP: {
+                lastEventBar = std::max(lastEventBar, static_cast<int>(m));
+                double noteStopMetre = stop[itEvent->value] / 192.0;
+                if (noteStopMetre <= 0)
+                    break;
+                basetime += Time{(long long)std::floor(beatLength.hres() * noteStopMetre * 4), true};
+                break;
+            }
+            }
+        }
+        basetime += beatLength * (1.0 - lastBPMChangedSegment) * barMetre.toDouble() * 4;
+    }
+
+    // ChartObjectBMS keeps lastBarIdx when no object is found at all
+    const size_t lastBar = lastEventBar < 0 ? lastBarIdx : static_cast<size_t>(lastEventBar);
+    // last measure + 1
+    const long long lastBeat = Time::singleBeatLengthFromBPM(currentBPM).hres() * 4;
+    const Time length = lastBar + 1 < barTimestamp.size()
+                            ? barTimestamp[lastBar + 1]
+                            : basetime + Time(std::min(2000'000'000ll, std::max(500'000'000ll, lastBeat)), true);
+    totalLength = static_cast<int>(length.norm() / 1000);
 }
 
 int ChartFormatBMS::seqToLane36(channel& ch, StringContentView str, unsigned flags)
@@ -1104,6 +1532,6 @@ void ChartFormatBMS::channel::imbue(channel& c)
 
 void ChartFormatBMS::channel::sortNotes()
 {
-    // NOTE: stable_sort
-    notes.sort([](const NoteParseValue& lhs, const NoteParseValue& rhs) { return lhs.segment < rhs.segment; });
+    std::stable_sort(notes.begin(), notes.end(),
+                     [](const NoteParseValue& lhs, const NoteParseValue& rhs) { return lhs.segment < rhs.segment; });
 }
@@ -1,10 +1,11 @@
 #pragma once
 
 #include <array>
-#include <list>
 #include <map>
+#include <memory>
 #include <optional>
 #include <set>
+#include <vector>
 
 #include "chartformat.h"
 #include "common/types.h"
@@ -116,12 +117,31 @@ class ChartFormatBMS : public ChartFormatBMSMeta
     friend class SongDB;
 
 public:
+    // How the file is read before tokenizing.
+    enum class ParseMode
+    {
+        // Map the file and tokenize lines in place. Files that cannot be mapped are read as with Stream.
+        Mapped,
+        // Read the file into a buffer first. Kept as a reference.
+        Stream,
+    };
+
     ChartFormatBMS();
-    ChartFormatBMS(const Path& absolutePath, uint64_t randomSeed = 0);
-    ~ChartFormatBMS() override = default;
+    ChartFormatBMS(const Path& absolutePath, uint64_t randomSeed = 0, ParseMode mode = ParseMode::Mapped);
+    ~ChartFormatBMS() override;
 
 protected:
-    int initWithFile(const Path& absolutePath, uint64_t randomSeed = 0);
+    int initWithFile(const Path& absolutePath, uint64_t randomSeed = 0, ParseMode mode = ParseMode::Mapped);
+
+    // Pair LNs and count notes from the parsed lanes.
+    void collectNoteStatistics();
+
+    // Set while scanning for ChartFormatBMSMetaScan. Channel lines are only counted then, lanes stay empty.
+    struct ChannelStats;
+    std::unique_ptr<ChannelStats> channelStats;
+    void scanChannel(unsigned bar, int x_, int _y, StringContentView value);
+    void collectScanStatistics();
+    void scanTotalLength();
 
 protected:
     ErrorCode errorCode = ErrorCode::OK;
@@ -141,7 +161,7 @@ public:
             };
             unsigned flags;
         };
-        std::list<NoteParseValue> notes{};
+        std::vector<NoteParseValue> notes{};
         unsigned resolution = 1;
 
         unsigned relax(unsigned target_resolution);
@@ -187,3 +207,13 @@ public:
 public:
     auto getLane(LaneCode, unsigned chIdx, unsigned measureIdx) const -> const channel&;
 };
+
+// Header and statistics only, for filling the song database.
+// Note channels are counted while tokenizing instead of being stored, so getLane() returns empty channels.
+// totalLength and totalNotes are filled the same way ChartObjectBMS would compute them, without BGA.
+class ChartFormatBMSMetaScan : public ChartFormatBMS
+{
+public:
+    ChartFormatBMSMetaScan(const Path& absolutePath, uint64_t randomSeed = 0);
+    ~ChartFormatBMSMetaScan() override = default;
+};
@@ -0,0 +1,91 @@
+#include "dir_index.h"
+
+#include <utility>
+
+#include "common/u8.h"
+#include "common/utils.h"
+
+namespace lunaticvibes
+{
+
+DirectoryIndex::DirectoryIndex(Path root) : _root(std::move(root)) {}
+
+const DirectoryIndex::Listing& DirectoryIndex::list(const std::string& relativeDir)
+{
+    if (auto it = _dirs.find(relativeDir); it != _dirs.end())
+        return it->second;
+
+    Listing& l = _dirs[relativeDir];
+    std::error_code ec;
+    for (fs::directory_iterator it(relativeDir.empty() ? _root : _root / PathFromUTF8(relativeDir), ec), end;
+         !ec && it != end; it.increment(ec))
+    {
+        std::string name{s(it->path().filename().u8string())};
+        std::string key = toLower(name);
+        std::error_code ec2;
+        if (it->is_directory(ec2))
+            l.subdirs.emplace(std::move(key), std::move(name));
+        else if (it->is_regular_file(ec2))
+            l.files.emplace(std::move(key), std::move(name));
+    }
+    return l;
+}
+
+Path DirectoryIndex::resolve(std::string_view relativeUtf8, std::span<const std::string_view> fallbackExtensions)
+{
+    std::vector<std::string_view> segments;
+    for (size_t begin = 0; begin <= relativeUtf8.size();)
+    {
+        size_t end = relativeUtf8.find_first_of("/\\", begin);
+        if (end == relativeUtf8.npos)
+            end = relativeUtf8.size();
+        auto segment = relativeUtf8.substr(begin, end - begin);
+        if (segment == "..")
+        {
+            // leaves the indexed tree, check the filesystem directly
+            std::error_code ec;
+            Path p = _root / PathFromUTF8(relativeUtf8);
+            return fs::is_regular_file(p, ec) ? p : Path{};
+        }
+        if (!segment.empty() && segment != ".")
+            segments.push_back(segment);
+        begin = end + 1;
+    }
+    if (segments.empty())
+        return {};
+
+    std::string dir;
+    for (size_t i = 0; i + 1 < segments.size(); ++i)
+    {
+        const auto& subdirs = list(dir).subdirs;
+        auto it = subdirs.find(toLower(segments[i]));
+        if (it == subdirs.end())
+            return {};
+        if (!dir.empty())
+            dir += '/';
+        dir += it->second;
+    }
+
+    const auto& files = list(dir).files;
+    const auto found = [&](const std::string& name) {
+        return _root / PathFromUTF8(dir.empty() ? name : dir + '/' + name);
+    };
+
+    std::string key = toLower(segments.back());
+    if (auto it = files.find(key); it != files.end())
+        return found(it->second);
+
+    if (auto dot = key.rfind('.'); dot != key.npos)
+        key.resize(dot);
+    const size_t stemLength = key.size();
+    for (const auto& ext : fallbackExtensions)
+    {
+        key.resize(stemLength);
+        key += toLower(ext);
+        if (auto it = files.find(key); it != files.end())
+            return found(it->second);
+    }
+    return {};
+}
+
+} // namespace lunaticvibes
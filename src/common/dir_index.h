@@ -0,0 +1,43 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "common/types.h"
+
+namespace lunaticvibes
+{
+
+// Case-insensitive lookup of files below a root directory.
+// Each directory is listed once on first use; later lookups do not touch the filesystem. Meant for resolving all
+// resources of a chart in one pass, where the chart refers to files with Windows paths and arbitrary case.
+// Not thread-safe.
+class DirectoryIndex
+{
+public:
+    explicit DirectoryIndex(Path root);
+
+    // Resolve a path relative to the root. Both '/' and '\\' are accepted as separators.
+    // If the file does not exist, files with the same stem and one of fallbackExtensions (e.g. ".ogg") are tried in
+    // the given order. Returns an empty path if nothing matched.
+    [[nodiscard]] Path resolve(std::string_view relativeUtf8, std::span<const std::string_view> fallbackExtensions = {});
+
+    [[nodiscard]] const Path& root() const { return _root; }
+    [[nodiscard]] size_t directoriesListed() const { return _dirs.size(); }
+
+private:
+    struct Listing
+    {
+        std::unordered_map<std::string, std::string> files;   // lowercase name -> name on disk
+        std::unordered_map<std::string, std::string> subdirs; // lowercase name -> name on disk
+    };
+    const Listing& list(const std::string& relativeDir);
+
+    Path _root;
+    std::unordered_map<std::string, Listing> _dirs; // keyed by on-disk relative path, "" for root
+};
+
+} // namespace lunaticvibes
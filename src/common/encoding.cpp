@@ -1,9 +1,11 @@
 #include "encoding.h"
 
+#include <algorithm>
 #include <fstream>
 #include <istream>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -147,6 +149,28 @@ eFileEncoding getFileEncoding(const Path& path)
     return getFileEncoding(fs);
 }
 
+// Encoding of a single line, or nothing if the line does not tell.
+static std::optional<eFileEncoding> detect_line_encoding(const std::string_view line)
+{
+    if (is_ascii(line))
+        return std::nullopt;
+    if (is_utf8(line))
+        return eFileEncoding::UTF8;
+    if (is_euckr(line))
+        return eFileEncoding::EUC_KR;
+    if (is_shiftjis(line))
+        return eFileEncoding::SHIFT_JIS;
+    return std::nullopt;
+}
+
+static void warn_on_rare_encoding(const eFileEncoding enc)
+{
+    if (enc == eFileEncoding::EUC_KR)
+    {
+        LOG_WARNING << "beep, boop, detected EUC-KR encoding (rare occurrence)";
+    }
+}
+
 eFileEncoding getFileEncoding(std::istream& is)
 {
     std::streampos oldPos = is.tellg();
@@ -154,26 +178,12 @@ eFileEncoding getFileEncoding(std::istream& is)
     is.clear();
     is.seekg(0);
 
-    std::string buf;
     eFileEncoding enc = eFileEncoding::LATIN1;
     for (std::string buf; std::getline(is, buf);)
     {
-        if (is_ascii(buf))
-            continue;
-
-        if (is_utf8(buf))
-        {
-            enc = eFileEncoding::UTF8;
-            break;
-        }
-        if (is_euckr(buf))
+        if (auto lineEnc = detect_line_encoding(buf))
         {
-            enc = eFileEncoding::EUC_KR;
-            break;
-        }
-        if (is_shiftjis(buf))
-        {
-            enc = eFileEncoding::SHIFT_JIS;
+            enc = *lineEnc;
             break;
         }
     }
@@ -181,11 +191,27 @@ eFileEncoding getFileEncoding(std::istream& is)
     is.clear();
     is.seekg(oldPos);
 
-    if (enc == eFileEncoding::EUC_KR)
+    warn_on_rare_encoding(enc);
+
+    return enc;
+}
+
+eFileEncoding getBufferEncoding(const std::string_view content)
+{
+    eFileEncoding enc = eFileEncoding::LATIN1;
+    for (size_t lineStart = 0; lineStart < content.size();)
     {
-        LOG_WARNING << "beep, boop, detected EUC-KR encoding (rare occurrence)";
+        const size_t lineEnd = std::min(content.find('\n', lineStart), content.size());
+        if (auto lineEnc = detect_line_encoding(content.substr(lineStart, lineEnd - lineStart)))
+        {
+            enc = *lineEnc;
+            break;
+        }
+        lineStart = lineEnd + 1;
     }
 
+    warn_on_rare_encoding(enc);
+
     return enc;
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 #include <common/types.h>
 
@@ -13,6 +14,8 @@ enum class eFileEncoding : uint8_t
 };
 [[nodiscard]] eFileEncoding getFileEncoding(const Path& path);
 [[nodiscard]] eFileEncoding getFileEncoding(std::istream& is);
+// Same as getFileEncoding, for file contents already in memory.
+[[nodiscard]] eFileEncoding getBufferEncoding(std::string_view content);
 [[nodiscard]] const char* getFileEncodingName(eFileEncoding enc);
 
 [[nodiscard]] std::string to_utf8(const std::string& str, eFileEncoding fromEncoding);
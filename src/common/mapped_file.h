@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "common/types.h"
+
+namespace lunaticvibes
+{
+
+// Read-only memory mapping of a whole file.
+// Contents stay valid until the object is destroyed. Empty files are opened successfully with an empty view.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const Path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const Path& path);
+    void close();
+
+    [[nodiscard]] bool is_open() const { return _opened; }
+    [[nodiscard]] const char* data() const { return _data; }
+    [[nodiscard]] size_t size() const { return _size; }
+    [[nodiscard]] std::string_view view() const { return {_data, _size}; }
+
+private:
+    const char* _data = nullptr;
+    size_t _size = 0;
+    bool _opened = false;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#endif
+};
+
+} // namespace lunaticvibes
@@ -1,5 +1,6 @@
 #include "sysutil.h"
 
+#include <chrono>
 #include <queue>
 #include <shared_mutex>
 
@@ -10,6 +11,9 @@
 
 std::shared_mutex mainThreadTaskQueueMutex;
 std::queue<std::function<void()>> mainThreadTaskQueue;
+std::queue<std::function<void()>> mainThreadDeferredTaskQueue;
+static thread_local bool t_mainThreadTasksDeferred = false;
+static constexpr std::chrono::microseconds MAIN_THREAD_DEFERRED_TASK_BUDGET{3000};
 bool handleMainThreadTask = true;
 
 static bool s_foreground = true;
@@ -35,12 +39,20 @@ void pushMainThreadTask(std::function<void()> f)
         if (handleMainThreadTask)
         {
             std::unique_lock l(mainThreadTaskQueueMutex);
-            mainThreadTaskQueue.push(std::move(f));
+            if (t_mainThreadTasksDeferred)
+                mainThreadDeferredTaskQueue.push(std::move(f));
+            else
+                mainThreadTaskQueue.push(std::move(f));
         }
     }
 }
 
-void doMainThreadTask()
+void SetThreadMainThreadTasksDeferred(bool deferred)
+{
+    t_mainThreadTasksDeferred = deferred;
+}
+
+void doMainThreadTask(bool drainDeferred)
 {
     std::shared_lock l(mainThreadTaskQueueMutex);
     while (!mainThreadTaskQueue.empty())
@@ -48,6 +60,13 @@ void doMainThreadTask()
         mainThreadTaskQueue.front()();
         mainThreadTaskQueue.pop();
     }
+
+    const auto deadline = std::chrono::steady_clock::now() + MAIN_THREAD_DEFERRED_TASK_BUDGET;
+    while (!mainThreadDeferredTaskQueue.empty() && (drainDeferred || std::chrono::steady_clock::now() < deadline))
+    {
+        mainThreadDeferredTaskQueue.front()();
+        mainThreadDeferredTaskQueue.pop();
+    }
 }
 
 void StopHandleMainThreadTask()
@@ -23,7 +23,10 @@ bool IsWindowForeground();
 void SetWindowForeground(bool foreground);
 
 void pushMainThreadTask(std::function<void()> f);
-void doMainThreadTask();
+// Tasks pushed from a thread marked as deferred (background loaders) only get a few milliseconds of each
+// doMainThreadTask() call, after the other tasks, so they do not stall frames.
+void SetThreadMainThreadTasksDeferred(bool deferred);
+void doMainThreadTask(bool drainDeferred = false);
 void StopHandleMainThreadTask();
 bool CanHandleMainThreadTask();
 
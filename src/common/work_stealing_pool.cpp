@@ -0,0 +1,173 @@
+#include "work_stealing_pool.h"
+
+#include <exception>
+#include <utility>
+
+#include "common/log.h"
+#include "common/sysutil.h"
+
+namespace lunaticvibes
+{
+
+namespace
+{
+// Set on worker threads, so tasks can post into their own queue.
+thread_local const WorkStealingPool* tlsPool = nullptr;
+thread_local unsigned tlsQueueIndex = 0;
+} // namespace
+
+WorkStealingPool::WorkStealingPool(std::string name, unsigned threadCount) : _name(std::move(name))
+{
+    if (threadCount == 0)
+        threadCount = 1;
+
+    _queues.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i)
+        _queues.push_back(std::make_unique<Queue>());
+
+    _threads.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i)
+        _threads.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::unique_lock l(_mutex);
+        _stopping = true;
+    }
+    _taskAvailable.notify_all();
+    for (auto& t : _threads)
+        t.join();
+}
+
+void WorkStealingPool::post(Task task)
+{
+    unsigned index;
+    if (tlsPool == this)
+    {
+        index = tlsQueueIndex;
+    }
+    else
+    {
+        std::unique_lock l(_mutex);
+        index = _nextQueue;
+        _nextQueue = (_nextQueue + 1) % _queues.size();
+    }
+
+    {
+        std::unique_lock l(_queues[index]->mutex);
+        _queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::unique_lock l(_mutex);
+        ++_queued;
+        ++_unfinished;
+    }
+    _taskAvailable.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock l(_mutex);
+    _idle.wait(l, [this] { return _unfinished == 0; });
+}
+
+size_t WorkStealingPool::cancel()
+{
+    // destroyed after unlocking, a task may own anything
+    std::vector<Task> dropped;
+    bool idle = false;
+    {
+        std::unique_lock l(_mutex);
+        // reserved tasks must stay for the workers waiting on them
+        for (auto& q : _queues)
+        {
+            std::unique_lock lq(q->mutex);
+            while (dropped.size() < _queued && !q->tasks.empty())
+            {
+                dropped.push_back(std::move(q->tasks.back()));
+                q->tasks.pop_back();
+            }
+        }
+        _queued -= dropped.size();
+        _unfinished -= dropped.size();
+        idle = _unfinished == 0;
+    }
+    if (idle)
+        _idle.notify_all();
+    return dropped.size();
+}
+
+bool WorkStealingPool::tryTake(unsigned index, Task& task)
+{
+    // own queue, newest first
+    {
+        auto& q = *_queues[index];
+        std::unique_lock l(q.mutex);
+        if (!q.tasks.empty())
+        {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // steal from others, oldest first
+    for (size_t i = 1; i < _queues.size(); ++i)
+    {
+        auto& q = *_queues[(index + i) % _queues.size()];
+        std::unique_lock l(q.mutex);
+        if (!q.tasks.empty())
+        {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(unsigned index)
+{
+    SetThreadName((_name + " " + std::to_string(index)).c_str());
+    tlsPool = this;
+    tlsQueueIndex = index;
+
+    while (true)
+    {
+        {
+            std::unique_lock l(_mutex);
+            _taskAvailable.wait(l, [this] { return _stopping || _queued > 0; });
+            if (_queued == 0)
+                break;
+            // reserve a task, which is in one of the queues until some reserved worker takes it
+            --_queued;
+        }
+
+        Task task;
+        while (!tryTake(index, task))
+            std::this_thread::yield();
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR << "[" << _name << "] Task exception: " << e.what();
+        }
+
+        bool idle = false;
+        {
+            std::unique_lock l(_mutex);
+            idle = --_unfinished == 0;
+        }
+        if (idle)
+            _idle.notify_all();
+    }
+
+    tlsPool = nullptr;
+}
+
+} // namespace lunaticvibes
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lunaticvibes
+{
+
+// Fixed size thread pool with one task queue per worker.
+// Tasks posted from a worker go to its own queue and are taken newest first, so recursive work stays depth-first and
+// local. Idle workers steal the oldest task from other queues.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // threadCount 0 is treated as 1.
+    WorkStealingPool(std::string name, unsigned threadCount);
+    // Runs all queued tasks before returning.
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void post(Task task);
+    // Block until every posted task, including tasks posted by tasks, has finished. Must not be called from a worker.
+    void wait();
+    // Drop tasks which have not started yet. Returns the number of tasks dropped.
+    size_t cancel();
+
+    [[nodiscard]] unsigned threadCount() const { return static_cast<unsigned>(_threads.size()); }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+    std::string _name;
+
+    std::mutex _mutex;
+    std::condition_variable _taskAvailable;
+    std::condition_variable _idle;
+    size_t _queued = 0;     // tasks in queues and not reserved by a worker
+    size_t _unfinished = 0; // tasks posted and not finished
+    bool _stopping = false;
+    unsigned _nextQueue = 0;
+
+    void run(unsigned index);
+    bool tryTake(unsigned index, Task& task);
+};
+
+} // namespace lunaticvibes
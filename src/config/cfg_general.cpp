@@ -12,16 +12,19 @@ void ConfigGeneral::setDefaults() noexcept
     set(A_MODE, A_MODE_AUTO);
     set(A_BUFCOUNT, 4);
     set(A_BUFLEN, 256);
+    set(A_SAMPLE_CACHE_MB, 256);
     set(V_RES_SUPERSAMPLE, 1);
     set(V_DISPLAY_RES_X, CANVAS_WIDTH);
     set(V_DISPLAY_RES_Y, CANVAS_HEIGHT);
     set(V_WINMODE, V_WINMODE_WINDOWED);
     set(V_MAXFPS, 480);
     set(V_VSYNC, 1);
+    set(V_BGA_TEXTURE_BUDGET_MB, 512);
     set(E_PROFILE, PROFILE_DEFAULT);
     set(E_LR2PATH, ".");
     set(E_FOLDERS, std::vector<std::string>());
     set(E_TABLES, std::vector<std::string>());
+    set(E_SCAN_THREADS, 0);
     set(E_LOG_LEVEL, E_LOG_LEVEL_INFO);
 }
 
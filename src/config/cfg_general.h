@@ -51,6 +51,8 @@ constexpr char A_BUFLEN[] = "BufferLength";
 
 constexpr char A_BUFCOUNT[] = "BufferCount";
 
+constexpr char A_SAMPLE_CACHE_MB[] = "SampleCacheSizeMB";
+
 ////////////////////////////////////////////////////////////////////////////////
 // Video
 
@@ -73,12 +75,16 @@ constexpr char V_MAXFPS[] = "MaxFPS";
 
 constexpr char V_VSYNC[] = "VSync";
 
+// Pictures of a BGA over this size are streamed during play instead of all loaded up front. 0 for no limit.
+constexpr char V_BGA_TEXTURE_BUDGET_MB[] = "BGATextureBudgetMB";
+
 ////////////////////////////////////////////////////////////////////////////////
 // etc
 constexpr char E_PROFILE[] = "Profile";
 constexpr char E_LR2PATH[] = "LR2Path";
 constexpr char E_FOLDERS[] = "Folders";
 constexpr char E_TABLES[] = "Tables";
+constexpr char E_SCAN_THREADS[] = "SongScanThreads";
 
 constexpr char E_LOG_LEVEL[] = "LogLevel";
 constexpr char E_LOG_LEVEL_DEBUG[] = "Debug";
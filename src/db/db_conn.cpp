@@ -28,6 +28,13 @@ SQLite::SQLite(const char* path, std::string tag_, SQLite::OpenMode mode) : tag(
 
 SQLite::~SQLite()
 {
+    LOG_DEBUG << "[sqlite3] " << tag << ": statement cache " << _stmtCacheHits << " hits, " << _stmtCacheMisses
+              << " misses";
+    for (auto& entry : _stmtCache)
+    {
+        LVF_DEBUG_ASSERT(!entry.inUse);
+        sqlite3_finalize(entry.stmt);
+    }
     sqlite3_close(_db);
 }
 const char* SQLite::errmsg() const
@@ -121,29 +128,144 @@ void sql_bind_any(sqlite3_stmt* stmt, const std::initializer_list<std::any>& arg
     }
 }
 
-std::vector<std::vector<std::any>> SQLite::query(const std::string_view zsql,
-                                                 std::initializer_list<std::any> args) const
+int SQLiteRow::columnCount() const
+{
+    return sqlite3_column_count(_stmt);
+}
+int SQLiteRow::columnType(int col) const
+{
+    return sqlite3_column_type(_stmt, col);
+}
+bool SQLiteRow::isNull(int col) const
+{
+    return columnType(col) == SQLITE_NULL;
+}
+long long SQLiteRow::getInt(int col) const
+{
+    return sqlite3_column_int64(_stmt, col);
+}
+double SQLiteRow::getReal(int col) const
 {
-    _lastSql = zsql;
+    return sqlite3_column_double(_stmt, col);
+}
+std::string_view SQLiteRow::getText(int col) const
+{
+    const auto* text = reinterpret_cast<const char*>(sqlite3_column_text(_stmt, col));
+    if (text == nullptr)
+        return {};
+    return {text, static_cast<size_t>(sqlite3_column_bytes(_stmt, col))};
+}
+
+SQLite::StatementLease::~StatementLease()
+{
+    if (_stmt != nullptr)
+        _db->releaseStatement(_entry, _stmt);
+}
+
+SQLite::StatementLease SQLite::acquireStatement(std::string_view sql) const
+{
+    std::unique_lock l(_stmtCacheMutex);
+    _lastSql = sql;
+
+    auto it = _stmtCacheIndex.find(sql);
+    if (it != _stmtCacheIndex.end() && !it->second->inUse)
+    {
+        ++_stmtCacheHits;
+        _stmtCache.splice(_stmtCache.begin(), _stmtCache, it->second);
+        it->second->inUse = true;
+        return {this, &*it->second, it->second->stmt};
+    }
+    ++_stmtCacheMisses;
+    const bool cache = it == _stmtCacheIndex.end() && _stmtCacheCapacity > 0;
+    l.unlock();
 
     sqlite3_stmt* stmt = nullptr;
-    int ret = sqlite3_prepare_v3(_db, zsql.data(), static_cast<int>(zsql.size()), 0, &stmt, nullptr);
+    int ret = sqlite3_prepare_v3(_db, sql.data(), static_cast<int>(sql.size()), cache ? SQLITE_PREPARE_PERSISTENT : 0,
+                                 &stmt, nullptr);
     if (ret != 0)
     {
-        LOG_ERROR << "[sqlite3] sql \"" << zsql << "\" prepare error: [" << ret << "] " << errmsg();
-        return {};
+        LOG_ERROR << "[sqlite3] sql \"" << sql << "\" prepare error: [" << ret << "] " << errmsg();
+        sqlite3_finalize(stmt);
+        return {this, nullptr, nullptr};
+    }
+    if (!cache)
+        return {this, nullptr, stmt};
+
+    l.lock();
+    if (_stmtCacheIndex.find(sql) != _stmtCacheIndex.end())
+    {
+        // prepared by another thread meanwhile
+        return {this, nullptr, stmt};
     }
+    auto& entry = _stmtCache.emplace_front(CachedStatement{std::string{sql}, stmt, true});
+    _stmtCacheIndex.emplace(entry.sql, _stmtCache.begin());
+    return {this, &entry, stmt};
+}
+
+void SQLite::releaseStatement(CachedStatement* entry, sqlite3_stmt* stmt) const
+{
+    sqlite3_reset(stmt);
+    if (entry == nullptr)
+    {
+        sqlite3_finalize(stmt);
+        return;
+    }
+    sqlite3_clear_bindings(stmt);
+
+    std::unique_lock l(_stmtCacheMutex);
+    entry->inUse = false;
+    trimStatementCache();
+}
+
+void SQLite::trimStatementCache() const
+{
+    // statements in use are skipped and trimmed on release
+    auto it = _stmtCache.end();
+    size_t count = _stmtCache.size();
+    while (count > _stmtCacheCapacity && it != _stmtCache.begin())
+    {
+        --it;
+        if (it->inUse)
+            continue;
+        _stmtCacheIndex.erase(it->sql);
+        sqlite3_finalize(it->stmt);
+        it = _stmtCache.erase(it);
+        --count;
+    }
+}
+
+SQLite::StatementCacheStats SQLite::getStatementCacheStats() const
+{
+    std::unique_lock l(_stmtCacheMutex);
+    return {_stmtCacheHits, _stmtCacheMisses, _stmtCache.size()};
+}
 
-    const int columnCount = sqlite3_column_count(stmt);
-    if (columnCount == 0)
+void SQLite::setStatementCacheCapacity(size_t capacity)
+{
+    std::unique_lock l(_stmtCacheMutex);
+    _stmtCacheCapacity = capacity;
+    trimStatementCache();
+}
+
+int SQLite::queryEach(const std::string_view zsql, std::initializer_list<std::any> args,
+                      const std::function<void(const SQLiteRow&)>& onRow) const
+{
+    const auto lease = acquireStatement(zsql);
+    sqlite3_stmt* stmt = lease.get();
+    if (stmt == nullptr)
+        return -1;
+
+    if (sqlite3_column_count(stmt) == 0)
     {
         LOG_ERROR << "[sqlite3] Query returns 0 colums";
-        return {};
+        return -1;
     }
 
     sql_bind_any(stmt, args);
 
-    std::vector<std::vector<std::any>> out;
+    const SQLiteRow row(stmt);
+    int rowCount = 0;
+    int ret;
     while (true)
     {
         ret = sqlite3_step(stmt);
@@ -154,24 +276,8 @@ std::vector<std::vector<std::any>> SQLite::query(const std::string_view zsql,
             LOG_ERROR << "[sqlite3] SQL query step failed: " << errmsg();
             break;
         }
-        auto& row = out.emplace_back();
-        row.resize(columnCount);
-        for (int i = 0; i < columnCount; ++i)
-        {
-            const int c = sqlite3_column_type(stmt, i);
-            switch (c)
-            {
-            case SQLITE_INTEGER: row[i] = sqlite3_column_int64(stmt, i); break;
-            case SQLITE_FLOAT: row[i] = sqlite3_column_double(stmt, i); break;
-            case SQLITE_TEXT:
-                row[i] = std::make_any<std::string>(reinterpret_cast<const char*>(sqlite3_column_text(stmt, i)),
-                                                    static_cast<size_t>(sqlite3_column_bytes(stmt, i)));
-                break;
-            case SQLITE_BLOB: LOG_ERROR << "[sqlite3] row[" << i << "]: fetched unsupported type SQLITE_BLOB"; break;
-            case SQLITE_NULL: break; // assume !row[i].has_value()
-            default: LOG_ERROR << "[sqlite3] row[" << i << "]: unknown column type c=" << c; break;
-            }
-        }
+        onRow(row);
+        ++rowCount;
     }
 
 #ifndef NDEBUG
@@ -182,34 +288,52 @@ std::vector<std::vector<std::any>> SQLite::query(const std::string_view zsql,
     {
         ss << any_to_str(a) << ", ";
     }
-    ss << ") result: " << out.size() << " rows";
+    ss << ") result: " << rowCount << " rows";
     LOG_VERBOSE << ss.str();
 #endif
 
-    sqlite3_finalize(stmt);
+    return rowCount;
+}
+
+std::vector<std::vector<std::any>> SQLite::query(const std::string_view zsql,
+                                                 std::initializer_list<std::any> args) const
+{
+    std::vector<std::vector<std::any>> out;
+    queryEach(zsql, args, [&out](const SQLiteRow& r) {
+        const int columnCount = r.columnCount();
+        auto& row = out.emplace_back();
+        row.resize(columnCount);
+        for (int i = 0; i < columnCount; ++i)
+        {
+            const int c = r.columnType(i);
+            switch (c)
+            {
+            case SQLITE_INTEGER: row[i] = r.getInt(i); break;
+            case SQLITE_FLOAT: row[i] = r.getReal(i); break;
+            case SQLITE_TEXT: row[i] = std::make_any<std::string>(r.getText(i)); break;
+            case SQLITE_BLOB: LOG_ERROR << "[sqlite3] row[" << i << "]: fetched unsupported type SQLITE_BLOB"; break;
+            case SQLITE_NULL: break; // assume !row[i].has_value()
+            default: LOG_ERROR << "[sqlite3] row[" << i << "]: unknown column type c=" << c; break;
+            }
+        }
+    });
     return out;
 }
 
 int SQLite::exec(const std::string_view zsql, std::initializer_list<std::any> args)
 {
-    _lastSql = zsql;
-
-    sqlite3_stmt* stmt = nullptr;
-    int ret = sqlite3_prepare_v3(_db, zsql.data(), static_cast<int>(zsql.size()), 0, &stmt, nullptr);
-    if (ret != 0)
-    {
-        LOG_ERROR << "[sqlite3] sql \"" << zsql << "\" prepare error: [" << ret << "] " << errmsg();
-        return ret;
-    }
+    const auto lease = acquireStatement(zsql);
+    sqlite3_stmt* stmt = lease.get();
+    if (stmt == nullptr)
+        return sqlite3_errcode(_db);
 
     sql_bind_any(stmt, args);
 
-    ret = sqlite3_step(stmt);
+    int ret = sqlite3_step(stmt);
 
     if (ret != SQLITE_OK && ret != SQLITE_ROW && ret != SQLITE_DONE)
     {
         LOG_ERROR << "[sqlite3] " << tag << ": " << " exec " << zsql << ": " << errmsg();
-        sqlite3_finalize(stmt);
         return ret;
     }
 
@@ -228,7 +352,6 @@ int SQLite::exec(const std::string_view zsql, std::initializer_list<std::any> ar
         LOG_VERBOSE << ss.str();
 #endif
 
-    sqlite3_finalize(stmt);
     return SQLITE_OK;
 }
 
@@ -1,14 +1,24 @@
 #pragma once
 #include <any>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <common/hash.h>
 #include <common/types.h>
 #include <common/u8.h>
 
 struct sqlite3;
+struct sqlite3_stmt;
 
 #if defined(_MSC_VER)
 typedef __int64 sqlite_int64;
@@ -35,6 +45,70 @@ inline std::string ANY_STR(const std::any& a)
 
 #define SQLITE_OK 0
 
+// One result row of SQLite::queryEach. Columns are read straight from the statement, so the row is only valid inside
+// the callback.
+class SQLiteRow
+{
+private:
+    sqlite3_stmt* _stmt;
+
+    template <typename T> struct is_optional : std::false_type
+    {
+    };
+    template <typename T> struct is_optional<std::optional<T>> : std::true_type
+    {
+    };
+
+public:
+    explicit SQLiteRow(sqlite3_stmt* stmt) : _stmt(stmt) {}
+
+    [[nodiscard]] int columnCount() const;
+    // SQLITE_INTEGER, SQLITE_TEXT etc.
+    [[nodiscard]] int columnType(int col) const;
+    [[nodiscard]] bool isNull(int col) const;
+    [[nodiscard]] long long getInt(int col) const;
+    [[nodiscard]] double getReal(int col) const;
+    // Points into the statement and is invalidated by the next row.
+    [[nodiscard]] std::string_view getText(int col) const;
+
+    // NULL is read as 0 or an empty string. Use std::optional to tell them apart.
+    template <typename T> void read(int col, T& out) const
+    {
+        if constexpr (is_optional<T>::value)
+        {
+            if (isNull(col))
+                out.reset();
+            else
+                read(col, out.emplace());
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+            out = getInt(col) != 0;
+        else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+            out = static_cast<T>(getInt(col));
+        else if constexpr (std::is_floating_point_v<T>)
+            out = static_cast<T>(getReal(col));
+        else if constexpr (std::is_same_v<T, std::string>)
+            out.assign(getText(col)); // keeps the capacity of a reused buffer
+        else if constexpr (std::is_same_v<T, std::string_view>)
+            out = getText(col);
+        else if constexpr (std::is_same_v<T, HashMD5>)
+        {
+            const auto hex = getText(col);
+            out = hex.empty() ? HashMD5{} : HashMD5{hex};
+        }
+        else
+            static_assert(!sizeof(T), "unsupported column type");
+    }
+
+    // Columns [0, sizeof...(Ts)) in order.
+    template <typename... Ts> void readAll(std::tuple<Ts...>& out) const
+    {
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (read(static_cast<int>(I), std::get<I>(out)), ...);
+        }(std::index_sequence_for<Ts...>{});
+    }
+};
+
 class SQLite
 {
 private:
@@ -43,6 +117,45 @@ private:
     std::string tag;
     bool inTransaction = false;
 
+    // Prepared statements of query() and exec(), most recently used first. A statement is owned by one caller at a
+    // time; a second concurrent user of the same SQL text prepares its own copy which is not cached.
+    struct CachedStatement
+    {
+        std::string sql;
+        sqlite3_stmt* stmt = nullptr;
+        bool inUse = false;
+    };
+    mutable std::mutex _stmtCacheMutex;
+    mutable std::list<CachedStatement> _stmtCache;
+    mutable std::unordered_map<std::string_view, std::list<CachedStatement>::iterator> _stmtCacheIndex; // views sql
+    size_t _stmtCacheCapacity = 64;
+    mutable uint64_t _stmtCacheHits = 0;
+    mutable uint64_t _stmtCacheMisses = 0;
+
+    // Statement checked out from the cache, reset and returned on destruction.
+    class StatementLease
+    {
+    private:
+        const SQLite* _db = nullptr;
+        CachedStatement* _entry = nullptr; // null if not cached
+        sqlite3_stmt* _stmt = nullptr;
+
+    public:
+        StatementLease(const SQLite* db, CachedStatement* entry, sqlite3_stmt* stmt)
+            : _db(db), _entry(entry), _stmt(stmt)
+        {
+        }
+        ~StatementLease();
+        StatementLease(const StatementLease&) = delete;
+        StatementLease& operator=(const StatementLease&) = delete;
+
+        [[nodiscard]] sqlite3_stmt* get() const { return _stmt; }
+    };
+    // Returns an empty lease if the SQL fails to prepare.
+    [[nodiscard]] StatementLease acquireStatement(std::string_view sql) const;
+    void releaseStatement(CachedStatement* entry, sqlite3_stmt* stmt) const;
+    void trimStatementCache() const;
+
 public:
     enum class OpenMode
     {
@@ -64,6 +177,22 @@ public:
 protected:
     [[nodiscard]] std::vector<std::vector<std::any>> query(std::string_view stmt,
                                                            std::initializer_list<std::any> args = {}) const;
+    // Call onRow for each result row without copying the columns.
+    // Returns the number of rows, or -1 on error.
+    int queryEach(std::string_view stmt, std::initializer_list<std::any> args,
+                  const std::function<void(const SQLiteRow&)>& onRow) const;
+    // Decode each row into Columns and call onRow(Columns&...). The columns are reused between rows, so strings keep
+    // their buffers; move from them to keep the value.
+    // Returns the number of rows, or -1 on error.
+    template <typename... Columns, typename F>
+    int queryAs(std::string_view stmt, std::initializer_list<std::any> args, F&& onRow) const
+    {
+        std::tuple<Columns...> row;
+        return queryEach(stmt, args, [&](const SQLiteRow& r) {
+            r.readAll(row);
+            std::apply(onRow, row);
+        });
+    }
     int exec(std::string_view stmt, std::initializer_list<std::any> args = {});
 
     // Subsequent calls with same 'name' are no-op.
@@ -83,4 +212,14 @@ public:
 
     void optimize();
     [[nodiscard]] const char* errmsg() const;
+
+    struct StatementCacheStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t size = 0;
+    };
+    [[nodiscard]] StatementCacheStats getStatementCacheStats() const;
+    // Maximum number of idle prepared statements kept. 0 disables the cache.
+    void setStatementCacheCapacity(size_t capacity);
 };
@@ -17,38 +17,71 @@
 #include <common/assert.h>
 #include <db/db_lr2_score.h>
 
-bool convert_score_bms(ScoreBMS& out, const std::vector<std::any>& in)
+static constexpr char HISTORY_SCORE_BMS_COLUMNS[] =
+    "md5,notes,score,fast,slow,maxcombo,addtime,exscore,lamp,pgreat,great,good,bad,bpoor,miss,bp,cb,playedtime,replay";
+
+// Row of "SELECT * FROM score_bms" or score_course_bms.
+bool convert_score_bms(ScoreBMS& out, const SQLiteRow& in)
 {
-    static constexpr size_t SCORE_BMS_PARAM_COUNT = 21;
-    if (in.size() < SCORE_BMS_PARAM_COUNT)
+    static constexpr int SCORE_BMS_PARAM_COUNT = 21;
+    if (in.columnCount() < SCORE_BMS_PARAM_COUNT)
         return false;
 
-    // md5 = ANY_STR(in.at(0));
-    out.notes = ANY_INT(in.at(1));
-    out.score = ANY_INT(in.at(2));
-    out.rate = ANY_REAL(in.at(3));
-    out.fast = ANY_INT(in.at(4));
-    out.slow = ANY_INT(in.at(5));
-    out.maxcombo = ANY_INT(in.at(6));
-    out.addtime = ANY_INT(in.at(7));
-    out.playcount = ANY_INT(in.at(8));
-    out.clearcount = ANY_INT(in.at(9));
-    out.exscore = ANY_INT(in.at(10));
-    out.lamp = static_cast<ScoreBMS::Lamp>(ANY_INT(in.at(11)));
-    out.pgreat = ANY_INT(in.at(12));
-    out.great = ANY_INT(in.at(13));
-    out.good = ANY_INT(in.at(14));
-    out.bad = ANY_INT(in.at(15));
-    out.kpoor = ANY_INT(in.at(16));
-    out.miss = ANY_INT(in.at(17));
-    out.bp = ANY_INT(in.at(18));
-    out.combobreak = ANY_INT(in.at(19));
-    out.replayFileName = ANY_STR(in.at(20));
+    // md5 = in.getText(0);
+    in.read(1, out.notes);
+    in.read(2, out.score);
+    in.read(3, out.rate);
+    in.read(4, out.fast);
+    in.read(5, out.slow);
+    in.read(6, out.maxcombo);
+    in.read(7, out.addtime);
+    in.read(8, out.playcount);
+    in.read(9, out.clearcount);
+    in.read(10, out.exscore);
+    in.read(11, out.lamp);
+    in.read(12, out.pgreat);
+    in.read(13, out.great);
+    in.read(14, out.good);
+    in.read(15, out.bad);
+    in.read(16, out.kpoor);
+    in.read(17, out.miss);
+    in.read(18, out.bp);
+    in.read(19, out.combobreak);
+    in.read(20, out.replayFileName);
 
     out.play_time = lunaticvibes::Time{0};
     return true;
 }
 
+// Columns of HISTORY_SCORE_BMS_COLUMNS from score_history_bms or score_cache_bms.
+static bool convertHistoryScoreBms(ScoreBMS& out, const SQLiteRow& score)
+{
+    if (score.columnCount() < 19)
+        return false;
+    // md5 = score.getText(0);
+    score.read(1, out.notes);
+    score.read(2, out.score);
+    score.read(3, out.fast);
+    score.read(4, out.slow);
+    score.read(5, out.maxcombo);
+    score.read(6, out.addtime);
+    score.read(7, out.exscore);
+    score.read(8, out.lamp);
+    score.read(9, out.pgreat);
+    score.read(10, out.great);
+    score.read(11, out.good);
+    score.read(12, out.bad);
+    score.read(13, out.kpoor);
+    score.read(14, out.miss);
+    score.read(15, out.bp);
+    score.read(16, out.combobreak);
+    out.play_time = score.getInt(17);
+    score.read(18, out.replayFileName);
+
+    out.rate = static_cast<double>(out.exscore) / static_cast<double>(out.notes * 2) * 100;
+    return true;
+}
+
 ScoreDB::ScoreDB(const char* path) : SQLite(path, "SCORE")
 {
     initTables();
@@ -155,11 +188,10 @@ void ScoreDB::updateLegacyScoreBMS(const char* tableName, const HashMD5& hash, c
 
     char sqlbuf[96] = {0};
     sprintf(sqlbuf, "SELECT * FROM %s WHERE md5=?", tableName);
-    auto result = query(sqlbuf, {hashStr});
-    LVF_DEBUG_ASSERT(!result.empty());
-    const auto& r = result[0];
     auto scoreRefetched = std::make_shared<ScoreBMS>();
-    convert_score_bms(*scoreRefetched, r);
+    [[maybe_unused]] const int rows =
+        queryEach(sqlbuf, {hashStr}, [&](const SQLiteRow& r) { convert_score_bms(*scoreRefetched, r); });
+    LVF_DEBUG_ASSERT(rows == 1);
     cache[tableName].insert_or_assign(hashStr, std::move(scoreRefetched));
 }
 
@@ -208,36 +240,13 @@ std::vector<std::pair<HashMD5, ScoreBMS>> ScoreDB::fetchCachedPbBMSImpl(const st
                                                                         std::initializer_list<std::any> params) const
 {
     std::vector<std::pair<HashMD5, ScoreBMS>> out;
-    const auto raw_scores = query("SELECT md5, notes, score, fast, slow, maxcombo, addtime, exscore, lamp, pgreat, "
-                                  "great, good, bad, bpoor, miss, bp, cb, playedtime, replay FROM score_cache_bms " +
-                                      sql_where,
-                                  params);
-    for (const auto& raw_score : raw_scores)
-    {
-        LVF_DEBUG_ASSERT(raw_score.size() == 19);
-
-        ScoreBMS score;
-        score.notes = ANY_INT(raw_score[1]);
-        score.score = ANY_INT(raw_score[2]);
-        score.fast = ANY_INT(raw_score[3]);
-        score.slow = ANY_INT(raw_score[4]);
-        score.maxcombo = ANY_INT(raw_score[5]);
-        score.addtime = ANY_INT(raw_score[6]);
-        score.exscore = ANY_INT(raw_score[7]);
-        score.lamp = static_cast<ScoreBMS::Lamp>(ANY_INT(raw_score[8]));
-        score.pgreat = ANY_INT(raw_score[9]);
-        score.great = ANY_INT(raw_score[10]);
-        score.good = ANY_INT(raw_score[11]);
-        score.bad = ANY_INT(raw_score[12]);
-        score.kpoor = ANY_INT(raw_score[13]);
-        score.miss = ANY_INT(raw_score[14]);
-        score.bp = ANY_INT(raw_score[15]);
-        score.combobreak = ANY_INT(raw_score[16]);
-        score.play_time = ANY_INT(raw_score[17]);
-        score.replayFileName = ANY_STR(raw_score[18]);
-        score.rate = calculate_rate(score.exscore, score.notes);
-        out.emplace_back(ANY_STR(raw_score[0]), std::move(score));
-    }
+    queryEach(std::string{"SELECT "} + HISTORY_SCORE_BMS_COLUMNS + " FROM score_cache_bms " + sql_where, params,
+              [&out](const SQLiteRow& raw_score) {
+                  LVF_DEBUG_ASSERT(raw_score.columnCount() == 19);
+                  auto& [hash, score] = out.emplace_back();
+                  raw_score.read(0, hash);
+                  convertHistoryScoreBms(score, raw_score);
+              });
     return out;
 }
 
@@ -337,40 +346,6 @@ void ScoreDB::updateCachedChartPbBms(const HashMD5& hash, const ScoreBMS& score)
     }
 }
 
-static bool convertHistoryScoreBms(ScoreBMS& out, const std::vector<std::any>& score) noexcept
-try
-{
-    if (score.size() < 19)
-        return false;
-    // md5 = ANY_STR(score[0]);
-    out.notes = ANY_INT(score[1]);
-    out.score = ANY_INT(score[2]);
-    out.fast = ANY_INT(score[3]);
-    out.slow = ANY_INT(score[4]);
-    out.maxcombo = ANY_INT(score[5]);
-    out.addtime = ANY_INT(score[6]);
-    out.exscore = ANY_INT(score[7]);
-    out.lamp = static_cast<ScoreBMS::Lamp>(ANY_INT(score[8]));
-    out.pgreat = ANY_INT(score[9]);
-    out.great = ANY_INT(score[10]);
-    out.good = ANY_INT(score[11]);
-    out.bad = ANY_INT(score[12]);
-    out.kpoor = ANY_INT(score[13]);
-    out.miss = ANY_INT(score[14]);
-    out.bp = ANY_INT(score[15]);
-    out.combobreak = ANY_INT(score[16]);
-    out.play_time = ANY_INT(score[17]);
-    out.replayFileName = ANY_STR(score[18]);
-
-    out.rate = static_cast<double>(out.exscore) / static_cast<double>(out.notes * 2) * 100;
-    return true;
-}
-catch (const std::exception& e)
-{
-    LOG_ERROR << e.what();
-    return false;
-}
-
 static ScoreBMS::Lamp from_lr2(int clear)
 {
     using L = ScoreBMS::Lamp;
@@ -435,23 +410,22 @@ void ScoreDB::rebuildBmsPbCache()
     LOG_DEBUG << "[ScoreDB] Asked to rebuild BMS score PB cache";
     transactionStart();
     exec("DELETE FROM score_cache_bms");
-    for (const auto& raw_score : query("SELECT * FROM score_bms ORDER BY addtime"))
-    {
-        auto score = std::make_shared<ScoreBMS>();
-        const std::string md5 = ANY_STR(raw_score[0]);
-        convert_score_bms(*score, raw_score);
-        updateCachedChartPbBms(HashMD5{md5}, *score);
-    }
-    for (const auto& raw_score : query("SELECT "
-                                       "md5,notes,score,fast,slow,maxcombo,addtime,exscore,lamp,pgreat,great,good,bad,"
-                                       "bpoor,miss,bp,cb,playedtime,replay "
-                                       "FROM score_history_bms "
-                                       "ORDER BY addtime"))
+    // updateCachedChartPbBms queries too, so collect the rows before processing them
+    std::vector<std::pair<HashMD5, ScoreBMS>> scores;
+    queryEach("SELECT * FROM score_bms ORDER BY addtime", {}, [&scores](const SQLiteRow& raw_score) {
+        auto& [hash, score] = scores.emplace_back();
+        raw_score.read(0, hash);
+        convert_score_bms(score, raw_score);
+    });
+    queryEach(std::string{"SELECT "} + HISTORY_SCORE_BMS_COLUMNS + " FROM score_history_bms ORDER BY addtime", {},
+              [&scores](const SQLiteRow& raw_score) {
+                  auto& [hash, score] = scores.emplace_back();
+                  raw_score.read(0, hash);
+                  convertHistoryScoreBms(score, raw_score);
+              });
+    for (const auto& [hash, score] : scores)
     {
-        auto score = std::make_shared<ScoreBMS>();
-        const std::string md5 = ANY_STR(raw_score[0]);
-        convertHistoryScoreBms(*score, raw_score);
-        updateCachedChartPbBms(HashMD5{md5}, *score);
+        updateCachedChartPbBms(hash, score);
     }
     commit();
     preloadScore();
@@ -475,12 +449,12 @@ void ScoreDB::updateCourseScoreBMS(const HashMD5& hash, const ScoreBMS& score)
 void ScoreDB::preloadScore()
 {
     cache.clear();
-    for (const auto& r : query("SELECT * FROM score_course_bms"))
-    {
+    auto& courseCache = cache["score_course_bms"];
+    queryEach("SELECT * FROM score_course_bms", {}, [&courseCache](const SQLiteRow& r) {
         auto score = std::make_shared<ScoreBMS>();
         convert_score_bms(*score, r);
-        cache["score_course_bms"].insert_or_assign(ANY_STR(r[0]), std::move(score));
-    }
+        courseCache.insert_or_assign(std::string{r.getText(0)}, std::move(score));
+    });
     for (auto&& [hash, score] : fetchCachedPbBMSImpl({}, {}))
     {
         cache["score_bms"].insert_or_assign(hash.hexdigest(), std::make_shared<ScoreBMS>(std::move(score)));
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <atomic>
 #include <functional>
+#include <list>
 #include <thread>
 #include <vector>
 
@@ -12,15 +13,12 @@
 #include "common/sysutil.h"
 #include "common/u8.h"
 #include "common/utils.h"
+#include "common/work_stealing_pool.h"
 #include "game/chart/chart_types.h"
 #include <common/assert.h>
 
 #include <re2/re2.h>
 
-#define BOOST_ASIO_NO_EXCEPTIONS
-#include <boost/asio/post.hpp>
-#include <boost/asio/thread_pool.hpp>
-
 // TODO: NOT NULL everything.
 const char* CREATE_FOLDER_TABLE_STR = "CREATE TABLE IF NOT EXISTS folder( "
                                       "pathmd5 TEXT PRIMARY KEY UNIQUE NOT NULL, "
@@ -67,10 +65,45 @@ const char* CREATE_SONG_TABLE_STR = "CREATE TABLE IF NOT EXISTS song("
                                     "CONSTRAINT pk_pf PRIMARY KEY (parent,file) "
                                     ");";
 static constexpr size_t SONG_PARAM_COUNT = 30;
-struct song_all_params
+
+// Trigram full text index of the song table for findChartByName, kept in sync by triggers.
+// Rows are linked by the implicit rowid of song, which is stable as long as the database is not VACUUMed.
+const char* CREATE_SONG_FTS_STRS[] = {
+    "CREATE VIRTUAL TABLE IF NOT EXISTS song_fts USING fts5("
+    "title, title2, artist, artist2, genre, version, "
+    "content='song', content_rowid='rowid', tokenize='trigram');",
+
+    "CREATE TRIGGER IF NOT EXISTS song_fts_insert AFTER INSERT ON song BEGIN "
+    "INSERT INTO song_fts(rowid, title, title2, artist, artist2, genre, version) "
+    "VALUES (new.rowid, new.title, new.title2, new.artist, new.artist2, new.genre, new.version); "
+    "END;",
+
+    "CREATE TRIGGER IF NOT EXISTS song_fts_delete AFTER DELETE ON song BEGIN "
+    "INSERT INTO song_fts(song_fts, rowid, title, title2, artist, artist2, genre, version) "
+    "VALUES ('delete', old.rowid, old.title, old.title2, old.artist, old.artist2, old.genre, old.version); "
+    "END;",
+
+    "CREATE TRIGGER IF NOT EXISTS song_fts_update AFTER UPDATE ON song BEGIN "
+    "INSERT INTO song_fts(song_fts, rowid, title, title2, artist, artist2, genre, version) "
+    "VALUES ('delete', old.rowid, old.title, old.title2, old.artist, old.artist2, old.genre, old.version); "
+    "INSERT INTO song_fts(rowid, title, title2, artist, artist2, genre, version) "
+    "VALUES (new.rowid, new.title, new.title2, new.artist, new.artist2, new.genre, new.version); "
+    "END;",
+};
+
+// Chart file state at the time it was added, see SongDB::refreshExistingFolder.
+const char* CREATE_FILE_JOURNAL_TABLE_STR = "CREATE TABLE IF NOT EXISTS file_journal("
+                                            "parent TEXT NOT NULL, "
+                                            "file TEXT NOT NULL, "
+                                            "size INTEGER NOT NULL, "
+                                            "mtime INTEGER NOT NULL, "
+                                            "md5 TEXT NOT NULL, "
+                                            "CONSTRAINT pk_pf PRIMARY KEY (parent,file) "
+                                            ");";
+struct SongDB::SongRow
 {
-    std::string md5;
-    std::string parent;
+    HashMD5 md5;
+    HashMD5 parent;
     std::string file;
     long long type = 0;
     std::string title;
@@ -100,51 +133,50 @@ struct song_all_params
     long long random = 0;
     long long addtime = 0;
 
-    song_all_params(const std::vector<std::any>& queryResult)
+    // Row of "SELECT * FROM song".
+    bool read(const SQLiteRow& row)
     {
-        if (queryResult.size() < SONG_PARAM_COUNT)
-            return;
+        if (row.columnCount() < static_cast<int>(SONG_PARAM_COUNT))
+            return false;
 
-        md5 = ANY_STR(queryResult[0]);
-        parent = ANY_STR(queryResult[1]);
-        file = ANY_STR(queryResult[2]);
-        type = ANY_INT(queryResult[3]);
-        title = ANY_STR(queryResult[4]);
-        title2 = ANY_STR(queryResult[5]);
-        artist = ANY_STR(queryResult[6]);
-        artist2 = ANY_STR(queryResult[7]);
-        genre = ANY_STR(queryResult[8]);
-        version = ANY_STR(queryResult[9]);
-        level = ANY_REAL(queryResult[10]);
-        bpm = ANY_REAL(queryResult[11]);
-        minbpm = ANY_REAL(queryResult[12]);
-        maxbpm = ANY_REAL(queryResult[13]);
-        length = ANY_INT(queryResult[14]);
-        totalnotes = ANY_INT(queryResult[15]);
-        stagefile = ANY_STR(queryResult[16]);
-        bannerfile = ANY_STR(queryResult[17]);
-        gamemode = ANY_INT(queryResult[18]);
-        judgerank = ANY_INT(queryResult[19]);
-        total = ANY_INT(queryResult[20]);
-        playlevel = ANY_INT(queryResult[21]);
-        difficulty = ANY_INT(queryResult[22]);
-        longnote = ANY_INT(queryResult[23]);
-        landmine = ANY_INT(queryResult[24]);
-        metricmod = ANY_INT(queryResult[25]);
-        stop = ANY_INT(queryResult[26]);
-        bga = ANY_INT(queryResult[27]);
-        random = ANY_INT(queryResult[28]);
-        addtime = ANY_INT(queryResult[29]);
+        row.read(0, md5);
+        row.read(1, parent);
+        row.read(2, file);
+        row.read(3, type);
+        row.read(4, title);
+        row.read(5, title2);
+        row.read(6, artist);
+        row.read(7, artist2);
+        row.read(8, genre);
+        row.read(9, version);
+        row.read(10, level);
+        row.read(11, bpm);
+        row.read(12, minbpm);
+        row.read(13, maxbpm);
+        row.read(14, length);
+        row.read(15, totalnotes);
+        row.read(16, stagefile);
+        row.read(17, bannerfile);
+        row.read(18, gamemode);
+        row.read(19, judgerank);
+        row.read(20, total);
+        row.read(21, playlevel);
+        row.read(22, difficulty);
+        row.read(23, longnote);
+        row.read(24, landmine);
+        row.read(25, metricmod);
+        row.read(26, stop);
+        row.read(27, bga);
+        row.read(28, random);
+        row.read(29, addtime);
+        return true;
     }
 };
-bool convert_bms(const std::shared_ptr<ChartFormatBMSMeta>& chart, const std::vector<std::any>& in)
-{
-    if (in.size() < 30)
-        return false;
 
-    song_all_params params(in);
-    chart->fileHash = HashMD5{params.md5};
-    chart->folderHash = HashMD5{params.parent};
+void convert_bms(const std::shared_ptr<ChartFormatBMSMeta>& chart, const SongDB::SongRow& params)
+{
+    chart->fileHash = params.md5;
+    chart->folderHash = params.parent;
     chart->fileName = PathFromUTF8(params.file);
     //                        params.type       ;
     chart->title = params.title;
@@ -181,8 +213,6 @@ bool convert_bms(const std::shared_ptr<ChartFormatBMSMeta>& chart, const std::ve
         chart->haveNote = true;
         chart->notes_total = chart->totalNotes;
     }
-
-    return true;
 }
 
 SongDB::SongDB(const char* path) : SQLite(path, "SONG")
@@ -192,7 +222,7 @@ SongDB::SongDB(const char* path) : SQLite(path, "SONG")
         LOG_WARNING << "[SongDB] Set cache_size ERROR! " << errmsg();
     }
 
-    poolThreadCount = std::thread::hardware_concurrency() - 1;
+    setThreadCount(0);
 
     if (exec(CREATE_FOLDER_TABLE_STR) != SQLITE_OK)
     {
@@ -215,6 +245,12 @@ SongDB::SongDB(const char* path) : SQLite(path, "SONG")
         abort();
     }
 
+    if (exec(CREATE_FILE_JOURNAL_TABLE_STR) != SQLITE_OK)
+    {
+        LOG_ERROR << "[SongDB] Create table file_journal ERROR! " << errmsg();
+        abort();
+    }
+
     if (exec("CREATE INDEX IF NOT EXISTS index_parent ON folder(parent)") != SQLITE_OK)
     {
         LOG_ERROR << "[SongDB] Create parent index for folder ERROR! " << errmsg();
@@ -232,15 +268,41 @@ SongDB::SongDB(const char* path) : SQLite(path, "SONG")
     {
         LOG_ERROR << "[SongDB] Create gamemode index for song ERROR! " << errmsg();
     }
+
+    if (!applyMigration("20261017T120000", [this]() {
+            for (const char* sql : CREATE_SONG_FTS_STRS)
+            {
+                if (exec(sql) != SQLITE_OK)
+                {
+                    LOG_ERROR << "[SongDB] Create search index ERROR! " << errmsg();
+                    return false;
+                }
+            }
+            // index charts added before the migration
+            return exec("INSERT INTO song_fts(song_fts) VALUES('rebuild')") == SQLITE_OK;
+        }))
+    {
+        LOG_ERROR << "[SongDB] Search index migration failed, searching without index";
+    }
+    else
+    {
+        haveSearchIndex = true;
+    }
 }
 
 SongDB::~SongDB()
 {
-    if (threadPool)
-    {
-        delete (boost::asio::thread_pool*)threadPool;
-        threadPool = nullptr;
-    }
+    // pending tasks reference this object
+    stopLoading();
+    waitLoadingFinish();
+}
+
+void SongDB::setThreadCount(unsigned count)
+{
+    // leave one core for the main thread
+    if (count == 0)
+        count = std::max(1u, std::thread::hardware_concurrency() - 1);
+    poolThreadCount = count;
 }
 
 bool SongDB::addChart(const HashMD5& folder, const Path& path)
@@ -257,6 +319,11 @@ bool SongDB::addChart(const HashMD5& folder, const Path& path)
             return false;
         }
 
+        // stat before hashing, a file changed in between is picked up by the next refresh
+        std::error_code ec;
+        const auto fileSize = static_cast<long long>(fs::file_size(path, ec));
+        const long long fileModifyTime = getFileLastWriteTime(path);
+
         if (auto result = query("SELECT md5 FROM song WHERE parent=? AND file=?", {folder.hexdigest(), filename});
             !result.empty() && !result[0].empty())
         {
@@ -265,26 +332,24 @@ bool SongDB::addChart(const HashMD5& folder, const Path& path)
             const HashMD5 filemd5 = md5file(path);
             if (dbmd5 == filemd5)
             {
+                updateFileJournal(folder, path, fileSize, fileModifyTime, filemd5);
                 return false;
             }
             // remove existing entry
-            removeChart(path, folder);
+            if (removeChart(path, folder))
+            {
+                addChartModified++;
+            }
         }
 
-        std::shared_ptr<ChartFormatBase> c = ChartFormatBase::createFromFile(path, 2356);
+        // Notes are only counted, the chart is not built.
+        std::shared_ptr<ChartFormatBase> c = ChartFormatBase::createMetaFromFile(path, 2356);
         if (c == nullptr)
         {
             LOG_WARNING << "[SongDB] File error: " << path;
             return false;
         }
 
-        auto s = ChartObjectBase::createFromChartFormat(0, c);
-        if (s == nullptr)
-        {
-            LOG_WARNING << "[SongDB] File parsing error: " << path;
-            return false;
-        }
-
         {
             std::unique_lock l(addCurrentPathMutex, std::try_to_lock);
             if (l.owns_lock())
@@ -319,8 +384,8 @@ bool SongDB::addChart(const HashMD5& folder, const Path& path)
                                    c->startBPM,
                                    c->minBPM,
                                    c->maxBPM,
-                                   s->getTotalLength().norm() / 1000,
-                                   static_cast<int>(s->getNoteTotalCount()),
+                                   c->totalLength,
+                                   c->totalNotes,
                                    c->stagefile,
                                    c->banner,
                                    bmsc->gamemode,
@@ -337,6 +402,7 @@ bool SongDB::addChart(const HashMD5& folder, const Path& path)
                                    bmsc->haveRandom,
                                    getFileTimeNow()}))
             {
+                updateFileJournal(folder, path, fileSize, fileModifyTime, c->fileHash);
                 return true;
             }
             else
@@ -368,6 +434,11 @@ bool SongDB::removeChart(const Path& path, const HashMD5& parent)
         LOG_WARNING << "[SongDB] Delete chart from db error: " << path << ": " << errmsg();
         return false;
     }
+    if (SQLITE_OK !=
+        exec("DELETE FROM file_journal WHERE file=? AND parent=?", {path.filename().u8string(), parent.hexdigest()}))
+    {
+        LOG_WARNING << "[SongDB] Delete chart from file journal error: " << path << ": " << errmsg();
+    }
     return true;
 }
 
@@ -378,70 +449,97 @@ bool SongDB::removeChart(const HashMD5& md5, const HashMD5& parent)
         LOG_WARNING << "[SongDB] Delete chart from db error: " << md5.hexdigest() << ": " << errmsg();
         return false;
     }
+    if (SQLITE_OK != exec("DELETE FROM file_journal WHERE md5=? AND parent=?", {md5.hexdigest(), parent.hexdigest()}))
+    {
+        LOG_WARNING << "[SongDB] Delete chart from file journal error: " << md5.hexdigest() << ": " << errmsg();
+    }
     return true;
 }
 
+void SongDB::updateFileJournal(const HashMD5& folder, const Path& path, long long size, long long modtime,
+                               const HashMD5& md5)
+{
+    if (SQLITE_OK != exec("INSERT OR REPLACE INTO file_journal(parent,file,size,mtime,md5) VALUES(?,?,?,?,?)",
+                          {folder.hexdigest(), path.filename().u8string(), size, modtime, md5.hexdigest()}))
+    {
+        LOG_WARNING << "[SongDB] Update file journal error: " << path << ": " << errmsg();
+    }
+}
+
 std::vector<std::shared_ptr<ChartFormatBase>> SongDB::findChartByName(const HashMD5& folder, const std::string& tagRaw,
                                                                       unsigned limit) const
 {
     LOG_INFO << "[SongDB] Search for songs matching: " << tagRaw;
 
-    std::string tag = tagRaw;
-    static const std::pair<RE2, re2::StringPiece> search_replace_pattern[]{
-        {"%", "\\\\%"},
-        {"_", "\\\\_"},
-    };
-    for (const auto& [in, out] : search_replace_pattern)
+    // ?1: parent, empty for all folders; ?2: search key; ?3: limit, -1 for none
+    const std::string parent = folder != ROOT_FOLDER_HASH ? folder.hexdigest() : std::string{};
+    const long long rowLimit = limit > 0 ? static_cast<long long>(limit) : -1;
+
+    std::string sql;
+    std::string tag;
+    // The trigram tokenizer matches substrings of 3 or more characters, shorter keys scan the table.
+    // So does every key if the index could not be created.
+    const auto characters = std::count_if(tagRaw.begin(), tagRaw.end(), [](char c) { return (c & 0xC0) != 0x80; });
+    if (haveSearchIndex && characters >= 3)
     {
-        RE2::GlobalReplace(&tag, in, out);
+        sql = "SELECT song.* FROM song_fts JOIN song ON song.rowid=song_fts.rowid "
+              "WHERE (?1='' OR song.parent=?1) AND "
+              "song_fts MATCH ?2 LIMIT ?3";
+        // match the key as one phrase in any column
+        tag = tagRaw;
+        RE2::GlobalReplace(&tag, "\"", "\"\"");
+        tag = "{title title2 artist artist2 genre version} : \"" + tag + "\"";
+    }
+    else
+    {
+        sql = "SELECT * FROM song WHERE (?1='' OR parent=?1) AND "
+              "(title   LIKE '%' || ?2 || '%' ESCAPE '\\' OR "
+              "title2  LIKE '%' || ?2 || '%' ESCAPE '\\' OR "
+              "artist  LIKE '%' || ?2 || '%' ESCAPE '\\' OR "
+              "artist2 LIKE '%' || ?2 || '%' ESCAPE '\\' OR "
+              "genre   LIKE '%' || ?2 || '%' ESCAPE '\\' OR "
+              "version LIKE '%' || ?2 || '%' ESCAPE '\\' ) LIMIT ?3";
+        tag = tagRaw;
+        static const std::pair<RE2, re2::StringPiece> search_replace_pattern[]{
+            {"%", "\\\\%"},
+            {"_", "\\\\_"},
+        };
+        for (const auto& [in, out] : search_replace_pattern)
+        {
+            RE2::GlobalReplace(&tag, in, out);
+        }
     }
-
-    std::stringstream ss;
-    ss << "SELECT * FROM song WHERE ";
-    if (folder != ROOT_FOLDER_HASH)
-        ss << "parent=" << folder.hexdigest() << " AND ";
-    ss << "(title   LIKE '%' || ? || '%' ESCAPE '\\' OR "
-       << "title2  LIKE '%' || ? || '%' ESCAPE '\\' OR "
-       << "artist  LIKE '%' || ? || '%' ESCAPE '\\' OR "
-       << "artist2 LIKE '%' || ? || '%' ESCAPE '\\' OR "
-       << "genre   LIKE '%' || ? || '%' ESCAPE '\\' OR "
-       << "version LIKE '%' || ? || '%' ESCAPE '\\' )";
-    if (limit > 0)
-        ss << " LIMIT " << limit;
-
-    std::string strSql = ss.str();
-    auto result = query(strSql.c_str(), {tag, tag, tag, tag, tag, tag});
 
     std::vector<std::shared_ptr<ChartFormatBase>> ret;
-    for (const auto& r : result)
-    {
-        switch (eChartFormat(ANY_INT(r[3])))
+    SongRow r;
+    queryEach(sql, {parent, tag, rowLimit}, [&](const SQLiteRow& row) {
+        if (!r.read(row))
+            return;
+        switch (eChartFormat(r.type))
         {
         case eChartFormat::BMS: {
             auto p = std::make_shared<ChartFormatBMSMeta>();
-            if (convert_bms(p, r))
+            convert_bms(p, r);
+            if (p->fileName.is_absolute())
             {
-                if (p->fileName.is_absolute())
+                p->absolutePath = p->fileName;
+                ret.push_back(p);
+            }
+            else
+            {
+                const auto [hasFolderPath, folderPath] = getFolderPath(p->folderHash);
+                if (hasFolderPath)
                 {
-                    p->absolutePath = p->fileName;
+                    p->absolutePath = folderPath / p->fileName;
                     ret.push_back(p);
                 }
-                else
-                {
-                    const auto [hasFolderPath, folderPath] = getFolderPath(p->folderHash);
-                    if (hasFolderPath)
-                    {
-                        p->absolutePath = folderPath / p->fileName;
-                        ret.push_back(p);
-                    }
-                }
             }
             break;
         }
 
         default: break;
         }
-    }
+    });
 
     LOG_INFO << "[SongDB] found " << ret.size() << " songs";
     return ret;
@@ -457,41 +555,33 @@ std::vector<std::shared_ptr<ChartFormatBase>> SongDB::findChartByHash(const Hash
     if (it == songQueryHashMap.end())
         return ret;
     for (const auto& index : it->second)
-        try
+    {
+        const auto& r = songQueryPool[index];
+        switch (eChartFormat(r.type))
         {
-            const auto& r = songQueryPool[index];
-            switch (eChartFormat(ANY_INT(r[3])))
+        case eChartFormat::BMS: {
+            auto p = std::make_shared<ChartFormatBMSMeta>();
+            convert_bms(p, r);
+            if (p->fileName.is_absolute())
             {
-            case eChartFormat::BMS: {
-                auto p = std::make_shared<ChartFormatBMSMeta>();
-                if (convert_bms(p, r))
+                p->absolutePath = p->fileName;
+                ret.push_back(p);
+            }
+            else
+            {
+                const auto [hasFolderPath, folderPath] = getFolderPath(p->folderHash);
+                if (hasFolderPath)
                 {
-                    if (p->fileName.is_absolute())
-                    {
-                        p->absolutePath = p->fileName;
-                        ret.push_back(p);
-                    }
-                    else
-                    {
-                        const auto [hasFolderPath, folderPath] = getFolderPath(p->folderHash);
-                        if (hasFolderPath)
-                        {
-                            p->absolutePath = folderPath / p->fileName;
-                            ret.push_back(p);
-                        }
-                    }
+                    p->absolutePath = folderPath / p->fileName;
+                    ret.push_back(p);
                 }
-                break;
-            }
-
-            default: break;
             }
+            break;
         }
-        // TODO: remove after adding NOT NULL to every table field.
-        catch (const std::bad_any_cast& e)
-        {
-            LOG_ERROR << "std::bad_any_cast: " << e.what();
+
+        default: break;
         }
+    }
 
     if (checksum)
     {
@@ -529,38 +619,36 @@ std::vector<std::shared_ptr<ChartFormatBase>> SongDB::findChartFromTime(const Ha
     ss << "addtime>=?";
 
     std::string strSql = ss.str();
-    auto result = query(strSql.c_str(), {(long long)addTime});
-
     std::vector<std::shared_ptr<ChartFormatBase>> ret;
-    for (const auto& r : result)
-    {
-        switch (eChartFormat(ANY_INT(r[3])))
+    SongRow r;
+    queryEach(strSql, {(long long)addTime}, [&](const SQLiteRow& row) {
+        if (!r.read(row))
+            return;
+        switch (eChartFormat(r.type))
         {
         case eChartFormat::BMS: {
             auto p = std::make_shared<ChartFormatBMSMeta>();
-            if (convert_bms(p, r))
+            convert_bms(p, r);
+            if (p->fileName.is_absolute())
             {
-                if (p->fileName.is_absolute())
+                p->absolutePath = p->fileName;
+                ret.push_back(p);
+            }
+            else
+            {
+                const auto [hasFolderPath, folderPath] = getFolderPath(p->folderHash);
+                if (hasFolderPath)
                 {
-                    p->absolutePath = p->fileName;
+                    p->absolutePath = folderPath / p->fileName;
                     ret.push_back(p);
                 }
-                else
-                {
-                    const auto [hasFolderPath, folderPath] = getFolderPath(p->folderHash);
-                    if (hasFolderPath)
-                    {
-                        p->absolutePath = folderPath / p->fileName;
-                        ret.push_back(p);
-                    }
-                }
             }
             break;
         }
 
         default: break;
         }
-    }
+    });
 
     LOG_DEBUG << "[SongDB] Found " << ret.size() << " songs";
     return ret;
@@ -573,24 +661,29 @@ void SongDB::prepareCache()
     // compress db i/o
     freeCache();
 
-    size_t count = 0;
-    for (auto& row : query("SELECT * FROM song"))
-    {
-        songQueryHashMap[HashMD5(ANY_STR(row[0]))].push_back(count);
-        songQueryParentMap[HashMD5(ANY_STR(row[1]))].push_back(count);
-        songQueryPool.push_back(std::move(row));
-        count++;
-    }
+    // rows are decoded in place, no intermediate std::any table
+    queryEach("SELECT * FROM song", {}, [this](const SQLiteRow& row) {
+        SongRow& song = songQueryPool.emplace_back();
+        if (!song.read(row))
+        {
+            songQueryPool.pop_back();
+            return;
+        }
+        const size_t index = songQueryPool.size() - 1;
+        songQueryHashMap[song.md5].push_back(index);
+        songQueryParentMap[song.parent].push_back(index);
+    });
 
-    count = 0;
-    for (auto& row : query("SELECT * FROM folder"))
-    {
-        folderQueryHashMap[HashMD5(ANY_STR(row[0]))].push_back(count);
-        if (row[1].has_value())
-            folderQueryParentMap[HashMD5(ANY_STR(row[1]))].push_back(count);
-        folderQueryPool.push_back(std::move(row));
-        count++;
-    }
+    queryAs<HashMD5, std::optional<HashMD5>, std::string, long long, std::string, long long>(
+        "SELECT pathmd5,parent,name,type,path,modtime FROM folder", {},
+        [this](HashMD5& hash, std::optional<HashMD5>& parent, std::string& name, long long type, std::string& path,
+               long long modtime) {
+            const size_t index = folderQueryPool.size();
+            folderQueryHashMap[hash].push_back(index);
+            if (parent)
+                folderQueryParentMap[*parent].push_back(index);
+            folderQueryPool.push_back({hash, std::move(name), FolderType(type), std::move(path), modtime});
+        });
 }
 
 void SongDB::freeCache()
@@ -608,6 +701,7 @@ void SongDB::freeCache()
 int SongDB::initializeFolders(const std::vector<Path>& paths)
 {
     resetAddSummary();
+    loadJournal();
 
     std::future<void> sessionFuture;
     std::chrono::system_clock::time_point sessionTimestamp = std::chrono::system_clock::now();
@@ -628,21 +722,100 @@ int SongDB::initializeFolders(const std::vector<Path>& paths)
         }
     });
 
-    int count = 0;
     for (const auto& p : paths)
     {
-        int subCount = addSubFolder(p, ROOT_FOLDER_HASH);
-        count += subCount;
-        LOG_INFO << "[SongDB] " << p << ": added " << subCount << " entries";
+        addSubFolderTask(p, ROOT_FOLDER_HASH);
     }
 
+    // charts are inserted by the pool, wait before closing the session so they land in its transactions
+    waitLoadingFinish();
+    LOG_INFO << "[SongDB] Checked " << addChartTaskCount << " charts in " << paths.size() << " folders";
+
     inAddFolderSession = false;
-    commit();
     sessionFuture.wait_for(std::chrono::seconds(10));
+    commit();
 
-    waitLoadingFinish();
+    freeJournal();
 
-    return count;
+    return addChartTaskCount;
+}
+
+void SongDB::loadJournal()
+{
+    freeJournal();
+
+    queryAs<HashMD5, std::optional<HashMD5>, long long, std::string, long long>(
+        "SELECT pathmd5,parent,type,path,modtime FROM folder", {},
+        [this](const HashMD5& hash, const std::optional<HashMD5>& parent, long long type, const std::string& path,
+               long long modtime) {
+            folderJournal[path] = {hash, static_cast<FolderType>(type), modtime};
+            if (parent)
+                subFolderJournal[*parent].push_back(PathFromUTF8(path));
+        });
+
+    queryAs<HashMD5, std::string, long long, long long, HashMD5>(
+        "SELECT parent,file,size,mtime,md5 FROM file_journal", {},
+        [this](const HashMD5& parent, const std::string& file, long long size, long long mtime, const HashMD5& md5) {
+            fileJournal[parent][file] = {size, mtime, md5};
+        });
+
+    journalLoaded = true;
+    LOG_DEBUG << "[SongDB] Loaded journal of " << folderJournal.size() << " folders";
+}
+
+void SongDB::freeJournal()
+{
+    journalLoaded = false;
+    folderJournal.clear();
+    subFolderJournal.clear();
+    fileJournal.clear();
+}
+
+std::optional<SongDB::FolderState> SongDB::findFolderState(const Path& path) const
+{
+    if (journalLoaded)
+    {
+        if (auto it = folderJournal.find(std::string(lunaticvibes::s(path.u8string()))); it != folderJournal.end())
+            return it->second;
+        return std::nullopt;
+    }
+
+    if (auto q = query("SELECT pathmd5,type,modtime FROM folder WHERE path=?", {path.u8string()}); !q.empty())
+    {
+        const long long modtime = q[0][2].has_value() ? ANY_INT(q[0][2]) : 0;
+        return FolderState{HashMD5{ANY_STR(q[0][0])}, static_cast<FolderType>(ANY_INT(q[0][1])), modtime};
+    }
+    return std::nullopt;
+}
+
+std::vector<Path> SongDB::getSubFolders(const HashMD5& hash) const
+{
+    if (journalLoaded)
+    {
+        if (auto it = subFolderJournal.find(hash); it != subFolderJournal.end())
+            return it->second;
+        return {};
+    }
+
+    std::vector<Path> ret;
+    for (const auto& row : query("SELECT path FROM folder WHERE parent=?", {hash.hexdigest()}))
+        ret.push_back(PathFromUTF8(ANY_STR(row[0])));
+    return ret;
+}
+
+std::unordered_map<std::string, SongDB::FileState> SongDB::getFileJournal(const HashMD5& hash) const
+{
+    if (journalLoaded)
+    {
+        if (auto it = fileJournal.find(hash); it != fileJournal.end())
+            return it->second;
+        return {};
+    }
+
+    std::unordered_map<std::string, FileState> ret;
+    for (const auto& row : query("SELECT file,size,mtime,md5 FROM file_journal WHERE parent=?", {hash.hexdigest()}))
+        ret[ANY_STR(row[0])] = {ANY_INT(row[1]), ANY_INT(row[2]), HashMD5{ANY_STR(row[3])}};
+    return ret;
 }
 
 int SongDB::addSubFolder(Path path, const HashMD5& parentHash)
@@ -665,31 +838,26 @@ int SongDB::addSubFolder(Path path, const HashMD5& parentHash)
     HashMD5 folderHash = md5(lunaticvibes::s(path.u8string()));
     long long folderModifyTime = getFileLastWriteTime(path);
 
-    if (auto q = query("SELECT pathmd5,path,type,modtime FROM folder WHERE path=?", {path.u8string()}); !q.empty())
+    if (auto state = findFolderState(path); state)
     {
         LOG_VERBOSE << "[SongDB] Sub folder already exists (" << path << ")";
 
-        HashMD5 folderMD5{ANY_STR(q[0][0])};
-        // std::string folderPath = ANY_STR(q[0][1]);
-        FolderType folderType = (FolderType)ANY_INT(q[0][2]);
-        long long folderModifyTimeDB = ANY_INT(q[0][3]);
-
-        if (folderType == FolderType::SONG_BMS)
+        // entries of the folder are not changed since last scan
+        if (folderModifyTime == state->modtime)
         {
-            // only update song folder if recently modified
-            if (folderModifyTime > folderModifyTimeDB)
+            if (state->type == FolderType::SONG_BMS)
             {
-                count = refreshExistingFolder(folderMD5, path, folderType);
+                LOG_VERBOSE << "[SongDB] Skip refreshing song folder: " << path;
             }
             else
             {
-                LOG_VERBOSE << "[SongDB] Skip refreshing song folder: " << path;
+                // step in sub folders, without listing this one again
+                count = refreshSubFolders(state->hash);
             }
         }
         else
         {
-            // step in sub folders
-            count = refreshExistingFolder(folderMD5, path, folderType);
+            count = refreshExistingFolder(state->hash, path, state->type);
         }
     }
     else
@@ -708,29 +876,59 @@ int SongDB::removeFolder(const HashMD5& hash, bool removeSong)
         {
             LOG_WARNING << "[SongDB] remove song from db error: " << errmsg();
         }
+        if (SQLITE_OK != exec("DELETE FROM file_journal WHERE parent=?", {hash.hexdigest()}))
+        {
+            LOG_WARNING << "[SongDB] remove file journal from db error: " << errmsg();
+        }
     }
 
     return exec("DELETE FROM folder WHERE pathmd5=?", {hash.hexdigest()});
 }
 
+lunaticvibes::WorkStealingPool& SongDB::getThreadPool()
+{
+    std::unique_lock l(threadPoolMutex);
+    if (!threadPool)
+    {
+        threadPool = std::make_shared<lunaticvibes::WorkStealingPool>("SongDB", poolThreadCount);
+    }
+    return *threadPool;
+}
+
 void SongDB::waitLoadingFinish()
 {
-    if (threadPool)
+    // Another waiter may drop the pool meanwhile, hold a reference until done with it.
+    std::shared_ptr<lunaticvibes::WorkStealingPool> pool;
     {
-        LOG_DEBUG << "[SongDB] Waiting for all loading threads...";
+        std::unique_lock l(threadPoolMutex);
+        if (!threadPool)
+            return;
+        pool = threadPool;
+    }
 
-        // wait for all tasks
-        boost::asio::thread_pool& pool = *(boost::asio::thread_pool*)threadPool;
-        pool.join();
+    LOG_DEBUG << "[SongDB] Waiting for all loading threads...";
 
-        LOG_DEBUG << "[SongDB] All loading threads finished, continue";
+    // wait for all tasks, including folders found while waiting
+    pool->wait();
 
-        // The old pool is not valid anymore, removing
-        delete (boost::asio::thread_pool*)threadPool;
-        threadPool = nullptr;
+    LOG_DEBUG << "[SongDB] All loading threads finished, continue";
+
+    // The old pool is not valid anymore, removing
+    {
+        std::unique_lock l(threadPoolMutex);
+        if (threadPool == pool)
+            threadPool.reset();
     }
 }
 
+struct SongDB::FolderScan
+{
+    HashMD5 hash;
+    Path path;
+    long long modtime;               // read before listing the folder
+    std::atomic<size_t> pending = 1; // posted tasks, plus the listing itself
+};
+
 int SongDB::addNewFolder(const HashMD5& hash, const Path& path, const HashMD5& parentHash)
 {
     LOG_DEBUG << "[SongDB] Add new folder " << path;
@@ -748,17 +946,17 @@ int SongDB::addNewFolder(const HashMD5& hash, const Path& path, const HashMD5& p
 
     int ret;
     auto folderName = fs::weakly_canonical(path).filename();
-    long long folderModifyTime = getFileLastWriteTime(path);
+    auto scan = std::make_shared<FolderScan>(hash, path, getFileLastWriteTime(path));
+    // the modification time is stored once the entries are scanned, until then the folder is listed again on refresh
     if (!parentHash.empty())
     {
         ret = exec("INSERT INTO folder VALUES(?,?,?,?,?,?)",
-                   {hash.hexdigest(), parentHash.hexdigest(), folderName.u8string(), (int)type, path.u8string(),
-                    folderModifyTime});
+                   {hash.hexdigest(), parentHash.hexdigest(), folderName.u8string(), (int)type, path.u8string(), 0});
     }
     else
     {
         ret = exec("INSERT INTO folder VALUES(?,?,?,?,?,?)",
-                   {hash.hexdigest(), nullptr, folderName.u8string(), (int)type, path.u8string(), folderModifyTime});
+                   {hash.hexdigest(), nullptr, folderName.u8string(), (int)type, path.u8string(), 0});
     }
     if (SQLITE_OK != ret)
     {
@@ -781,7 +979,6 @@ int SongDB::addNewFolder(const HashMD5& hash, const Path& path, const HashMD5& p
         }
     }
 
-    std::vector<Path> subFolderList;
     for (const auto& f : fs::directory_iterator(path))
     {
         if (stopRequested)
@@ -789,31 +986,15 @@ int SongDB::addNewFolder(const HashMD5& hash, const Path& path, const HashMD5& p
 
         if (!isSongFolder && fs::is_directory(f))
         {
-            subFolderList.push_back(f);
+            addSubFolderTask(f, hash, scan);
         }
         else if (isSongFolder && analyzeChartType(f) != eChartFormat::UNKNOWN)
         {
-            addChartTaskCount++;
-
-            if (!threadPool)
-            {
-                threadPool = (void*)new boost::asio::thread_pool(poolThreadCount);
-            }
-            boost::asio::thread_pool& pool = *(boost::asio::thread_pool*)threadPool;
-            boost::asio::post(pool, std::bind_front(&SongDB::addChart, this, hash, f));
+            addChartTask(hash, f, scan);
             ++count;
         }
     }
-
-    for (const auto& sub : subFolderList)
-    {
-        if (stopRequested)
-            break;
-
-        int addedCount = addSubFolder(sub, hash);
-        if (addedCount > 0)
-            count += addedCount;
-    }
+    finishFolderTask(scan);
 
     return count;
 }
@@ -822,6 +1003,8 @@ int SongDB::refreshExistingFolder(const HashMD5& hash, const Path& path, FolderT
 {
     LOG_DEBUG << "[SongDB] Refreshing contents of " << path;
 
+    auto scan = std::make_shared<FolderScan>(hash, path, getFileLastWriteTime(path));
+
     bool isSongFolder = false;
     for (auto& f : fs::directory_iterator(path))
     {
@@ -843,121 +1026,45 @@ int SongDB::refreshExistingFolder(const HashMD5& hash, const Path& path, FolderT
     {
         LOG_DEBUG << "[SongDB] Checking for new entries" << " (" << path << ")";
 
-        int count = 0;
-
-        // browse chart files
-        std::vector<Path> bmsFiles;
-        for (auto& f : fs::directory_iterator(path))
+        // delete file-not-found song entries
+        size_t existedCount = 0;
+        for (const auto& row : query("SELECT file FROM song WHERE parent=?", {hash.hexdigest()}))
         {
-            if (analyzeChartType(f) != eChartFormat::UNKNOWN)
-                bmsFiles.push_back(fs::absolute(f));
-        }
-        std::sort(bmsFiles.begin(), bmsFiles.end());
-
-        // get charts from db
-        std::vector<Path> existedFiles;
-        bool hasDeletedEntry = false;
-        bool hasModifiedEntry = false;
-        auto existedList = browseSong(hash);
-        if (existedList && !existedList->empty())
-        {
-            for (size_t i = 0; i < existedList->getContentsCount(); ++i)
+            ++existedCount;
+            const Path chartPath = path / PathFromUTF8(ANY_STR(row[0]));
+            if (!fs::exists(chartPath) && removeChart(chartPath, hash))
             {
-                existedFiles.push_back(existedList->getChart(i)->absolutePath);
-            }
-            std::sort(existedFiles.begin(), existedFiles.end());
-
-            // delete file-not-found song entries
-            if (!existedFiles.empty())
-            {
-                std::vector<HashMD5> deletedFiles;
-                std::vector<Path> modifiedFiles;
-
-                for (size_t i = 0; i < existedList->getContentsCount(); ++i)
-                {
-                    std::shared_ptr<ChartFormatBase> chart = existedList->getChart(i);
-                    if (!fs::exists(chart->absolutePath))
-                    {
-                        deletedFiles.push_back(chart->fileHash);
-                    }
-                    else
-                    {
-                        long long fstime = getFileLastWriteTime(path);
-                        if (auto q = query("SELECT addtime FROM song WHERE md5=? AND parent=?",
-                                           {chart->fileHash.hexdigest(), hash.hexdigest()});
-                            !q.empty())
-                        {
-                            long long dbTime = ANY_INT(q[0][0]);
-
-                            if (fstime > dbTime && md5file(chart->absolutePath) != chart->fileHash)
-                            {
-                                modifiedFiles.push_back(chart->absolutePath);
-                            }
-                        }
-                    }
-                }
-
-                hasDeletedEntry = !deletedFiles.empty();
-                for (auto& chartMD5 : deletedFiles)
-                {
-                    if (removeChart(chartMD5, hash))
-                    {
-                        addChartDeleted++;
-                    }
-                }
-
-                hasModifiedEntry = !modifiedFiles.empty();
-                for (auto& chartPath : modifiedFiles)
-                {
-                    if (removeChart(chartPath, hash))
-                    {
-                        addChartModified++;
-                    }
-                }
-
-                // remove modified files from existedFiles, and add again below
-                std::vector<Path> existedFilesReal;
-                std::set_difference(existedFiles.begin(), existedFiles.end(), modifiedFiles.begin(),
-                                    modifiedFiles.end(), std::back_inserter(existedFilesReal));
-                std::swap(existedFiles, existedFilesReal);
+                addChartDeleted++;
             }
         }
 
-        // only add new entries
-        std::vector<Path> newFiles;
-        std::set_difference(bmsFiles.begin(), bmsFiles.end(), existedFiles.begin(), existedFiles.end(),
-                            std::back_inserter(newFiles));
-        for (auto& p : newFiles)
+        // only parse new or modified files, addChart compares the hash of files missing from the journal
+        int count = 0;
+        const auto journal = getFileJournal(hash);
+        for (const auto& f : fs::directory_iterator(path))
         {
             if (stopRequested)
             {
                 break;
             }
-            addChartTaskCount++;
+            if (analyzeChartType(f) == eChartFormat::UNKNOWN)
+                continue;
 
-            if (!threadPool)
+            const std::string file{lunaticvibes::s(f.path().filename().u8string())};
+            if (auto it = journal.find(file); it != journal.end())
             {
-                threadPool = (void*)new boost::asio::thread_pool(poolThreadCount);
+                std::error_code ec;
+                const auto size = static_cast<long long>(f.file_size(ec));
+                if (!ec && it->second.size == size && it->second.modtime == getFileLastWriteTime(f))
+                    continue;
             }
-            boost::asio::thread_pool& pool = *(boost::asio::thread_pool*)threadPool;
-            boost::asio::post(pool, std::bind_front(&SongDB::addChart, this, hash, p));
-            count++;
-        }
 
-        if (hasDeletedEntry || hasModifiedEntry || count > 0)
-        {
-            // update modification time
-            // saving current time here is OK.
-            long long nowTime = getFileTimeNow();
-            if (int ret = exec("UPDATE folder SET modtime=? WHERE pathmd5=?", {nowTime, hash.hexdigest()});
-                ret != SQLITE_OK)
-            {
-                LOG_WARNING << "[SongDB] Update modification time fail: [" << ret << "] " << errmsg() << " (" << path
-                            << ")";
-            }
+            addChartTask(hash, fs::absolute(f), scan);
+            count++;
         }
+        finishFolderTask(scan);
 
-        LOG_DEBUG << "[SongDB] Folder originally has " << existedFiles.size() << " entries, added " << count << " ("
+        LOG_DEBUG << "[SongDB] Folder originally has " << existedCount << " entries, checking " << count << " ("
                   << path << ")";
         return count;
     }
@@ -967,7 +1074,6 @@ int SongDB::refreshExistingFolder(const HashMD5& hash, const Path& path, FolderT
 
         // get folders from db
         std::vector<Path> existedFiles;
-        bool hasDeletedEntry = false;
         auto existedList = browse(hash, false);
         if (existedList && !existedList->empty())
         {
@@ -989,7 +1095,6 @@ int SongDB::refreshExistingFolder(const HashMD5& hash, const Path& path, FolderT
                         deletedFiles.push_back(existedList->getEntry(i)->md5);
                     }
                 }
-                hasDeletedEntry = !deletedFiles.empty();
                 for (auto& folderMD5 : deletedFiles)
                 {
                     removeFolder(folderMD5);
@@ -998,9 +1103,7 @@ int SongDB::refreshExistingFolder(const HashMD5& hash, const Path& path, FolderT
         }
 
         // just add new entries
-        int count = 0;
-
-        std::vector<Path> subFolders;
+        size_t subFolderCount = 0;
         for (auto& f : fs::directory_iterator(path))
         {
             if (stopRequested)
@@ -1009,27 +1112,69 @@ int SongDB::refreshExistingFolder(const HashMD5& hash, const Path& path, FolderT
             }
             if (fs::is_directory(f))
             {
-                int addedCount = addSubFolder(f, hash);
-                if (addedCount > 0)
-                    count += addedCount;
+                addSubFolderTask(f, hash, scan);
+                ++subFolderCount;
             }
         }
+        finishFolderTask(scan);
 
-        if (hasDeletedEntry || count > 0)
-        {
-            // update modification time
-            // saving current time here is OK.
-            long long nowTime = getFileTimeNow();
-            if (int ret = exec("UPDATE folder SET modtime=? WHERE pathmd5=?", {nowTime, hash.hexdigest()});
-                ret != SQLITE_OK)
-            {
-                LOG_WARNING << "[SongDB] Update modification time fail: [" << ret << "] " << errmsg() << " (" << path
-                            << ")";
-            }
-        }
+        LOG_DEBUG << "[SongDB] Checking " << subFolderCount << " subfolders of " << path;
+        return 0;
+    }
+}
 
-        LOG_DEBUG << "[SongDB] Checking for new subfolders finished. Added " << count << " entries from " << path;
-        return count;
+int SongDB::refreshSubFolders(const HashMD5& hash)
+{
+    for (const auto& sub : getSubFolders(hash))
+    {
+        if (stopRequested)
+            break;
+
+        // removed folders change the modification time of their parent, so they are not expected here
+        if (!fs::is_directory(sub))
+            continue;
+
+        addSubFolderTask(sub, hash);
+    }
+    return 0;
+}
+
+void SongDB::addSubFolderTask(const Path& path, const HashMD5& parent, std::shared_ptr<FolderScan> scan)
+{
+    if (scan)
+        ++scan->pending;
+    getThreadPool().post([this, path, parent, scan = std::move(scan)] {
+        addSubFolder(path, parent);
+        finishFolderTask(scan);
+    });
+}
+
+void SongDB::addChartTask(const HashMD5& folder, const Path& path, std::shared_ptr<FolderScan> scan)
+{
+    addChartTaskCount++;
+    if (scan)
+        ++scan->pending;
+    getThreadPool().post([this, folder, path, scan = std::move(scan)] {
+        addChart(folder, path);
+        finishFolderTask(scan);
+    });
+}
+
+void SongDB::finishFolderTask(const std::shared_ptr<FolderScan>& scan)
+{
+    // Tasks running while loading stops may have skipped entries, and queued ones are dropped.
+    if (!scan || stopRequested)
+        return;
+    if (--scan->pending == 0)
+        updateFolderModifyTime(scan->hash, scan->path, scan->modtime);
+}
+
+void SongDB::updateFolderModifyTime(const HashMD5& hash, const Path& path, long long modtime)
+{
+    // Store the time of the folder itself, compared against on next refresh.
+    if (int ret = exec("UPDATE folder SET modtime=? WHERE pathmd5=?", {modtime, hash.hexdigest()}); ret != SQLITE_OK)
+    {
+        LOG_WARNING << "[SongDB] Update modification time fail: [" << ret << "] " << errmsg() << " (" << path << ")";
     }
 }
 
@@ -1072,8 +1217,7 @@ std::pair<bool, Path> SongDB::getFolderPath(const HashMD5& folder) const
     {
         if (auto it = folderQueryHashMap.find(folder); it != folderQueryHashMap.end())
         {
-            auto cols = folderQueryPool[it->second[0]];
-            return {true, PathFromUTF8(ANY_STR(cols[4]))};
+            return {true, PathFromUTF8(folderQueryPool[it->second[0]].path)};
         }
     }
     else
@@ -1135,13 +1279,7 @@ std::shared_ptr<EntryFolderRegular> SongDB::browse(const HashMD5& root, bool rec
     {
         for (const auto& index : it->second)
         {
-            const auto& c = folderQueryPool[index];
-            HashMD5 md5{ANY_STR(c[0])};
-            // auto parent = ANY_STR(c[1]);
-            auto name = ANY_STR(c[2]);
-            auto type = (FolderType)ANY_INT(c[3]);
-            auto path = ANY_STR(c[4]);
-            auto modtime = ANY_INT(c[5]);
+            const auto& [md5, name, type, path, modtime] = folderQueryPool[index];
 
             switch (type)
             {
@@ -1200,39 +1338,30 @@ std::shared_ptr<EntryFolderSong> SongDB::browseSong(const HashMD5& root)
     if (auto it = songQueryParentMap.find(root); it != songQueryParentMap.end())
     {
         for (const auto& index : it->second)
-            try
+        {
+            const auto& c = songQueryPool[index];
+            switch ((eChartFormat)c.type)
             {
-                const auto& c = songQueryPool[index];
-                auto type = (eChartFormat)ANY_INT(c[3]);
-                switch (type)
-                {
-                case eChartFormat::BMS: {
-                    auto p = std::make_shared<ChartFormatBMSMeta>();
-                    if (convert_bms(p, c))
-                    {
-                        if (p->fileName.is_absolute())
-                            p->absolutePath = p->fileName;
-                        else
-                            p->absolutePath = path / p->fileName;
+            case eChartFormat::BMS: {
+                auto p = std::make_shared<ChartFormatBMSMeta>();
+                convert_bms(p, c);
+                if (p->fileName.is_absolute())
+                    p->absolutePath = p->fileName;
+                else
+                    p->absolutePath = path / p->fileName;
 
-                        list->pushChart(p);
-                    }
-                    if (!isNameSet)
-                    {
-                        isNameSet = true;
-                        list->_name = p->title;
-                        list->_name2 = p->title2;
-                    }
-                    break;
-                }
-                default: break;
+                list->pushChart(p);
+                if (!isNameSet)
+                {
+                    isNameSet = true;
+                    list->_name = p->title;
+                    list->_name2 = p->title2;
                 }
+                break;
             }
-            // TODO: remove after adding NOT NULL to every table field.
-            catch (const std::bad_any_cast& e)
-            {
-                LOG_ERROR << "std::bad_any_cast: " << e.what();
+            default: break;
             }
+        }
     }
 
     LOG_VERBOSE << "[SongDB] browsed song: " << list->getContentsCount() << " entries";
@@ -1273,15 +1402,14 @@ void SongDB::resetAddSummary()
 
 void SongDB::stopLoading()
 {
+    stopRequested = true;
+
+    std::unique_lock l(threadPoolMutex);
     if (threadPool)
     {
-        // stop all tasks
-        boost::asio::thread_pool& pool = *(boost::asio::thread_pool*)threadPool;
-        pool.stop();
-
-        // The old pool is not valid anymore, removing
-        delete (boost::asio::thread_pool*)threadPool;
-        threadPool = nullptr;
+        // Drop pending tasks, running ones see stopRequested. The folders they belong to keep their old modification
+        // time, see finishFolderTask(), so the next scan lists them again.
+        if (size_t dropped = threadPool->cancel(); dropped > 0)
+            LOG_INFO << "[SongDB] Loading stopped, " << dropped << " pending tasks are left for the next scan";
     }
-    stopRequested = true;
 }
@@ -1,13 +1,22 @@
 #pragma once
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <shared_mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <common/entry/entry_song.h>
 #include <common/types.h>
 #include <db/db_conn.h>
 
+namespace lunaticvibes
+{
+class WorkStealingPool;
+} // namespace lunaticvibes
+
 // FIXME: use "__root_folder" or something, currently something somewhere assumes empty string here.
 inline const HashMD5 ROOT_FOLDER_HASH = md5({});
 
@@ -37,6 +46,10 @@ protected:
     bool removeChart(const Path& path, const HashMD5& parent);
     bool removeChart(const HashMD5& md5, const HashMD5& parent);
 
+protected:
+    // False if the FTS5 migration failed, e.g. SQLite built without FTS5. Searches then use LIKE only.
+    bool haveSearchIndex = false;
+
 public:
     // Search from genre, version, artist, artist2, title, title2.
     [[nodiscard]] std::vector<std::shared_ptr<ChartFormatBase>> findChartByName(const HashMD5& folder,
@@ -48,11 +61,23 @@ public:
     [[nodiscard]] std::vector<std::shared_ptr<ChartFormatBase>> findChartFromTime(const HashMD5& folder,
                                                                                   unsigned long long addTime) const;
 
+public:
+    // Decoded row of the song table, defined in db_song.cpp.
+    struct SongRow;
+
 protected:
-    std::vector<std::vector<std::any>> songQueryPool;
+    struct FolderRow
+    {
+        HashMD5 hash;
+        std::string name;
+        FolderType type;
+        std::string path;
+        long long modtime;
+    };
+    std::vector<SongRow> songQueryPool;
     std::unordered_map<HashMD5, std::vector<size_t>> songQueryHashMap;
     std::unordered_map<HashMD5, std::vector<size_t>> songQueryParentMap;
-    std::vector<std::vector<std::any>> folderQueryPool;
+    std::vector<FolderRow> folderQueryPool;
     std::unordered_map<HashMD5, std::vector<size_t>> folderQueryHashMap;
     std::unordered_map<HashMD5, std::vector<size_t>> folderQueryParentMap;
 
@@ -61,14 +86,56 @@ public:
     void freeCache();
 
 public:
+    // Returns the number of charts checked, unchanged ones included.
     int initializeFolders(const std::vector<Path>& paths);
+    // Sub folders are walked on the thread pool, the count only includes charts of this folder.
+    // Call waitLoadingFinish() to wait for the whole tree.
     int addSubFolder(Path path, const HashMD5& parent = ROOT_FOLDER_HASH);
     void waitLoadingFinish();
+    // Thread count of the pool walking folders and parsing charts. 0 for hardware concurrency.
+    void setThreadCount(unsigned count);
     int removeFolder(const HashMD5& hash, bool removeSong = false);
 
 protected:
     int addNewFolder(const HashMD5& hash, const Path& path, const HashMD5& parent);
     int refreshExistingFolder(const HashMD5& hash, const Path& path, FolderType type);
+    int refreshSubFolders(const HashMD5& hash);
+    // Tasks posted for the entries of one folder, defined in db_song.cpp. The modification time of the folder is only
+    // stored once all of them have finished, so a folder whose tasks were dropped is listed again by the next scan.
+    struct FolderScan;
+    void addSubFolderTask(const Path& path, const HashMD5& parent, std::shared_ptr<FolderScan> scan = nullptr);
+    void addChartTask(const HashMD5& folder, const Path& path, std::shared_ptr<FolderScan> scan = nullptr);
+    void finishFolderTask(const std::shared_ptr<FolderScan>& scan);
+    void updateFolderModifyTime(const HashMD5& hash, const Path& path, long long modtime);
+
+protected:
+    // State of files and folders from the last scan. Folders whose modification time did not change are not listed
+    // again, and chart files with the same size and modification time are not hashed again.
+    struct FileState
+    {
+        long long size;
+        long long modtime;
+        HashMD5 md5;
+    };
+    struct FolderState
+    {
+        HashMD5 hash;
+        FolderType type;
+        long long modtime;
+    };
+    // Loaded in initializeFolders(), otherwise these are queried per folder.
+    bool journalLoaded = false;
+    std::unordered_map<std::string, FolderState> folderJournal;                          // path -> state
+    std::unordered_map<HashMD5, std::vector<Path>> subFolderJournal;                      // parent -> paths
+    std::unordered_map<HashMD5, std::unordered_map<std::string, FileState>> fileJournal; // parent -> file -> state
+
+    void loadJournal();
+    void freeJournal();
+    [[nodiscard]] std::optional<FolderState> findFolderState(const Path& path) const;
+    [[nodiscard]] std::vector<Path> getSubFolders(const HashMD5& hash) const;
+    [[nodiscard]] std::unordered_map<std::string, FileState> getFileJournal(const HashMD5& hash) const;
+    void updateFileJournal(const HashMD5& folder, const Path& path, long long size, long long modtime,
+                           const HashMD5& md5);
 
 public:
     HashMD5 getFolderParent(const HashMD5& folder) const;
@@ -81,20 +148,24 @@ public:
     std::shared_ptr<EntryFolderRegular> search(const HashMD5& root, const std::string& key);
 
 private:
-    void* threadPool = nullptr;
-    int poolThreadCount = 4;
+    std::mutex threadPoolMutex;
+    std::shared_ptr<lunaticvibes::WorkStealingPool> threadPool;
+    unsigned poolThreadCount = 4;
+
+protected:
+    lunaticvibes::WorkStealingPool& getThreadPool();
 
 public:
-    int addChartTaskCount = 0;
-    int addChartTaskFinishCount = 0;
-    int addChartSuccess = 0;
-    int addChartModified = 0;
-    int addChartDeleted = 0;
+    std::atomic<int> addChartTaskCount = 0;
+    std::atomic<int> addChartTaskFinishCount = 0;
+    std::atomic<int> addChartSuccess = 0;
+    std::atomic<int> addChartModified = 0;
+    std::atomic<int> addChartDeleted = 0;
 
     std::shared_mutex addCurrentPathMutex;
     std::string addCurrentPath;
     void resetAddSummary();
 
-    bool stopRequested = false;
+    std::atomic<bool> stopRequested = false;
     void stopLoading();
 };
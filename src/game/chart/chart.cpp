@@ -151,8 +151,8 @@ chart::NoteLaneIndex chart::KeyToLane(int keys, Input::Pad pad)
 }
 
 ChartObjectBase::ChartObjectBase(int slot, size_t pn, size_t en)
-    : _playerSlot(slot), _noteLists{}, _bgmNoteLists(pn), _specialNoteLists(en), _bgmNoteListIters(pn),
-      _specialNoteListIters(en)
+    : _playerSlot(slot), _noteLists{}, _bgmNoteLists(pn), _specialNoteLists(en), _bgmNoteListCursors(pn),
+      _specialNoteListCursors(en)
 {
     reset();
     _bpmNoteList.clear();
@@ -203,13 +203,10 @@ void ChartObjectBase::reset()
 
 void ChartObjectBase::resetNoteListsIterators()
 {
-    for (size_t i = 0; i < _noteLists.size(); ++i)
-        _noteListIterators[i] = _noteLists[i].begin();
-    for (size_t i = 0; i < _bgmNoteLists.size(); ++i)
-        _bgmNoteListIters[i] = _bgmNoteLists[i].begin();
-    for (size_t i = 0; i < _specialNoteLists.size(); ++i)
-        _specialNoteListIters[i] = _specialNoteLists[i].begin();
-    _bpmNoteListIter = _bpmNoteList.begin();
+    _noteListCursors.fill(0);
+    std::fill(_bgmNoteListCursors.begin(), _bgmNoteListCursors.end(), 0);
+    std::fill(_specialNoteListCursors.begin(), _specialNoteListCursors.end(), 0);
+    _bpmNoteListCursor = 0;
 }
 
 auto ChartObjectBase::firstNote(NoteLaneCategory cat, size_t idx) -> NoteIterator
@@ -221,73 +218,74 @@ auto ChartObjectBase::firstNote(NoteLaneCategory cat, size_t idx) -> NoteIterato
 auto ChartObjectBase::incomingNote(NoteLaneCategory cat, size_t idx) -> NoteIterator
 {
     size_t channel = channelToIdx(cat, idx);
-    return _noteListIterators[channel];
+    return _noteLists[channel].begin() + _noteListCursors[channel];
 }
 
 auto ChartObjectBase::incomingNoteBgm(size_t channel) -> decltype(_bgmNoteLists)::value_type::iterator
 {
-    return _bgmNoteListIters[channel];
+    return _bgmNoteLists[channel].begin() + _bgmNoteListCursors[channel];
 }
 auto ChartObjectBase::incomingNoteSpecial(size_t channel) -> decltype(_specialNoteLists)::value_type::iterator
 {
-    return _specialNoteListIters[channel];
+    return _specialNoteLists[channel].begin() + _specialNoteListCursors[channel];
 }
 auto ChartObjectBase::incomingNoteBpm() -> decltype(_bpmNoteList)::iterator
 {
-    return _bpmNoteListIter;
+    return _bpmNoteList.begin() + _bpmNoteListCursor;
 }
 bool ChartObjectBase::isLastNote(NoteLaneCategory cat, size_t idx, const NoteIterator& it) const
 {
     size_t channel = channelToIdx(cat, idx);
-    return _noteLists[channel].empty() || it == _noteLists[channel].end();
+    return it == _noteLists[channel].end();
 }
 bool ChartObjectBase::isLastNoteBgm(size_t idx, const decltype(_bgmNoteLists)::value_type::iterator& it) const
 {
-    return _bgmNoteLists[idx].empty() || it == _bgmNoteLists[idx].end();
+    return it == _bgmNoteLists[idx].end();
 }
 bool ChartObjectBase::isLastNoteSpecial(size_t idx, const decltype(_specialNoteLists)::value_type::iterator& it) const
 {
-    return _specialNoteLists[idx].empty() || it == _specialNoteLists[idx].end();
+    return it == _specialNoteLists[idx].end();
 }
 bool ChartObjectBase::isLastNoteBpm(const decltype(_bpmNoteList)::iterator& it) const
 {
-    return _bpmNoteList.empty() || it == _bpmNoteList.end();
+    return it == _bpmNoteList.end();
 }
 
 bool ChartObjectBase::isLastNote(NoteLaneCategory cat, size_t idx)
 {
-    return isLastNote(cat, idx, incomingNote(cat, idx));
+    size_t channel = channelToIdx(cat, idx);
+    return _noteListCursors[channel] >= _noteLists[channel].size();
 }
 bool ChartObjectBase::isLastNoteBgm(size_t channel)
 {
-    return isLastNoteBgm(channel, incomingNoteBgm(channel));
+    return _bgmNoteListCursors[channel] >= _bgmNoteLists[channel].size();
 }
 bool ChartObjectBase::isLastNoteSpecial(size_t channel)
 {
-    return isLastNoteSpecial(channel, incomingNoteSpecial(channel));
+    return _specialNoteListCursors[channel] >= _specialNoteLists[channel].size();
 }
 bool ChartObjectBase::isLastNoteBpm()
 {
-    return isLastNoteBpm(incomingNoteBpm());
+    return _bpmNoteListCursor >= _bpmNoteList.size();
 }
 
-auto ChartObjectBase::nextNote(NoteLaneCategory cat, size_t idx) -> NoteIterator&
+auto ChartObjectBase::nextNote(NoteLaneCategory cat, size_t idx) -> NoteIterator
 {
     size_t channel = channelToIdx(cat, idx);
-    return ++_noteListIterators[channel];
+    return _noteLists[channel].begin() + ++_noteListCursors[channel];
 }
 
-auto ChartObjectBase::nextNoteBgm(size_t channel) -> decltype(_bgmNoteLists)::value_type::iterator&
+auto ChartObjectBase::nextNoteBgm(size_t channel) -> decltype(_bgmNoteLists)::value_type::iterator
 {
-    return ++_bgmNoteListIters[channel];
+    return _bgmNoteLists[channel].begin() + ++_bgmNoteListCursors[channel];
 }
-auto ChartObjectBase::nextNoteSpecial(size_t channel) -> decltype(_specialNoteLists)::value_type::iterator&
+auto ChartObjectBase::nextNoteSpecial(size_t channel) -> decltype(_specialNoteLists)::value_type::iterator
 {
-    return ++_specialNoteListIters[channel];
+    return _specialNoteLists[channel].begin() + ++_specialNoteListCursors[channel];
 }
-auto ChartObjectBase::nextNoteBpm() -> decltype(_bpmNoteList)::iterator&
+auto ChartObjectBase::nextNoteBpm() -> decltype(_bpmNoteList)::iterator
 {
-    return ++_bpmNoteListIter;
+    return _bpmNoteList.begin() + ++_bpmNoteListCursor;
 }
 
 lunaticvibes::Time ChartObjectBase::getBarLength(size_t bar)
@@ -364,60 +362,38 @@ void ChartObjectBase::update(const lunaticvibes::Time& rt)
     }
 
     // Skip expired notes
-    for (auto cat_i = static_cast<size_t>(NoteLaneCategory::Note);
-         cat_i < static_cast<size_t>(NoteLaneCategory::NOTECATEGORY_COUNT); ++cat_i)
+    for (size_t ch = 0; ch < LANE_ALL_KEY_COUNT; ++ch)
     {
-        const auto cat = static_cast<NoteLaneCategory>(cat_i);
-        for (size_t idx_i = Sc1; idx_i < NOTELANEINDEX_COUNT; ++idx_i)
-        {
-            const NoteLaneIndex idx{idx_i};
-            auto it = incomingNote(cat, idx);
-            while (!isLastNote(cat, idx, it) && vt >= it->time && it->expired)
-            {
-                noteExpired.push_back(*it);
-                it = nextNote(cat, idx);
-            }
-        }
+        const auto& lane = _noteLists[ch];
+        auto& cursor = _noteListCursors[ch];
+        while (cursor < lane.size() && vt >= lane[cursor].time && lane[cursor].expired)
+            noteExpired.push_back(lane[cursor++]);
     }
 
     // Skip expired barline
+    for (size_t ch : {LANE_BARLINE_1P, LANE_BARLINE_2P})
     {
-        NoteLaneCategory cat = NoteLaneCategory::EXTRA;
-        NoteLaneIndex idx = (NoteLaneIndex)EXTRA_BARLINE_1P;
-        auto it = incomingNote(cat, idx);
-        while (!isLastNote(cat, idx, it) && vt >= it->time)
-        {
-            it->expired = true;
-            it = nextNote(cat, idx);
-        }
-        idx = (NoteLaneIndex)EXTRA_BARLINE_2P;
-        it = incomingNote(cat, idx);
-        while (!isLastNote(cat, idx, it) && vt >= it->time)
-        {
-            it->expired = true;
-            it = nextNote(cat, idx);
-        }
+        auto& lane = _noteLists[ch];
+        auto& cursor = _noteListCursors[ch];
+        while (cursor < lane.size() && vt >= lane[cursor].time)
+            lane[cursor++].expired = true;
     }
 
     // Skip expired plain note
     for (size_t idx = 0; idx < _bgmNoteLists.size(); ++idx)
     {
-        auto it = incomingNoteBgm(idx);
-        while (!isLastNoteBgm(idx) && at >= it->time)
-        {
-            noteBgmExpired.push_back(*it);
-            it = nextNoteBgm(idx);
-        }
+        const auto& list = _bgmNoteLists[idx];
+        auto& cursor = _bgmNoteListCursors[idx];
+        while (cursor < list.size() && at >= list[cursor].time)
+            noteBgmExpired.push_back(list[cursor++]);
     }
     // Skip expired extended note
     for (size_t idx = 0; idx < _specialNoteLists.size(); ++idx)
     {
-        auto it = incomingNoteSpecial(idx);
-        while (!isLastNoteSpecial(idx) && vt >= it->time)
-        {
-            noteSpecialExpired.push_back(*it);
-            it = nextNoteSpecial(idx);
-        }
+        const auto& list = _specialNoteLists[idx];
+        auto& cursor = _specialNoteListCursors[idx];
+        while (cursor < list.size() && vt >= list[cursor].time)
+            noteSpecialExpired.push_back(list[cursor++]);
     }
 
     // update beat
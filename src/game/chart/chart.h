@@ -2,7 +2,6 @@
 
 #include <array>
 #include <limits>
-#include <list>
 #include <utility>
 #include <vector>
 
@@ -147,10 +146,12 @@ public:
 
 protected:
     // full list of corresponding channel through all measures; only this list is handled by input looper
-    std::array<std::list<HitableNote>, chart::LANE_COUNT> _noteLists;
-    std::vector<std::list<Note>> _bgmNoteLists;     // BGM notes; handled with timer
-    std::vector<std::list<Note>> _specialNoteLists; // Special definitions for each format. e.g. BGA, Stop
-    std::list<Note> _bpmNoteList;                   // BPM change is so common that they are not special
+    // Lanes are filled once while loading and never resized afterwards, so they are kept contiguous and walked with
+    // index cursors. Iterators returned by incomingNote() and friends stay valid as long as the chart object lives.
+    std::array<std::vector<HitableNote>, chart::LANE_COUNT> _noteLists;
+    std::vector<std::vector<Note>> _bgmNoteLists;     // BGM notes; handled with timer
+    std::vector<std::vector<Note>> _specialNoteLists; // Special definitions for each format. e.g. BGA, Stop
+    std::vector<Note> _bpmNoteList;                   // BPM change is so common that they are not special
 
 protected:
     std::vector<Metre> barMetreLength;
@@ -175,10 +176,11 @@ public:
     using NoteIterator = decltype(_noteLists)::value_type::iterator;
 
 protected:
-    std::array<NoteIterator, chart::LANE_COUNT> _noteListIterators;
-    std::vector<decltype(_bgmNoteLists)::value_type::iterator> _bgmNoteListIters;
-    std::vector<decltype(_specialNoteLists)::value_type::iterator> _specialNoteListIters;
-    decltype(_bpmNoteList)::iterator _bpmNoteListIter;
+    // index of the incoming note of each list
+    std::array<size_t, chart::LANE_COUNT> _noteListCursors{};
+    std::vector<size_t> _bgmNoteListCursors;
+    std::vector<size_t> _specialNoteListCursors;
+    size_t _bpmNoteListCursor = 0;
 
 public:
     auto firstNote(chart::NoteLaneCategory cat, size_t idx) -> NoteIterator;
@@ -199,10 +201,10 @@ public:
     bool isLastNoteBpm(const decltype(_bpmNoteList)::iterator& it) const;
 
 protected:
-    auto nextNote(chart::NoteLaneCategory cat, size_t idx) -> NoteIterator&;
-    auto nextNoteBgm(size_t idx) -> decltype(_bgmNoteLists)::value_type::iterator&;
-    auto nextNoteSpecial(size_t idx) -> decltype(_specialNoteLists)::value_type::iterator&;
-    auto nextNoteBpm() -> decltype(_bpmNoteList)::iterator&;
+    auto nextNote(chart::NoteLaneCategory cat, size_t idx) -> NoteIterator;
+    auto nextNoteBgm(size_t idx) -> decltype(_bgmNoteLists)::value_type::iterator;
+    auto nextNoteSpecial(size_t idx) -> decltype(_specialNoteLists)::value_type::iterator;
+    auto nextNoteBpm() -> decltype(_bpmNoteList)::iterator;
 
 public:
     lunaticvibes::Time getBarLength(size_t bar);
@@ -11,8 +11,7 @@
 using namespace chart;
 
 ChartObjectBMS::ChartObjectBMS(int slot)
-    : ChartObjectBase(slot, BGM_LANE_COUNT, (size_t)eNoteExt::EXT_COUNT),
-      _currentStopNote(_specialNoteLists.front().begin())
+    : ChartObjectBase(slot, BGM_LANE_COUNT, (size_t)eNoteExt::EXT_COUNT)
 {
 }
 
@@ -756,7 +755,7 @@ void ChartObjectBMS::loadBMS(const ChartFormatBMS& objBms)
                 if (_bgmNoteLists.size() <= lane.index)
                 {
                     _bgmNoteLists.resize(lane.index + 1);
-                    _bgmNoteListIters.resize(lane.index + 1);
+                    _bgmNoteListCursors.resize(lane.index + 1);
                 }
                 _bgmNoteLists[lane.index].emplace_back(m, notemetre, notetime, 0, (long long)val, 0.);
             }
@@ -907,7 +906,7 @@ void ChartObjectBMS::loadBMS(const ChartFormatBMS& objBms)
     }
 
     resetNoteListsIterators();
-    _currentStopNote = incomingNoteSpecial(size_t(eNoteExt::STOP));
+    _currentStopNote = 0;
 }
 
 NoteLaneIndex ChartObjectBMS::getLaneFromKey(NoteLaneCategory cat, Input::Pad input)
@@ -929,22 +928,23 @@ std::vector<Input::Pad> ChartObjectBMS::getInputFromLane(size_t channel)
 void ChartObjectBMS::preUpdate(const lunaticvibes::Time& vt)
 {
     // check stop
-    size_t idx = (size_t)eNoteExt::STOP;
+    const auto& stops = _specialNoteLists[(size_t)eNoteExt::STOP];
     _inStopNote = false;
-    while (!isLastNoteSpecial(idx, _currentStopNote))
+    while (_currentStopNote < stops.size())
     {
-        if (vt.hres() > _currentStopNote->time.hres() + _currentStopNote->dvalue)
+        const auto& stop = stops[_currentStopNote];
+        if (vt.hres() > stop.time.hres() + stop.dvalue)
         {
-            _stopMetre += _currentStopNote->fvalue;
-            _stopBar = _currentStopNote->measure;
+            _stopMetre += stop.fvalue;
+            _stopBar = stop.measure;
             ++_currentStopNote;
         }
-        else if (vt >= _currentStopNote->time)
+        else if (vt >= stop.time)
         {
             _inStopNote = true;
             break;
         }
-        else // t < _currentStopNote->time
+        else // t < stop.time
         {
             break;
         }
@@ -964,7 +964,8 @@ void ChartObjectBMS::postUpdate(const lunaticvibes::Time& vt)
 {
     if (_inStopNote)
     {
-        _currentMetreTemp = _currentStopNote->pos - _barMetrePos[_currentStopNote->measure];
+        const auto& stop = _specialNoteLists[(size_t)eNoteExt::STOP][_currentStopNote];
+        _currentMetreTemp = stop.pos - _barMetrePos[stop.measure];
     }
     else if (_stopBar == _currentBarTemp)
     {
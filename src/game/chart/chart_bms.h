@@ -47,7 +47,7 @@ protected:
     void loadBMS(const ChartFormatBMS& bms);
 
 protected:
-    decltype(_specialNoteLists.front().begin()) _currentStopNote;
+    size_t _currentStopNote = 0; // index into the STOP list
     bool _inStopNote = false;
     double _stopMetre = 0.0;
     size_t _stopBar = 0;
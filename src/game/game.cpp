@@ -14,6 +14,7 @@
 #include <game/arena/arena_data.h>
 #include <game/arena/arena_host.h>
 #include <game/graphics/graphics.h>
+#include <game/graphics/texture_cache.h>
 #include <game/input/input_mgr.h>
 #include <game/runtime/generic_info.h>
 #include <game/runtime/i18n.h>
@@ -300,6 +301,7 @@ int main(int argc, char* argv[])
 
     SoundMgr::stopUpdate();
 
+    lunaticvibes::graphics::TextureCache::shared().purge();
     graphics_free();
 
     ImGui::DestroyContext();
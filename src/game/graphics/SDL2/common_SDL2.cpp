@@ -2,8 +2,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <memory>
+#include <numbers>
 #include <string_view>
+#include <vector>
 
 #include <SDL2_gfxPrimitives.h>
 
@@ -203,11 +206,221 @@ void Image::setTransparentColorRGB(Color c)
     }
 }
 
+// Pixels of the key color become fully transparent. A plain select, so the compiler can vectorize it.
+static void applyColorKey(uint32_t* pixels, size_t count, uint32_t rgbMask, uint32_t key)
+{
+    for (size_t i = 0; i < count; ++i)
+        pixels[i] = (pixels[i] & rgbMask) == key ? 0 : pixels[i];
+}
+
+Image Image::withTransparentColorRGB(Color c) const
+{
+    Image img = *this;
+    if (!_pSurface)
+        return img;
+
+    const SDL_PixelFormat* fmt = _pSurface->format;
+    const int w = _pSurface->w;
+    const int h = _pSurface->h;
+    std::shared_ptr<SDL_Surface> surface;
+    if (fmt->palette && fmt->BitsPerPixel == 8)
+    {
+        // the key is a palette index, as with SDL_SetColorKey
+        surface = std::shared_ptr<SDL_Surface>(SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32),
+                                               SDL_FreeSurface);
+        if (surface)
+        {
+            const Uint32 keyIndex = SDL_MapRGB(fmt, c.r, c.g, c.b);
+            std::array<uint32_t, 256> lut{};
+            for (int i = 0; i < std::min(fmt->palette->ncolors, 256); ++i)
+            {
+                const SDL_Color& pc = fmt->palette->colors[i];
+                if (static_cast<Uint32>(i) != keyIndex)
+                    lut[i] = SDL_MapRGBA(surface->format, pc.r, pc.g, pc.b, pc.a);
+            }
+            SDL_LockSurface(&*_pSurface);
+            SDL_LockSurface(&*surface);
+            for (int y = 0; y < h; ++y)
+            {
+                const auto* src =
+                    static_cast<const uint8_t*>(_pSurface->pixels) + static_cast<size_t>(y) * _pSurface->pitch;
+                auto* dst = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(surface->pixels) +
+                                                        static_cast<size_t>(y) * surface->pitch);
+                for (int x = 0; x < w; ++x)
+                    dst[x] = lut[src[x]];
+            }
+            SDL_UnlockSurface(&*surface);
+            SDL_UnlockSurface(&*_pSurface);
+        }
+    }
+    else if (!fmt->palette && fmt->Amask == 0 && fmt->BytesPerPixel >= 3)
+    {
+        // opaque truecolor, every other pixel keeps full alpha
+        surface = std::shared_ptr<SDL_Surface>(SDL_ConvertSurfaceFormat(&*_pSurface, SDL_PIXELFORMAT_RGBA32, 0),
+                                               SDL_FreeSurface);
+        if (surface)
+        {
+            const SDL_PixelFormat* dfmt = surface->format;
+            const uint32_t rgbMask = dfmt->Rmask | dfmt->Gmask | dfmt->Bmask;
+            const uint32_t key = SDL_MapRGB(dfmt, c.r, c.g, c.b) & rgbMask;
+            SDL_LockSurface(&*surface);
+            for (int y = 0; y < h; ++y)
+                applyColorKey(reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(surface->pixels) +
+                                                          static_cast<size_t>(y) * surface->pitch),
+                              static_cast<size_t>(w), rgbMask, key);
+            SDL_UnlockSurface(&*surface);
+        }
+    }
+    else
+    {
+        // alpha blends through the color key, leave that to SDL
+        img._pSurface = std::shared_ptr<SDL_Surface>(SDL_DuplicateSurface(&*_pSurface), SDL_FreeSurface);
+        if (img._pSurface)
+        {
+            img.setTransparentColorRGB(c);
+            return img;
+        }
+    }
+
+    img._pSurface = surface;
+    img.loaded = surface != nullptr;
+    return img;
+}
+
 Rect Image::getRect() const
 {
     return {0, 0, _pSurface->w, _pSurface->h};
 }
 
+std::vector<uint32_t> Image::getARGB() const
+{
+    if (!_pSurface)
+        return {};
+    // color key turns into alpha here, same as with SDL_CreateTextureFromSurface
+    auto surface = std::shared_ptr<SDL_Surface>(SDL_ConvertSurfaceFormat(&*_pSurface, SDL_PIXELFORMAT_ARGB8888, 0),
+                                                SDL_FreeSurface);
+    if (!surface)
+        return {};
+
+    std::vector<uint32_t> pixels(static_cast<size_t>(surface->w) * surface->h);
+    SDL_LockSurface(&*surface);
+    for (int y = 0; y < surface->h; ++y)
+        std::memcpy(&pixels[static_cast<size_t>(y) * surface->w],
+                    static_cast<const uint8_t*>(surface->pixels) + static_cast<size_t>(y) * surface->pitch,
+                    static_cast<size_t>(surface->w) * 4);
+    SDL_UnlockSurface(&*surface);
+    return pixels;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Sprite batch
+
+// Consecutive Texture::draw calls sharing the same texture and blend mode are collected here and submitted with a
+// single SDL_RenderGeometry call. Filtering is covered by the texture key, as each filter has its own SDL_Texture.
+struct SpriteBatch
+{
+    SDL_Texture* texture = nullptr;
+    SDL_BlendMode blendMode = SDL_BLENDMODE_INVALID;
+    int textureW = 0;
+    int textureH = 0;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+};
+static SpriteBatch spriteBatch;
+static unsigned drawCallCount = 0;
+static unsigned drawCallCountLastFrame = 0;
+
+void lunaticvibes::graphics::flush_sprite_batch()
+{
+    if (spriteBatch.vertices.empty())
+        return;
+
+    // Color and alpha are carried by the vertices.
+    SDL_SetTextureBlendMode(spriteBatch.texture, spriteBatch.blendMode);
+    SDL_SetTextureColorMod(spriteBatch.texture, 255, 255, 255);
+    SDL_SetTextureAlphaMod(spriteBatch.texture, 255);
+    if (SDL_RenderGeometry(gFrameRenderer, spriteBatch.texture, spriteBatch.vertices.data(),
+                           static_cast<int>(spriteBatch.vertices.size()), spriteBatch.indices.data(),
+                           static_cast<int>(spriteBatch.indices.size())) < 0)
+    {
+        LOG_ERROR << "[SDL2] SDL_RenderGeometry error: " << SDL_GetError();
+    }
+    ++drawCallCount;
+
+    spriteBatch.texture = nullptr;
+    spriteBatch.vertices.clear();
+    spriteBatch.indices.clear();
+}
+
+unsigned lunaticvibes::graphics::get_draw_call_count()
+{
+    return drawCallCountLastFrame;
+}
+
+void lunaticvibes::graphics::reset_draw_call_count()
+{
+    drawCallCountLastFrame = drawCallCount;
+    drawCallCount = 0;
+}
+
+// Same placement as SDL_RenderCopyExF: srcRect is clipped to the texture, angle is clockwise in degrees around
+// center, which is relative to the destination rect.
+static void batch_sprite(SDL_Texture* pTex, const SDL_BlendMode blendMode, const Rect* srcRect, const SDL_FRect& dst,
+                         const SDL_Color color, const double angle, const SDL_FPoint* center)
+{
+    if (pTex == nullptr)
+        return;
+
+    if (pTex != spriteBatch.texture || blendMode != spriteBatch.blendMode)
+    {
+        lunaticvibes::graphics::flush_sprite_batch();
+        if (SDL_QueryTexture(pTex, nullptr, nullptr, &spriteBatch.textureW, &spriteBatch.textureH) < 0 ||
+            spriteBatch.textureW <= 0 || spriteBatch.textureH <= 0)
+            return;
+        spriteBatch.texture = pTex;
+        spriteBatch.blendMode = blendMode;
+    }
+
+    SDL_Rect src{0, 0, spriteBatch.textureW, spriteBatch.textureH};
+    if (srcRect != nullptr && !SDL_IntersectRect(srcRect, &src, &src))
+        return;
+    const float u0 = static_cast<float>(src.x) / spriteBatch.textureW;
+    const float v0 = static_cast<float>(src.y) / spriteBatch.textureH;
+    const float u1 = static_cast<float>(src.x + src.w) / spriteBatch.textureW;
+    const float v1 = static_cast<float>(src.y + src.h) / spriteBatch.textureH;
+
+    const float cx = center ? center->x : dst.w / 2.f;
+    const float cy = center ? center->y : dst.h / 2.f;
+    float sinA = 0.f, cosA = 1.f;
+    if (angle != 0.0)
+    {
+        const double rad = angle * std::numbers::pi / 180.0;
+        sinA = static_cast<float>(std::sin(rad));
+        cosA = static_cast<float>(std::cos(rad));
+    }
+
+    const SDL_FPoint corners[4] = {{0.f, 0.f}, {dst.w, 0.f}, {dst.w, dst.h}, {0.f, dst.h}};
+    const SDL_FPoint uvs[4] = {{u0, v0}, {u1, v0}, {u1, v1}, {u0, v1}};
+    const int base = static_cast<int>(spriteBatch.vertices.size());
+    for (int i = 0; i < 4; ++i)
+    {
+        const float dx = corners[i].x - cx;
+        const float dy = corners[i].y - cy;
+        spriteBatch.vertices.push_back(
+            {{dst.x + cx + dx * cosA - dy * sinA, dst.y + cy + dx * sinA + dy * cosA}, color, uvs[i]});
+    }
+    for (int i : {0, 1, 2, 0, 2, 3})
+        spriteBatch.indices.push_back(base + i);
+}
+
+// A texture may be destroyed while quads referencing it are still batched.
+static void destroy_texture(SDL_Texture* pTexture)
+{
+    if (pTexture == spriteBatch.texture)
+        lunaticvibes::graphics::flush_sprite_batch();
+    SDL_DestroyTexture(pTexture);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Texture
 
@@ -219,11 +432,11 @@ Texture::Texture(const Image& srcImage)
     _textures[0] = std::shared_ptr<SDL_Texture>(
         pushAndWaitMainThreadTask<SDL_Texture*>(
             std::bind_front(SDL_CreateTextureFromSurface, gFrameRenderer, &*srcImage._pSurface)),
-        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, SDL_DestroyTexture));
+        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
     _textures[1] = std::shared_ptr<SDL_Texture>(
         pushAndWaitMainThreadTask<SDL_Texture*>(
             std::bind_front(SDL_CreateTextureFromSurface, gFrameRenderer, &*srcImage._pSurface)),
-        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, SDL_DestroyTexture));
+        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
     if (_textures[0] || _textures[1])
     {
         textureRect = srcImage.getRect();
@@ -237,18 +450,59 @@ Texture::Texture(const Image& srcImage)
     }
 }
 
+Texture::Texture(const std::array<SDL_Texture*, 2>& textures, const Rect& rect)
+{
+    for (size_t i = 0; i < textures.size(); ++i)
+        if (textures[i])
+            _textures[i] = std::shared_ptr<SDL_Texture>(
+                textures[i], std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
+    if (_textures[0] || _textures[1])
+    {
+        textureRect = rect;
+        loaded = true;
+    }
+}
+
+std::vector<std::shared_ptr<Texture>> Texture::createBatch(const std::vector<const Image*>& images)
+{
+    std::vector<std::array<SDL_Texture*, 2>> created(images.size(), {nullptr, nullptr});
+    pushAndWaitMainThreadTask<void>([&] {
+        for (size_t i = 0; i < images.size(); ++i)
+        {
+            if (images[i] == nullptr || !images[i]->loaded)
+                continue;
+            for (auto& t : created[i])
+                t = SDL_CreateTextureFromSurface(gFrameRenderer, &*images[i]->_pSurface);
+            if (!created[i][0] && !created[i][1])
+            {
+                LOG_WARNING << "[Texture] Build texture object error! " << images[i]->_path;
+                LOG_WARNING << "[Texture] ^ " << SDL_GetError();
+            }
+        }
+    });
+
+    std::vector<std::shared_ptr<Texture>> res;
+    res.reserve(images.size());
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        const Rect rect = images[i] && images[i]->loaded ? images[i]->getRect() : Rect();
+        res.push_back(std::shared_ptr<Texture>(new Texture(created[i], rect)));
+    }
+    return res;
+}
+
 Texture::Texture(const SDL_Surface* pSurface)
 {
     _textures[0] = std::shared_ptr<SDL_Texture>(
         pushAndWaitMainThreadTask<SDL_Texture*>(
             std::bind_front(SDL_CreateTextureFromSurface, gFrameRenderer, const_cast<SDL_Surface*>(pSurface))),
-        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, SDL_DestroyTexture));
+        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
     if (!_textures[0])
         return;
     _textures[1] = std::shared_ptr<SDL_Texture>(
         pushAndWaitMainThreadTask<SDL_Texture*>(
             std::bind_front(SDL_CreateTextureFromSurface, gFrameRenderer, const_cast<SDL_Surface*>(pSurface))),
-        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, SDL_DestroyTexture));
+        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
     if (!_textures[1])
         return;
     textureRect = pSurface->clip_rect;
@@ -258,7 +512,7 @@ Texture::Texture(const SDL_Surface* pSurface)
 Texture::Texture(SDL_Texture* pTexture, int w, int h)
 {
     _textures[0] = std::shared_ptr<SDL_Texture>(
-        pTexture, std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, SDL_DestroyTexture));
+        pTexture, std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
     if (!pTexture)
         return;
     textureRect = {0, 0, w, h};
@@ -272,6 +526,7 @@ Texture::Texture(int w, int h, PixelFormat fmt, bool target)
     {
     case PixelFormat::RGB24: sdlfmt = SDL_PIXELFORMAT_RGB24; break;
     case PixelFormat::BGR24: sdlfmt = SDL_PIXELFORMAT_BGR24; break;
+    case PixelFormat::ARGB8888: sdlfmt = SDL_PIXELFORMAT_ARGB8888; break;
     case PixelFormat::YV12: sdlfmt = SDL_PIXELFORMAT_YV12; break;
     case PixelFormat::IYUV: sdlfmt = SDL_PIXELFORMAT_IYUV; break;
     case PixelFormat::YUY2: sdlfmt = SDL_PIXELFORMAT_YUY2; break;
@@ -287,7 +542,16 @@ Texture::Texture(int w, int h, PixelFormat fmt, bool target)
             pushAndWaitMainThreadTask<SDL_Texture*>(
                 std::bind_front(SDL_CreateTexture, gFrameRenderer, sdlfmt,
                                 target ? SDL_TEXTUREACCESS_TARGET : SDL_TEXTUREACCESS_STREAMING, w, h)),
-            std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, SDL_DestroyTexture));
+            std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
+        // Create the filtered copy up front so updateARGB() keeps both in sync, copy_if_needed() would only take a
+        // snapshot.
+        if (_textures[0] && fmt == PixelFormat::ARGB8888 && !target)
+        {
+            _textures[1] = std::shared_ptr<SDL_Texture>(
+                pushAndWaitMainThreadTask<SDL_Texture*>(std::bind_front(
+                    SDL_CreateTexture, gFrameRenderer, sdlfmt, SDL_TEXTUREACCESS_STREAMING, w, h)),
+                std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
+        }
         if (_textures[0])
         {
             textureRect = {0, 0, w, h};
@@ -307,6 +571,23 @@ void* Texture::raw()
     // return nullptr;
 }
 
+int Texture::updateARGB(const Rect& rect, const void* pixels, int pitch)
+{
+    LVF_DEBUG_ASSERT(IsMainThread());
+
+    if (!loaded)
+        return -1;
+    for (const auto& tex : _textures)
+    {
+        if (!tex)
+            continue;
+        if (tex.get() == spriteBatch.texture)
+            lunaticvibes::graphics::flush_sprite_batch();
+        SDL_UpdateTexture(tex.get(), &rect, pixels, pitch);
+    }
+    return 0;
+}
+
 int Texture::updateYUV(uint8_t* Y, int Ypitch, uint8_t* U, int Upitch, uint8_t* V, int Vpitch)
 {
     LVF_DEBUG_ASSERT(IsMainThread());
@@ -315,6 +596,9 @@ int Texture::updateYUV(uint8_t* Y, int Ypitch, uint8_t* U, int Upitch, uint8_t*
         return -1;
     if (!Ypitch || !Upitch || !Vpitch)
         return -2;
+    for (const auto& tex : _textures)
+        if (tex && tex.get() == spriteBatch.texture)
+            lunaticvibes::graphics::flush_sprite_batch();
     for (const auto& tex : _textures)
         if (tex)
             SDL_UpdateYUVTexture(tex.get(), nullptr, Y, Ypitch, U, Upitch, V, Vpitch);
@@ -336,8 +620,6 @@ static void do_draw(SDL_Texture* pTex, const Rect* srcRect, RectF dstRectF, cons
         dstRectF.y -= dstRectF.h; /*flipFlags |= SDL_FLIP_VERTICAL;*/
     }
 
-    SDL_SetTextureColorMod(pTex, c.r, c.g, c.b);
-
     int ssLevel = graphics_get_supersample_level();
     dstRectF.x *= ssLevel;
     dstRectF.y *= ssLevel;
@@ -353,9 +635,13 @@ static void do_draw(SDL_Texture* pTex, const Rect* srcRect, RectF dstRectF, cons
         // ... pls help
         const Rect rc = {0, 0, (int)std::ceil(dstRectF.w), (int)std::ceil(dstRectF.h)};
 
+        // Render target changes below, submit everything drawn before this sprite first.
+        lunaticvibes::graphics::flush_sprite_batch();
+        SDL_SetTextureColorMod(pTex, c.r, c.g, c.b);
+
         static auto pTextureInverted = std::shared_ptr<SDL_Texture>(
             SDL_CreateTexture(gFrameRenderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, rc.w, rc.h),
-            std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, SDL_DestroyTexture));
+            std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
 
         auto oldTarget = SDL_GetRenderTarget(gFrameRenderer);
         SDL_SetRenderTarget(gFrameRenderer, &*pTextureInverted);
@@ -377,6 +663,7 @@ static void do_draw(SDL_Texture* pTex, const Rect* srcRect, RectF dstRectF, cons
         SDL_SetTextureBlendMode(&*pTextureInverted, SDL_BLENDMODE_BLEND);
         SDL_RenderCopyExF(gFrameRenderer, &*pTextureInverted, &rc, &dstRectF, angle, center ? &scenter : NULL,
                           SDL_RendererFlip(flipFlags));
+        drawCallCount += 3;
         return;
     }
     else if (b == BlendMode::MULTIPLY_INVERTED_BACKGROUND)
@@ -389,12 +676,10 @@ static void do_draw(SDL_Texture* pTex, const Rect* srcRect, RectF dstRectF, cons
             SDL_BLENDFACTOR_DST_COLOR, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD, SDL_BLENDFACTOR_ONE,
             SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
 
-        SDL_SetTextureBlendMode(pTex, blendMode);
+        batch_sprite(pTex, blendMode, srcRect, dstRectF, {c.r, c.g, c.b, c.a}, angle, center ? &scenter : nullptr);
     }
     else
     {
-        SDL_SetTextureAlphaMod(pTex, b == BlendMode::NONE ? 255 : c.a);
-
         auto to_sdl_blend_mode = [](const BlendMode b) -> SDL_BlendMode {
             switch (b)
             {
@@ -425,13 +710,12 @@ static void do_draw(SDL_Texture* pTex, const Rect* srcRect, RectF dstRectF, cons
 
         if (const auto blend_mode = to_sdl_blend_mode(b); blend_mode != SDL_BLENDMODE_INVALID)
         {
-            SDL_SetTextureBlendMode(pTex, blend_mode);
+            const Uint8 alpha = b == BlendMode::NONE ? 255 : c.a;
+            batch_sprite(pTex, blend_mode, srcRect, dstRectF, {c.r, c.g, c.b, alpha}, angle,
+                         center ? &scenter : nullptr);
         }
     }
 
-    SDL_RenderCopyExF(gFrameRenderer, pTex, srcRect, &dstRectF, angle, center ? &scenter : NULL,
-                      SDL_RendererFlip(flipFlags));
-
     // #ifndef NDEBUG
     //     SDL_FRect& d = dstRectF;
     //     SDL_FPoint lines[5] = { {d.x, d.y}, {d.x + d.w, d.y}, {d.x + d.w, d.y + d.h}, {d.x, d.y + d.h}, {d.x, d.y} };
@@ -452,15 +736,17 @@ static void copy_if_needed(const bool filter, std::array<std::shared_ptr<SDL_Tex
         SDL_QueryTexture(tex, &format, nullptr, &w, &h);
         SDL_BlendMode blendmode;
         SDL_GetTextureBlendMode(tex, &blendmode);
+        lunaticvibes::graphics::flush_sprite_batch();
         SDL_Texture* oldTarget = SDL_GetRenderTarget(renderer);
         SDL_Texture* newTex = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_TARGET, w, h);
         SDL_SetTextureBlendMode(newTex, SDL_BLENDMODE_NONE);
         SDL_SetRenderTarget(renderer, newTex);
         SDL_RenderCopy(renderer, tex, nullptr, nullptr);
+        ++drawCallCount;
         SDL_SetTextureBlendMode(newTex, blendmode);
         SDL_SetRenderTarget(renderer, oldTarget);
         return std::shared_ptr<SDL_Texture>(
-            newTex, std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, SDL_DestroyTexture));
+            newTex, std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
     };
 
     // SDL_SetTextureScaleMode calls are expensive and only the last call on the same texture within the rendering cycle
@@ -526,10 +812,10 @@ TextureFull::TextureFull(const Color& c) : Texture(nullptr)
     SDL_FillRect(&*surface, &textureRect, SDL_MapRGBA(surface->format, c.r, c.g, c.b, c.a));
     _textures[0] = std::shared_ptr<SDL_Texture>(
         pushAndWaitMainThreadTask<SDL_Texture*>(std::bind_front(SDL_CreateTextureFromSurface, gFrameRenderer, surface)),
-        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, SDL_DestroyTexture));
+        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
     _textures[1] = std::shared_ptr<SDL_Texture>(
         pushAndWaitMainThreadTask<SDL_Texture*>(std::bind_front(SDL_CreateTextureFromSurface, gFrameRenderer, surface)),
-        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, SDL_DestroyTexture));
+        std::bind_front(pushAndWaitMainThreadTask<void, SDL_Texture*>, destroy_texture));
     loaded = true;
     SDL_FreeSurface(surface);
 }
@@ -550,10 +836,70 @@ void TextureFull::draw(const Rect& ignored, RectF dstRect, const Color c, const
     do_draw(_textures[static_cast<int>(filter)].get(), nullptr, dstRect, c, b, angle, nullptr);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// TextureRegion
+
+TextureRegion::TextureRegion(std::shared_ptr<const Texture> page, const Rect& region)
+    : Texture(nullptr, 0, 0), _page(std::move(page)), _region(region)
+{
+    _textures = _page->_textures;
+    textureRect = {0, 0, region.w, region.h};
+    loaded = _page->loaded;
+}
+
+Rect TextureRegion::toPageRect(const Rect& srcRect) const
+{
+    Rect rc(srcRect);
+    if (rc.w == RECT_FULL.w)
+        rc.w = textureRect.w;
+    if (rc.h == RECT_FULL.h)
+        rc.h = textureRect.h;
+    // sampling outside the region would show the neighbours
+    Rect clipped{0, 0, 0, 0};
+    if (!SDL_IntersectRect(&rc, &textureRect, &clipped))
+        return {0, 0, 0, 0};
+    clipped.x += _region.x;
+    clipped.y += _region.y;
+    return clipped;
+}
+
+void TextureRegion::draw(RectF dstRect, const Color c, const BlendMode b, const bool filter, const double angle) const
+{
+    draw(textureRect, dstRect, c, b, filter, angle);
+}
+
+void TextureRegion::draw(RectF dstRect, const Color c, const BlendMode b, const bool filter, const double angle,
+                         const Point& center) const
+{
+    draw(textureRect, dstRect, c, b, filter, angle, center);
+}
+
+void TextureRegion::draw(const Rect& srcRect, RectF dstRect, const Color c, const BlendMode b, const bool filter,
+                         const double angle) const
+{
+    const Rect rc = toPageRect(srcRect);
+    if (rc.w <= 0 || rc.h <= 0)
+        return;
+    copy_if_needed(filter, _textures, _didRenderOnce);
+    do_draw(_textures[static_cast<int>(filter)].get(), &rc, dstRect, c, b, angle, nullptr);
+}
+
+void TextureRegion::draw(const Rect& srcRect, RectF dstRect, const Color c, const BlendMode b, const bool filter,
+                         const double angle, const Point& center) const
+{
+    const Rect rc = toPageRect(srcRect);
+    if (rc.w <= 0 || rc.h <= 0)
+        return;
+    copy_if_needed(filter, _textures, _didRenderOnce);
+    do_draw(_textures[static_cast<int>(filter)].get(), &rc, dstRect, c, b, angle, &center);
+}
+
 void GraphLine::draw(Point p1, Point p2, Color c) const
 {
+    lunaticvibes::graphics::flush_sprite_batch();
     int ss = graphics_get_supersample_level();
     thickLineRGBA(gFrameRenderer, (Sint16)p1.x * ss, (Sint16)p1.y * ss, (Sint16)p2.x * ss, (Sint16)p2.y * ss,
                   _width * ss, c.r, c.g, c.b, c.a);
+    ++drawCallCount;
     SDL_SetRenderDrawColor(gFrameRenderer, 0, 0, 0, 255);
 }
@@ -11,6 +11,8 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "common/types.h"
 
@@ -147,10 +149,15 @@ public:
     Image(const char* filePath);
     Image(const char* format, void* bmp, size_t size);
     void setTransparentColorRGB(Color c);
+    // Copy with the color made transparent, from the already decoded pixels. This image is left untouched.
+    [[nodiscard]] Image withTransparentColorRGB(Color c) const;
     bool hasAlphaLayer() const { return _haveAlphaLayer; }
+    bool isLoaded() const { return loaded; }
 
 public:
     Rect getRect() const;
+    // Pixels converted to ARGB8888, rows without padding. Empty if the image is not loaded.
+    std::vector<uint32_t> getARGB() const;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -168,6 +175,8 @@ class Texture
     friend class SpriteLaneVerticalLN;
     friend class SpriteVideo;
 
+    friend class TextureRegion;
+
 protected:
     mutable std::array<std::shared_ptr<SDL_Texture>, 2> _textures{}; // Only 'mutable' to copy in draw() when needed.
     mutable bool _didRenderOnce = false; // shows if _textures is sorted by 'filter'. Set on first draw() call.
@@ -193,6 +202,7 @@ public:
 
         RGB24,
         BGR24,
+        ARGB8888,
 
         YV12,        // 4:2:0 Y + V + U
         IYUV,        // 4:2:0 Y + U + V
@@ -210,10 +220,19 @@ public:
     Texture(int w, int h, PixelFormat fmt, bool target);
     virtual ~Texture() = default;
 
+    // Textures for many images with a single trip to the main thread, in the same order. Images that failed to load
+    // give unloaded textures, like the Image constructor.
+    static std::vector<std::shared_ptr<Texture>> createBatch(const std::vector<const Image*>& images);
+
+private:
+    Texture(const std::array<SDL_Texture*, 2>& textures, const Rect& rect);
+
 public:
     void* raw();
     Rect getRect() const { return textureRect; }
     bool isLoaded() const { return loaded; }
+    // Pixels must match the texture format, i.e. ARGB8888 for textures created with it.
+    int updateARGB(const Rect& rect, const void* pixels, int pitch);
     int updateYUV(uint8_t* Y, int Ypitch, uint8_t* U, int Upitch, uint8_t* V, int Vpitch);
 };
 
@@ -234,6 +253,32 @@ public:
     ~TextureFull() override;
 };
 
+// Part of a larger texture, e.g. an image packed into an atlas page. Behaves like a texture of the region's size:
+// srcRect is relative to the region and clipped to it.
+class TextureRegion : public Texture
+{
+private:
+    std::shared_ptr<const Texture> _page;
+    Rect _region; // in page coordinates
+
+    Rect toPageRect(const Rect& srcRect) const;
+
+public:
+    TextureRegion(std::shared_ptr<const Texture> page, const Rect& region);
+
+    // The region keeps the whole page resident.
+    const Texture& getPage() const { return *_page; }
+
+    void draw(RectF dstRect, const Color c, const BlendMode blend, const bool filter,
+              const double angleInDegrees) const override;
+    void draw(RectF dstRect, const Color c, const BlendMode blend, const bool filter, const double angleInDegrees,
+              const Point& center) const override;
+    void draw(const Rect& srcRect, RectF dstRect, const Color c, const BlendMode blend, const bool filter,
+              const double angleInDegrees) const override;
+    void draw(const Rect& srcRect, RectF dstRect, const Color c, const BlendMode blend, const bool filter,
+              const double angleInDegrees, const Point& center) const override;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // SDL_ttf encapsulation. Mostly as same as Image
 // Run TTF_Init outside.
@@ -252,6 +297,41 @@ protected:
     Color _outlineColor;
     int _outlineWidth = 0;
 
+    // Glyph atlas. Each glyph is rasterized once in white and tinted when drawn.
+    static constexpr int ATLAS_PAGE_SIZE = 1024;
+    // A full atlas is kept as it is. Text with glyphs that did not fit is drawn from its own texture instead.
+    static constexpr size_t ATLAS_MAX_PAGES = 4;
+    struct AtlasGlyph
+    {
+        int page = -1; // -1: nothing to draw, e.g. space
+        Rect src;
+        int offsetX = 0;
+        int advance = 0;
+        bool fits = true; // false if the atlas was full
+    };
+    struct AtlasPage
+    {
+        std::shared_ptr<Texture> texture; // created on first upload, laid out quads keep it alive
+        int w = 0;
+        int h = 0;
+        int shelfX = 0;
+        int shelfY = 0;
+        int shelfH = 0;
+    };
+    struct AtlasPlacement
+    {
+        size_t page;
+        Rect rect;
+    };
+    std::unordered_map<uint64_t, AtlasGlyph> _atlasGlyphs; // (outline width << 32) | codepoint
+    std::vector<AtlasPage> _atlasPages;
+    unsigned _atlasGeneration = 0;
+
+    const AtlasGlyph& getAtlasGlyph(char32_t ch, bool outline);
+    // Reserves room for a w*h glyph, nullopt if the atlas is full.
+    std::optional<AtlasPlacement> placeAtlasGlyph(int w, int h);
+    void clearAtlas();
+
 public:
     TTFFont(const Path& filePath, int ptsize);
     TTFFont(const Path& filePath, int ptsize, int faceIndex);
@@ -267,6 +347,22 @@ public:
     // Rendering Interfaces
     std::shared_ptr<Texture> TextUTF8(const char* text, const Color& c);
     Rect getRectUTF8(const char* text);
+
+    struct GlyphQuad
+    {
+        std::shared_ptr<const Texture> page;
+        Rect src;
+        Rect dst; // relative to the text rect
+        bool outline;
+    };
+    // Lay out text with glyphs from the atlas, rasterizing only those not seen before. Outline quads come first.
+    // fits is false if some glyph is missing from the full atlas, use TextUTF8 then.
+    // Returns the same rect as getRectUTF8.
+    Rect layoutUTF8(const std::string& text, std::vector<GlyphQuad>& quads, bool& fits);
+    // Changes whenever previously returned quads should be laid out again, including outline changes. Until then they
+    // can still be drawn.
+    unsigned getAtlasGeneration() const { return _atlasGeneration; }
+    bool hasOutline() const { return _pFontOutline != NULL; }
     // Rect getRectUTF16(const char* text);
 };
 
@@ -3,11 +3,13 @@
 #include <SDL_ttf.h>
 
 #include <common/assert.h>
+#include <common/encoding.h>
 #include <common/log.h>
 #include <common/sysutil.h>
 #include <common/types.h>
 #include <common/u8.h>
 
+#include <algorithm>
 #include <functional>
 
 TTFFont::TTFFont(const Path& filePath, int ptsize) : _filePath(lunaticvibes::cs(filePath.u8string())), _ptsize(ptsize)
@@ -53,6 +55,7 @@ void TTFFont::setStyle(TTFStyle style)
     case TTFStyle::Italic: TTF_SetFontStyle(_pFont, TTF_STYLE_ITALIC); break;
     case TTFStyle::BoldItalic: TTF_SetFontStyle(_pFont, TTF_STYLE_BOLD | TTF_STYLE_ITALIC); break;
     }
+    clearAtlas();
 }
 void TTFFont::setOutline(int width, const Color& c)
 {
@@ -65,6 +68,7 @@ void TTFFont::setOutline(int width, const Color& c)
         if (_pFontOutline != NULL)
         {
             TTF_CloseFont(_pFontOutline);
+            _pFontOutline = NULL;
         }
     }
     else
@@ -75,9 +79,16 @@ void TTFFont::setOutline(int width, const Color& c)
                 _pFontOutline = TTF_OpenFontIndex(_filePath.c_str(), _ptsize, _faceIndex);
             else
                 _pFontOutline = TTF_OpenFont(_filePath.c_str(), _ptsize);
-            TTF_SetFontOutline(_pFontOutline, width);
+            if (_pFontOutline == NULL)
+                LOG_WARNING << "[TTF] " << _filePath << ": " << TTF_GetError();
         }
+        if (_pFontOutline != NULL && width != _outlineWidth)
+            TTF_SetFontOutline(_pFontOutline, width);
     }
+
+    // Laid out text has outline quads of the old width, and composed text the old color.
+    if (width != _outlineWidth || c != _outlineColor)
+        ++_atlasGeneration;
     _outlineWidth = width;
     _outlineColor = c;
 }
@@ -94,6 +105,7 @@ void TTFFont::setHinting(TTFHinting mode)
     case TTFHinting::Mono: TTF_SetFontHinting(_pFont, TTF_HINTING_MONO); break;
     case TTFHinting::None_: TTF_SetFontHinting(_pFont, TTF_HINTING_NONE); break;
     }
+    clearAtlas();
 }
 void TTFFont::setKerning(bool enabled)
 {
@@ -145,3 +157,137 @@ Rect TTFFont::getRectUTF8(const char* text)
     TTF_SizeUTF8(_pFontOutline ? _pFontOutline : _pFont, text, &r.w, &r.h);
     return r;
 }
+
+void TTFFont::clearAtlas()
+{
+    if (_atlasGlyphs.empty() && _atlasPages.empty())
+        return;
+    _atlasGlyphs.clear();
+    _atlasPages.clear();
+    ++_atlasGeneration;
+}
+
+std::optional<TTFFont::AtlasPlacement> TTFFont::placeAtlasGlyph(int w, int h)
+{
+    // Shelf packing, with a transparent gap so filtering does not bleed into neighbours.
+    static constexpr int PADDING = 1;
+    AtlasPage* page = _atlasPages.empty() ? nullptr : &_atlasPages.back();
+    if (page != nullptr && page->shelfX + w > page->w)
+    {
+        page->shelfX = 0;
+        page->shelfY += page->shelfH + PADDING;
+        page->shelfH = 0;
+    }
+    if (page == nullptr || page->shelfX + w > page->w || page->shelfY + h > page->h)
+    {
+        // Dropping the atlas here would make every text lay out again, and evict glyphs of one another in turn.
+        if (_atlasPages.size() >= ATLAS_MAX_PAGES)
+            return std::nullopt;
+        page = &_atlasPages.emplace_back();
+        page->w = std::max(ATLAS_PAGE_SIZE, w);
+        page->h = std::max(ATLAS_PAGE_SIZE, h);
+    }
+
+    AtlasPlacement placement{_atlasPages.size() - 1, Rect{page->shelfX, page->shelfY, w, h}};
+    page->shelfX += w + PADDING;
+    page->shelfH = std::max(page->shelfH, h);
+    return placement;
+}
+
+const TTFFont::AtlasGlyph& TTFFont::getAtlasGlyph(char32_t ch, bool outline)
+{
+    const uint64_t key = (outline ? static_cast<uint64_t>(_outlineWidth) << 32 : 0) | ch;
+    if (auto it = _atlasGlyphs.find(key); it != _atlasGlyphs.end())
+        return it->second;
+
+    AtlasGlyph glyph;
+    TTF_Font* font = outline ? _pFontOutline : _pFont;
+
+    // Single glyph surfaces start at min(0, minx) relative to the pen, same as in a rendered string.
+    int minx = 0, maxx = 0, miny = 0, maxy = 0, advance = 0;
+    if (TTF_GlyphMetrics32(font, ch, &minx, &maxx, &miny, &maxy, &advance) == 0)
+    {
+        glyph.offsetX = std::min(0, minx);
+        glyph.advance = advance;
+    }
+
+    SDL_Surface* surface = TTF_RenderGlyph32_Blended(font, ch, {255, 255, 255, 255});
+    if (surface != nullptr && surface->format->format != SDL_PIXELFORMAT_ARGB8888)
+    {
+        SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(surface);
+        surface = converted;
+    }
+    // nullptr for whitespace, or if not renderable at all
+    if (surface == nullptr)
+        return _atlasGlyphs.emplace(key, glyph).first->second;
+
+    const std::optional<AtlasPlacement> placement = placeAtlasGlyph(surface->w, surface->h);
+    if (!placement)
+    {
+        LOG_DEBUG << "[TTF] Glyph atlas full, " << _atlasGlyphs.size() << " glyphs";
+        SDL_FreeSurface(surface);
+        glyph.fits = false;
+        return _atlasGlyphs.emplace(key, glyph).first->second;
+    }
+    AtlasPage& page = _atlasPages[placement->page];
+    if (page.texture == nullptr)
+    {
+        auto texture = std::make_shared<Texture>(page.w, page.h, Texture::PixelFormat::ARGB8888, false);
+        if (texture->isLoaded())
+        {
+            const std::vector<uint32_t> blank(static_cast<size_t>(page.w) * page.h, 0);
+            texture->updateARGB(texture->getRect(), blank.data(), page.w * 4);
+            page.texture = std::move(texture);
+        }
+        else
+        {
+            LOG_WARNING << "[TTF] Create glyph atlas page failed: " << SDL_GetError();
+        }
+    }
+    if (page.texture != nullptr)
+    {
+        glyph.page = static_cast<int>(placement->page);
+        glyph.src = placement->rect;
+        page.texture->updateARGB(glyph.src, surface->pixels, surface->pitch);
+    }
+    SDL_FreeSurface(surface);
+    return _atlasGlyphs.emplace(key, glyph).first->second;
+}
+
+Rect TTFFont::layoutUTF8(const std::string& text, std::vector<GlyphQuad>& quads, bool& fits)
+{
+    LVF_DEBUG_ASSERT(IsMainThread());
+    quads.clear();
+    fits = true;
+    if (!loaded)
+        return {0, 0, 0, 0};
+
+    const std::u32string codepoints = utf8_to_utf32(text);
+    const bool kerning = TTF_GetFontKerning(_pFont) != 0;
+    auto layout = [&](bool outline, int shift) {
+        int penX = 0;
+        char32_t prev = 0;
+        for (char32_t ch : codepoints)
+        {
+            if (kerning && prev != 0)
+                penX += TTF_GetFontKerningSizeGlyphs32(_pFont, prev, ch);
+            prev = ch;
+
+            const AtlasGlyph& glyph = getAtlasGlyph(ch, outline);
+            fits = fits && glyph.fits;
+            if (glyph.page >= 0)
+                quads.push_back({_atlasPages[glyph.page].texture, glyph.src,
+                                 Rect{penX + glyph.offsetX + shift, shift, glyph.src.w, glyph.src.h}, outline});
+            // Outline glyphs follow the inner pen so both passes stay aligned.
+            penX += outline ? getAtlasGlyph(ch, false).advance : glyph.advance;
+        }
+    };
+    if (_pFontOutline)
+        layout(true, 0);
+    layout(false, _pFontOutline ? _outlineWidth : 0);
+    if (!fits)
+        quads.clear();
+
+    return getRectUTF8(text.c_str());
+}
@@ -210,6 +210,8 @@ static std::chrono::high_resolution_clock::time_point frameTimestampPrev;
 static Path screenshotPath;
 void graphics_flush()
 {
+    lunaticvibes::graphics::flush_sprite_batch();
+    lunaticvibes::graphics::reset_draw_call_count();
     SDL_SetRenderTarget(gFrameRenderer, NULL);
     {
         // TODO scale internal canvas
@@ -296,6 +298,7 @@ void graphics_copy_screen_texture(Texture& texture)
 {
     LVF_DEBUG_ASSERT(IsMainThread());
 
+    lunaticvibes::graphics::flush_sprite_batch();
     SDL_SetRenderTarget(gFrameRenderer, reinterpret_cast<SDL_Texture*>(texture.raw()));
     SDL_RenderClear(gFrameRenderer);
     const SDL_Rect origRect = texture.getRect();
@@ -547,6 +550,7 @@ bool lunaticvibes::event_handle()
 
 void ImGuiNewFrame()
 {
+    lunaticvibes::graphics::flush_sprite_batch();
     SDL_SetRenderTarget(gFrameRenderer, NULL);
     ImGui_ImplSDLRenderer2_NewFrame();
     ImGui_ImplSDL2_NewFrame();
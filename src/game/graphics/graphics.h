@@ -76,4 +76,12 @@ void stopTextInput();
 namespace lunaticvibes::graphics
 {
 void queue_screenshot(Path png);
+
+// Texture draws are batched until the texture or blend mode changes. Anything rendering through the renderer
+// directly (render target switches, primitives, texture uploads) must flush first to keep the draw order.
+void flush_sprite_batch();
+
+// Draw calls submitted to the renderer during the last presented frame.
+unsigned get_draw_call_count();
+void reset_draw_call_count();
 } // namespace lunaticvibes::graphics
@@ -74,7 +74,8 @@ bool SpriteBase::updateMotion(const lunaticvibes::Time& rawTime)
         return false;
 
     // Check if timer is valid
-    lunaticvibes::Time time = State::get(motionStartTimer);
+    lunaticvibes::Time time = motionStartTimePrefetched ? motionStartTime : State::get(motionStartTimer);
+    motionStartTimePrefetched = false;
     if (time < 0 || time == TIMER_NEVER)
         return false;
 
@@ -123,15 +124,8 @@ bool SpriteBase::updateMotion(const lunaticvibes::Time& rawTime)
     else
     {
         // get keyFrame section (iterators)
-        decltype(motionKeyFrames.begin()) keyFrameCurr, keyFrameNext;
-        for (auto it = motionKeyFrames.begin(); it != motionKeyFrames.end(); ++it)
-        {
-            if (it->time <= time.norm())
-                keyFrameCurr = it;
-            else
-                break;
-        }
-        keyFrameNext = keyFrameCurr;
+        auto keyFrameCurr = motionKeyFrames.begin() + findMotionKeyFrame(time.norm());
+        auto keyFrameNext = keyFrameCurr;
         if (keyFrameCurr + 1 != motionKeyFrames.end())
             ++keyFrameNext;
 
@@ -188,6 +182,33 @@ bool SpriteBase::updateMotion(const lunaticvibes::Time& rawTime)
     return true;
 }
 
+// Last key frame at or before time, time being past the first one.
+size_t SpriteBase::findMotionKeyFrame(long long time)
+{
+    const size_t frameCount = motionKeyFrames.size();
+    if (!motionKeyFramesSorted)
+    {
+        size_t i = 0;
+        while (i + 1 < frameCount && motionKeyFrames[i + 1].time <= time)
+            ++i;
+        return i;
+    }
+
+    auto isSection = [&](size_t i) {
+        return i < frameCount && motionKeyFrames[i].time <= time &&
+               (i + 1 == frameCount || motionKeyFrames[i + 1].time > time);
+    };
+    if (isSection(motionKeyFrameCursor))
+        return motionKeyFrameCursor;
+    if (isSection(motionKeyFrameCursor + 1))
+        return ++motionKeyFrameCursor;
+
+    auto it = std::upper_bound(motionKeyFrames.begin(), motionKeyFrames.end(), time,
+                               [](long long t, const MotionKeyFrame& f) { return t < f.time; });
+    motionKeyFrameCursor = it == motionKeyFrames.begin() ? 0 : size_t(it - motionKeyFrames.begin()) - 1;
+    return motionKeyFrameCursor;
+}
+
 bool SpriteBase::update(const lunaticvibes::Time& t)
 {
     _draw = updateMotion(t);
@@ -204,9 +225,18 @@ void SpriteBase::setMotionStartTimer(IndexTimer t)
 
 void SpriteBase::appendMotionKeyFrame(const MotionKeyFrame& f)
 {
+    if (!motionKeyFrames.empty() && f.time < motionKeyFrames.back().time)
+        motionKeyFramesSorted = false;
     motionKeyFrames.push_back(f);
 }
 
+void SpriteBase::clearMotionKeyFrames()
+{
+    motionKeyFrames.clear();
+    motionKeyFramesSorted = true;
+    motionKeyFrameCursor = 0;
+}
+
 void SpriteBase::setMotionLoopTo(int time)
 {
     motionLoopTo = time;
@@ -413,29 +443,39 @@ void SpriteText::updateTextTexture(std::string&& text, const Color& c)
     if (!pFont || !pFont->loaded)
         return;
 
-    if (pTexture != nullptr && this->_text == text && textColor == c)
-        return;
-
     if (text.empty() || c.a == 0)
     {
-        pTexture = nullptr;
+        glyphQuads.clear();
+        composedTexture = nullptr;
+        _text.clear();
         _draw = false;
         return;
     }
 
-    this->_text = text;
+    // Glyphs are tinted when drawn, a color change alone needs no new layout.
     textColor = c;
-
-    pTexture = pFont->TextUTF8(text.c_str(), c);
-    if (pTexture)
+    if ((glyphQuads.empty() && glyphsFit) || this->_text != text || glyphGeneration != pFont->getAtlasGeneration())
     {
-        textureRect = pTexture->getRect();
-        _draw = true;
+        this->_text = text;
+        composedTexture = nullptr;
+        textureRect = pFont->layoutUTF8(_text, glyphQuads, glyphsFit);
+        glyphGeneration = pFont->getAtlasGeneration();
     }
-    else
+
+    if (glyphsFit && !needsComposedText(pFont->hasOutline(), _current.blend, c))
+        composedTexture = nullptr;
+    else if (composedTexture == nullptr || composedColor != c)
     {
-        _draw = false;
+        composedTexture = pFont->TextUTF8(_text.c_str(), c);
+        composedColor = c;
     }
+
+    _draw = (!glyphQuads.empty() || composedTexture != nullptr) && textureRect.w > 0 && textureRect.h > 0;
+}
+
+bool SpriteText::needsComposedText(bool outline, BlendMode blend, const Color& c)
+{
+    return outline && (blend != BlendMode::ALPHA || c.a < 255);
 }
 
 void SpriteText::updateTextRect()
@@ -499,10 +539,31 @@ void SpriteText::draw() const
     if (isHidden())
         return;
 
-    if (_draw && pTexture && pTexture->loaded)
+    // Quads laid out before an atlas change still point to live pages, they are replaced on the next update.
+    if (!_draw)
+        return;
+
+    if (composedTexture != nullptr)
     {
-        pTexture->draw(textureRect, _current.rect, _current.color, _current.blend, _current.filter, _current.angle,
-                       _current.center);
+        if (composedTexture->loaded)
+            composedTexture->draw(composedTexture->getRect(), _current.rect, _current.color, _current.blend,
+                                  _current.filter, _current.angle, _current.center);
+        return;
+    }
+
+    // Colors used to be baked into the text texture and then modulated again when drawn, keep that look.
+    const Color textTint = textColor * _current.color;
+    const Color outlineTint = pFont->_outlineColor * _current.color;
+    const double sx = (double)_current.rect.w / textureRect.w;
+    const double sy = (double)_current.rect.h / textureRect.h;
+    for (const auto& q : glyphQuads)
+    {
+        const RectF dst{(float)(_current.rect.x + q.dst.x * sx), (float)(_current.rect.y + q.dst.y * sy),
+                        (float)(q.dst.w * sx), (float)(q.dst.h * sy)};
+        // center is relative to the whole text, rotate every glyph around the same point
+        const Point center{_current.center.x - q.dst.x * sx, _current.center.y - q.dst.y * sy};
+        q.page->draw(q.src, dst, q.outline ? outlineTint : textTint, _current.blend, _current.filter, _current.angle,
+                     center);
     }
 }
 
@@ -682,7 +743,7 @@ void SpriteNumber::updateNumberRect()
 
 void SpriteNumber::appendMotionKeyFrame(const MotionKeyFrame& f)
 {
-    motionKeyFrames.push_back(f);
+    SpriteBase::appendMotionKeyFrame(f);
 }
 
 void SpriteNumber::draw() const
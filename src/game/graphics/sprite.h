@@ -106,6 +106,14 @@ protected:
     int motionLoopTo = -1;
     IndexTimer motionStartTimer = IndexTimer::SCENE_START;
 
+private:
+    bool motionKeyFramesSorted = true; // by time, otherwise sections are found by the old linear scan
+    size_t motionKeyFrameCursor = 0;   // section of the last update, time usually stays there or moves to the next
+    bool motionStartTimePrefetched = false;
+    long long motionStartTime = 0; // value of motionStartTimer for the next updateMotion(), see setMotionStartTime()
+
+    size_t findMotionKeyFrame(long long time);
+
 public:
     struct SpriteBuilder
     {
@@ -128,7 +136,15 @@ public:
     virtual void setMotionLoopTo(int time);
     virtual void setMotionStartTimer(IndexTimer t);
     bool isMotionKeyFramesEmpty() const { return motionKeyFrames.empty(); }
-    void clearMotionKeyFrames() { motionKeyFrames.clear(); }
+    void clearMotionKeyFrames();
+    IndexTimer getMotionStartTimer() const { return motionStartTimer; }
+    // The skin reads each start timer once per frame and hands the value to every sprite using it.
+    // Used by the next updateMotion() only.
+    void setMotionStartTime(long long t)
+    {
+        motionStartTime = t;
+        motionStartTimePrefetched = true;
+    }
 
     bool updateMotion(const lunaticvibes::Time& time);
     // Called from thread pool awaited in main().
@@ -340,6 +356,13 @@ protected:
 
 private:
     Rect textureRect;
+    std::vector<TTFFont::GlyphQuad> glyphQuads;
+    unsigned glyphGeneration = 0;
+    bool glyphsFit = true; // false if the glyph atlas of the font is full
+    // Whole text with the fill blended over the outline, drawn instead of the quads when those would look different,
+    // or when the glyphs do not fit in the atlas.
+    std::shared_ptr<Texture> composedTexture;
+    Color composedColor;
 
 protected:
     bool editing = false;
@@ -372,6 +395,11 @@ public:
 private:
     void updateTextTexture(std::string&& text, const Color& c);
 
+protected:
+    // Drawing outline and fill quads one after the other blends the same as the composed text only if the text is
+    // opaque and alpha blended. Otherwise the outline shows through the fill, or is added to it.
+    static bool needsComposedText(bool outline, BlendMode blend, const Color& c);
+
 public:
     bool update(const lunaticvibes::Time& t) override;
     void update_on_main(const lunaticvibes::Time& t) override;
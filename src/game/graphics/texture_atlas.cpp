@@ -0,0 +1,92 @@
+#include "texture_atlas.h"
+
+#include <algorithm>
+
+#include "common/log.h"
+#include "common/sysutil.h"
+
+namespace lunaticvibes::graphics
+{
+
+TextureAtlas::TextureAtlas(int pageSize, int maxImageSize) : _pageSize(pageSize), _maxImageSize(maxImageSize) {}
+
+bool TextureAtlas::fits(int w, int h) const
+{
+    return w > 0 && h > 0 && w <= _maxImageSize && h <= _maxImageSize && w + 2 * BORDER <= _pageSize &&
+           h + 2 * BORDER <= _pageSize;
+}
+
+std::optional<TextureAtlas::Placement> TextureAtlas::place(int w, int h)
+{
+    if (!fits(w, h))
+        return std::nullopt;
+
+    const int bw = w + 2 * BORDER;
+    const int bh = h + 2 * BORDER;
+    for (size_t i = 0;; ++i)
+    {
+        if (i == _pages.size())
+            _pages.emplace_back();
+        Page& page = _pages[i];
+        if (page.shelfX + bw > _pageSize)
+        {
+            if (page.shelfY + page.shelfH + bh > _pageSize)
+                continue;
+            page.shelfX = 0;
+            page.shelfY += page.shelfH;
+            page.shelfH = 0;
+        }
+        if (page.shelfY + bh > _pageSize)
+            continue;
+
+        Placement res{i, {page.shelfX + BORDER, page.shelfY + BORDER, w, h}};
+        page.shelfX += bw;
+        page.shelfH = std::max(page.shelfH, bh);
+        return res;
+    }
+}
+
+std::shared_ptr<Texture> TextureAtlas::add(const Image& image)
+{
+    if (!image.isLoaded())
+        return nullptr;
+    const Rect size = image.getRect();
+    const auto placement = place(size.w, size.h);
+    if (!placement)
+        return nullptr;
+    const std::vector<uint32_t> pixels = image.getARGB();
+    if (pixels.empty())
+        return nullptr;
+
+    Page& page = _pages[placement->page];
+    if (!page.texture)
+    {
+        // Left uninitialized, nothing outside the regions and their borders is ever sampled.
+        page.texture = std::make_shared<Texture>(_pageSize, _pageSize, Texture::PixelFormat::ARGB8888, false);
+        if (!page.texture->isLoaded())
+        {
+            LOG_WARNING << "[TextureAtlas] Create page failed";
+            page.texture.reset();
+            return nullptr;
+        }
+        LOG_DEBUG << "[TextureAtlas] Page " << placement->page << " created";
+    }
+
+    const int w = size.w;
+    const int h = size.h;
+    const int bw = w + 2 * BORDER;
+    const int bh = h + 2 * BORDER;
+    std::vector<uint32_t> bordered(static_cast<size_t>(bw) * bh);
+    for (int y = 0; y < bh; ++y)
+    {
+        const uint32_t* src = &pixels[static_cast<size_t>(std::clamp(y - BORDER, 0, h - 1)) * w];
+        for (int x = 0; x < bw; ++x)
+            bordered[static_cast<size_t>(y) * bw + x] = src[std::clamp(x - BORDER, 0, w - 1)];
+    }
+    const Rect dst{placement->rect.x - BORDER, placement->rect.y - BORDER, bw, bh};
+    pushAndWaitMainThreadTask<void>([&] { page.texture->updateARGB(dst, bordered.data(), bw * 4); });
+
+    return std::make_shared<TextureRegion>(page.texture, placement->rect);
+}
+
+} // namespace lunaticvibes::graphics
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "graphics.h"
+
+namespace lunaticvibes::graphics
+{
+
+// Packs small images into a few large textures, so sprites using different images can still be drawn in one batch.
+// Pages are filled shelf by shelf, same as the glyph atlas of TTFFont. Every image gets a border repeating its edge
+// pixels, so filtering at the edge of a region looks the same as with a standalone texture.
+// Not thread safe, meant to be filled by one skin while it is loading.
+class TextureAtlas
+{
+public:
+    static constexpr int DEFAULT_PAGE_SIZE = 2048;
+    static constexpr int DEFAULT_MAX_IMAGE_SIZE = 512;
+    static constexpr int BORDER = 1;
+
+    struct Placement
+    {
+        size_t page;
+        Rect rect; // without the border
+    };
+
+    explicit TextureAtlas(int pageSize = DEFAULT_PAGE_SIZE, int maxImageSize = DEFAULT_MAX_IMAGE_SIZE);
+
+    [[nodiscard]] bool fits(int w, int h) const;
+    // Reserves room for a w*h image. nullopt if it is too large for the atlas.
+    std::optional<Placement> place(int w, int h);
+
+    // Region of a page holding the image. nullptr if the image is too large or not loaded, it should be loaded as a
+    // standalone texture then.
+    std::shared_ptr<Texture> add(const Image& image);
+
+    [[nodiscard]] size_t getPageCount() const { return _pages.size(); }
+
+private:
+    struct Page
+    {
+        int shelfX = 0;
+        int shelfY = 0;
+        int shelfH = 0;
+        std::shared_ptr<Texture> texture; // created on first add()
+    };
+
+    int _pageSize;
+    int _maxImageSize;
+    std::vector<Page> _pages;
+};
+
+} // namespace lunaticvibes::graphics
@@ -0,0 +1,191 @@
+#include "texture_cache.h"
+
+#include "common/log.h"
+#include "common/u8.h"
+
+namespace lunaticvibes::graphics
+{
+
+static std::shared_ptr<Texture> loadImageTexture(const Path& path, std::optional<Color> transparentColor)
+{
+    Image img{path};
+    if (!img.hasAlphaLayer() && transparentColor)
+        img.setTransparentColorRGB(*transparentColor);
+    return std::make_shared<Texture>(img);
+}
+
+// Images are uploaded twice, see Texture::_textures.
+static size_t textureBytes(const Texture& texture)
+{
+    const Rect r = texture.getRect();
+    return size_t(r.w) * size_t(r.h) * 4 * 2;
+}
+
+TextureCache::TextureCache(size_t budget, Loader loader)
+    : _budget(budget), _loader(loader ? std::move(loader) : loadImageTexture)
+{
+}
+
+TextureCache& TextureCache::shared()
+{
+    static TextureCache cache;
+    return cache;
+}
+
+std::shared_ptr<Texture> TextureCache::get(const Path& path, std::optional<Color> transparentColor)
+{
+    return get(path, transparentColor, _loader);
+}
+
+std::shared_ptr<Texture> TextureCache::get(const Path& path, std::optional<Color> transparentColor,
+                                           const Loader& loader)
+{
+    std::error_code ec;
+    const auto mtime = fs::last_write_time(path, ec);
+    if (ec)
+        return loader(path, transparentColor);
+
+    Key key{u8str(path), mtime.time_since_epoch().count(), std::nullopt};
+    if (transparentColor)
+        key.transparentColor = transparentColor->hex();
+
+    {
+        std::unique_lock l{_mutex};
+        if (auto it = _entries.find(key); it != _entries.end())
+        {
+            ++_hits;
+            _lru.splice(_lru.begin(), _lru, it->second.lru);
+            return it->second.texture;
+        }
+        ++_misses;
+    }
+
+    // Uploading waits for the main thread, which may be asking the cache for something else at the same time.
+    std::shared_ptr<Texture> texture = loader(path, transparentColor);
+    if (!texture || !texture->isLoaded())
+        return texture;
+
+    // released outside the lock, destroying a texture waits for the main thread which may be querying the cache
+    std::vector<std::shared_ptr<Texture>> evicted;
+    std::unique_lock l{_mutex};
+    if (auto it = _entries.find(key); it != _entries.end())
+    {
+        // loaded by another thread meanwhile
+        _lru.splice(_lru.begin(), _lru, it->second.lru);
+        return it->second.texture;
+    }
+    _lru.push_front(key);
+    if (auto region = std::dynamic_pointer_cast<TextureRegion>(texture))
+    {
+        const Texture* page = &region->getPage();
+        auto [p, added] = _pages.try_emplace(page, Page{textureBytes(*page), 0});
+        if (added)
+            _bytes += p->second.bytes;
+        ++p->second.entries;
+        _entries.emplace(std::move(key), Entry{texture, 0, _lru.begin(), page});
+    }
+    else
+    {
+        const size_t bytes = textureBytes(*texture);
+        _entries.emplace(std::move(key), Entry{texture, bytes, _lru.begin(), nullptr});
+        _bytes += bytes;
+    }
+    evicted = evict(_budget);
+    return texture;
+}
+
+void TextureCache::setBudget(size_t bytes)
+{
+    std::vector<std::shared_ptr<Texture>> evicted;
+    std::unique_lock l{_mutex};
+    _budget = bytes;
+    evicted = evict(_budget);
+}
+
+void TextureCache::purge()
+{
+    std::vector<std::shared_ptr<Texture>> evicted;
+    std::unique_lock l{_mutex};
+    evicted = evict(0);
+}
+
+std::set<const Texture*> TextureCache::getPinnedPages() const
+{
+    std::set<const Texture*> pinned;
+    for (const auto& [key, entry] : _entries)
+        if (entry.page && entry.texture.use_count() > 1)
+            pinned.insert(entry.page);
+    return pinned;
+}
+
+std::vector<std::shared_ptr<Texture>> TextureCache::evict(size_t budget)
+{
+    std::vector<std::shared_ptr<Texture>> evicted;
+    if (_bytes <= budget)
+        return evicted;
+
+    const auto pinned = getPinnedPages();
+    for (auto it = _lru.end(); it != _lru.begin() && _bytes > budget;)
+    {
+        --it;
+        auto entry = _entries.find(*it);
+        if (entry->second.texture.use_count() > 1 || pinned.contains(entry->second.page))
+            continue;
+
+        LOG_VERBOSE << "[TextureCache] Evict " << it->path;
+        _bytes -= entry->second.bytes;
+        if (entry->second.page)
+        {
+            auto page = _pages.find(entry->second.page);
+            if (--page->second.entries == 0)
+            {
+                _bytes -= page->second.bytes;
+                _pages.erase(page);
+            }
+        }
+        ++_evictions;
+        evicted.push_back(std::move(entry->second.texture));
+        _entries.erase(entry);
+        it = _lru.erase(it);
+    }
+    return evicted;
+}
+
+TextureCache::Stats TextureCache::getStats() const
+{
+    std::unique_lock l{_mutex};
+    Stats s;
+    s.entries = _entries.size();
+    s.pages = _pages.size();
+    s.bytes = _bytes;
+    s.budget = _budget;
+    s.hits = _hits;
+    s.misses = _misses;
+    s.evictions = _evictions;
+    for (const auto& [key, entry] : _entries)
+    {
+        if (entry.texture.use_count() > 1)
+        {
+            ++s.referenced;
+            s.referencedBytes += entry.bytes;
+        }
+    }
+    for (const Texture* page : getPinnedPages())
+        s.referencedBytes += _pages.at(page).bytes;
+    return s;
+}
+
+std::vector<TextureCache::EntryInfo> TextureCache::getEntries() const
+{
+    std::unique_lock l{_mutex};
+    std::vector<EntryInfo> res;
+    res.reserve(_entries.size());
+    for (const auto& key : _lru)
+    {
+        const Entry& entry = _entries.at(key);
+        res.push_back({key.path, entry.texture->getRect(), entry.bytes, entry.texture.use_count() - 1});
+    }
+    return res;
+}
+
+} // namespace lunaticvibes::graphics
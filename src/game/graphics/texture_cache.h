@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "common/types.h"
+#include "graphics.h"
+
+namespace lunaticvibes::graphics
+{
+
+// Image textures shared by every skin, keyed by (path, mtime, transparent color).
+// A texture is referenced while anything besides the cache holds its shared_ptr. Unreferenced textures stay resident
+// so the next scene can pick them up again, until the total size goes over budget; then the least recently used
+// unreferenced ones are dropped first. Referenced textures are never evicted, the budget may be exceeded by them.
+// An atlas region pins its whole page, so the page is what gets counted, once for all of its regions. Regions of a page
+// are only evicted while none of them is referenced, dropping them earlier would free nothing.
+class TextureCache
+{
+public:
+    using Loader = std::function<std::shared_ptr<Texture>(const Path& path, std::optional<Color> transparentColor)>;
+
+    static constexpr size_t DEFAULT_BUDGET = 512 * 1024 * 1024;
+
+    struct Stats
+    {
+        size_t entries = 0;
+        size_t referenced = 0;
+        size_t pages = 0; // atlas pages
+        size_t bytes = 0;
+        size_t referencedBytes = 0;
+        size_t budget = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    struct EntryInfo
+    {
+        std::string path;
+        Rect size;
+        size_t bytes; // 0 for atlas regions
+        long refs; // not counting the cache
+    };
+
+    // Loads through SDL_image by default, the transparent color is only applied to images without alpha.
+    explicit TextureCache(size_t budget = DEFAULT_BUDGET, Loader loader = nullptr);
+
+    // The process-wide instance used by skins.
+    static TextureCache& shared();
+
+    // Files that cannot be stat'ed are loaded but not cached.
+    std::shared_ptr<Texture> get(const Path& path, std::optional<Color> transparentColor = std::nullopt);
+    // Same, loading through the given loader on a miss.
+    std::shared_ptr<Texture> get(const Path& path, std::optional<Color> transparentColor, const Loader& loader);
+
+    void setBudget(size_t bytes);
+    // Drops every unreferenced texture.
+    void purge();
+
+    [[nodiscard]] Stats getStats() const;
+    // Most recently used first.
+    [[nodiscard]] std::vector<EntryInfo> getEntries() const;
+
+private:
+    struct Key
+    {
+        std::string path;
+        int64_t mtime;
+        std::optional<uint32_t> transparentColor;
+        auto operator<=>(const Key&) const = default;
+    };
+    struct Entry
+    {
+        std::shared_ptr<Texture> texture;
+        size_t bytes;
+        std::list<Key>::iterator lru;
+        const Texture* page; // atlas page of a region, nullptr for standalone textures
+    };
+    struct Page
+    {
+        size_t bytes;
+        size_t entries;
+    };
+
+    mutable std::mutex _mutex;
+    std::map<Key, Entry> _entries;
+    std::map<const Texture*, Page> _pages; // kept alive by the regions in _entries
+    std::list<Key> _lru; // most recently used first
+    size_t _bytes = 0;
+    size_t _budget;
+    uint64_t _hits = 0;
+    uint64_t _misses = 0;
+    uint64_t _evictions = 0;
+    Loader _loader;
+
+    // Returns the evicted textures, to be released by the caller once _mutex is unlocked.
+    [[nodiscard]] std::vector<std::shared_ptr<Texture>> evict(size_t budget);
+    // Pages with a referenced region.
+    [[nodiscard]] std::set<const Texture*> getPinnedPages() const;
+};
+
+} // namespace lunaticvibes::graphics
@@ -1,6 +1,10 @@
 #include "texture_extra.h"
 
 #include <algorithm>
+#include <array>
+#include <climits>
+#include <condition_variable>
+#include <fstream>
 
 #include <common/log.h>
 #include <common/sysutil.h>
@@ -44,25 +48,26 @@ TextureVideo::~TextureVideo()
     textures->erase((uintptr_t)this);
 }
 
-void TextureVideo::start()
+bool TextureVideo::start()
 {
-    if (!pVideo->isPlaying())
-    {
-        pVideo->startPlaying();
-    }
+    if (pVideo->isPlaying())
+        return false;
+    pVideo->startPlaying();
+    return pVideo->isPlaying();
 }
 
 void TextureVideo::stop()
 {
+    playTime = -1;
     if (pVideo->isPlaying())
     {
         pVideo->stopPlaying();
     }
 }
 
-void TextureVideo::seek(int64_t sec)
+void TextureVideo::seek(int64_t ms)
 {
-    pVideo->seek(sec);
+    pVideo->seek(ms);
 }
 
 void TextureVideo::setSpeed(double speed)
@@ -76,33 +81,23 @@ void TextureVideo::update()
         return;
     if (!pVideo->haveVideo)
         return;
-    if (!pVideo->isPlaying())
-        return;
 
-    auto vrfc = pVideo->getDecodedFrames();
-    if (decoded_frames == vrfc)
+    const int64_t t = playTime >= 0 ? static_cast<int64_t>(std::round(playTime * pVideo->getSpeed()))
+                                    : pVideo->getPlaybackTime();
+    uint64_t serial = frameSerial;
+    AVFrame* pf = pVideo->getFrame(t, serial);
+    if (pf == nullptr || serial == frameSerial)
         return;
-    decoded_frames = vrfc;
+    frameSerial = serial;
 
-    using namespace std::chrono_literals;
-
-    std::shared_lock l(pVideo->video_frame_mutex, std::try_to_lock);
-    if (l.owns_lock())
+    switch (format)
     {
-        auto pf = pVideo->getFrame();
-        if (!pf)
-            return;
+    case Texture::PixelFormat::IYUV:
+        if (updateYUV(pf->data[0], pf->linesize[0], pf->data[1], pf->linesize[1], pf->data[2], pf->linesize[2]) == 0)
+            updated = true;
+        break;
 
-        switch (format)
-        {
-        case Texture::PixelFormat::IYUV:
-            if (updateYUV(pf->data[0], pf->linesize[0], pf->data[1], pf->linesize[1], pf->data[2], pf->linesize[2]) ==
-                0)
-                updated = true;
-            break;
-
-        default: break;
-        }
+    default: break;
     }
 }
 
@@ -135,7 +130,7 @@ void TextureVideo::draw(const Rect& srcRect, RectF dstRect, const Color c, const
 void TextureVideo::reset()
 {
     seek(0);
-    decoded_frames = 0;
+    frameSerial = 0;
 }
 
 std::shared_ptr<std::shared_mutex> TextureVideo::texMapMutex;
@@ -153,10 +148,93 @@ void TextureVideo::updateAll()
     }
 }
 
-bool TextureBmsBga::addBmp(size_t idx, Path pBmp)
+// while streaming, pictures shown within this much chart time are kept resident
+static constexpr long long STREAM_AHEAD_MS = 5000;
+static constexpr auto STREAM_INTERVAL = std::chrono::milliseconds(50);
+
+// Images are uploaded twice, for both filter modes.
+static size_t pictureBytes(const Rect& r)
 {
+    return size_t(std::max(0, r.w)) * size_t(std::max(0, r.h)) * 4 * 2;
+}
+
+// Size of a BMP, PNG, JPEG or GIF picture from its header, to tell what it takes without decoding it. Empty for other
+// formats or broken headers.
+static Rect readPictureSize(const Path& path)
+{
+    std::ifstream f(path, std::ios::binary);
+    std::array<unsigned char, 26> h{};
+    f.read(reinterpret_cast<char*>(h.data()), h.size());
+    const auto n = static_cast<size_t>(f.gcount());
+    auto le16 = [&h](size_t i) { return int(h[i] | h[i + 1] << 8); };
+    auto le32 = [&h](size_t i) {
+        return int32_t(uint32_t(h[i]) | uint32_t(h[i + 1]) << 8 | uint32_t(h[i + 2]) << 16 | uint32_t(h[i + 3]) << 24);
+    };
+    auto be16 = [](const unsigned char* p) { return int(p[0] << 8 | p[1]); };
+    auto be32 = [&h](size_t i) {
+        return int32_t(uint32_t(h[i]) << 24 | uint32_t(h[i + 1]) << 16 | uint32_t(h[i + 2]) << 8 | uint32_t(h[i + 3]));
+    };
+
+    if (n >= 26 && h[0] == 'B' && h[1] == 'M')
+    {
+        if (le32(14) == 12) // OS/2 header
+            return {le16(18), le16(20)};
+        return {le32(18), std::abs(le32(22))};
+    }
+    if (n >= 24 && h[0] == 0x89 && h[1] == 'P' && h[2] == 'N' && h[3] == 'G')
+        return {be32(16), be32(20)};
+    if (n >= 10 && h[0] == 'G' && h[1] == 'I' && h[2] == 'F')
+        return {le16(6), le16(8)};
+    if (n >= 2 && h[0] == 0xFF && h[1] == 0xD8)
+    {
+        // walk the segments up to the frame header
+        f.clear();
+        f.seekg(2);
+        std::array<unsigned char, 7> seg{};
+        while (f.read(reinterpret_cast<char*>(seg.data()), 2) && seg[0] == 0xFF)
+        {
+            const unsigned char marker = seg[1];
+            if (marker == 0xFF) // fill byte
+            {
+                f.seekg(-1, std::ios::cur);
+                continue;
+            }
+            if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+                continue;
+            if (!f.read(reinterpret_cast<char*>(seg.data()), 2))
+                break;
+            const int len = be16(seg.data());
+            if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+            {
+                if (!f.read(reinterpret_cast<char*>(seg.data()), 5))
+                    break;
+                return {be16(seg.data() + 3), be16(seg.data() + 1)};
+            }
+            if (marker == 0xD9 || marker == 0xDA || len < 2)
+                break;
+            f.seekg(len - 2, std::ios::cur);
+        }
+    }
+    return {};
+}
+
+bool TextureBmsBga::reserveBudget(size_t bytes)
+{
+    size_t resident = residentBytes;
+    do
+    {
+        if (textureBudget > 0 && resident + bytes > textureBudget)
+            return false;
+    } while (!residentBytes.compare_exchange_weak(resident, resident + bytes));
+    return true;
+}
+
+TextureBmsBga::DecodedBmp TextureBmsBga::decodeBmp(size_t idx, Path pBmp)
+{
+    DecodedBmp res;
+    res.idx = idx;
     if (idx == size_t(-1))
-        return false;
+        return res;
 
     if (!fs::exists(pBmp) && pBmp.has_extension() &&
         lunaticvibes::iequals(lunaticvibes::s(pBmp.extension().u8string()), ".bmp"))
@@ -168,37 +246,99 @@ bool TextureBmsBga::addBmp(size_t idx, Path pBmp)
             pBmp = pBmp.parent_path() / Path(pBmp.filename().stem().u8string() + u8".png");
         }
     }
-    if (fs::exists(pBmp) && fs::is_regular_file(pBmp) && pBmp.has_extension())
+    res.path = pBmp;
+    if (std::error_code ec; fs::is_regular_file(pBmp, ec) && pBmp.has_extension())
     {
         if (video_file_extensions.find(toLower(lunaticvibes::s(pBmp.extension().u8string()))) !=
             video_file_extensions.end())
         {
-            objs[idx].type = obj::Ty::VIDEO;
-            objs[idx].pt =
-                std::make_shared<TextureVideo>(std::make_shared<sVideo>(pBmp, gSelectContext.pitchSpeed, false));
-            LOG_DEBUG << "[TextureBmsBga] added video: " << pBmp;
-            return true;
+            res.type = obj::Ty::VIDEO;
+            res.video = std::make_shared<sVideo>(pBmp, gSelectContext.pitchSpeed, false);
         }
         else
         {
-            objs[idx].type = obj::Ty::PIC;
-            objs[idx].pt = std::make_shared<Texture>(Image(pBmp));
-
-            objs_layer[idx].type = obj::Ty::PIC;
-            Image layerImg(pBmp);
-            layerImg.setTransparentColorRGB(Color(0, 0, 0, 255));
-            objs_layer[idx].pt = std::make_shared<Texture>(layerImg);
-            LOG_DEBUG << "[TextureBmsBga] added pic: " << pBmp;
-            return true;
+            res.type = obj::Ty::PIC;
+            // image and layer
+            res.bytes = pictureBytes(readPictureSize(pBmp));
+            if (const size_t reserved = res.bytes * 2; reserved == 0 || reserveBudget(reserved))
+            {
+                res.image.emplace(pBmp);
+                res.bytes = res.image->isLoaded() ? pictureBytes(res.image->getRect()) : 0;
+                if (res.bytes * 2 != reserved)
+                {
+                    // header missing or wrong
+                    residentBytes -= reserved;
+                    if (!reserveBudget(res.bytes * 2))
+                        res.image.reset();
+                }
+                if (res.image)
+                    res.layer = res.image->withTransparentColorRGB(Color(0, 0, 0, 255));
+            }
         }
     }
-    else
+    return res;
+}
+
+void TextureBmsBga::addDecoded(std::vector<DecodedBmp>& batch)
+{
+    std::vector<const Image*> images;
+    for (const auto& d : batch)
+    {
+        if (d.type == obj::Ty::PIC && d.image)
+        {
+            images.push_back(&*d.image);
+            images.push_back(&*d.layer);
+        }
+    }
+    auto textures = Texture::createBatch(images);
+
+    auto texture = textures.begin();
+    for (auto& d : batch)
     {
-        objs[idx].type = obj::Ty::EMPTY;
-        objs_layer[idx].type = obj::Ty::EMPTY;
-        LOG_DEBUG << "[TextureBmsBga] file not found, added dummy: " << pBmp;
+        if (d.idx == size_t(-1))
+            continue;
+        switch (d.type)
+        {
+        case obj::Ty::VIDEO:
+            objs[d.idx].type = obj::Ty::VIDEO;
+            objs[d.idx].pt = std::make_shared<TextureVideo>(std::move(d.video));
+            LOG_DEBUG << "[TextureBmsBga] added video: " << d.path;
+            break;
+
+        case obj::Ty::PIC:
+            objs[d.idx].type = obj::Ty::PIC;
+            objs[d.idx].path = d.path;
+            objs_layer[d.idx].type = obj::Ty::PIC;
+            objs_layer[d.idx].path = d.path;
+            objs[d.idx].bytes = d.bytes;
+            objs_layer[d.idx].bytes = d.bytes;
+            if (d.image)
+            {
+                // budget reserved by decodeBmp()
+                objs[d.idx].pt = *texture++;
+                objs_layer[d.idx].pt = *texture++;
+                LOG_DEBUG << "[TextureBmsBga] added pic: " << d.path;
+                break;
+            }
+            streaming = true;
+            LOG_DEBUG << "[TextureBmsBga] added pic for streaming: " << d.path;
+            break;
+
+        default:
+            objs[d.idx].type = obj::Ty::EMPTY;
+            objs_layer[d.idx].type = obj::Ty::EMPTY;
+            LOG_DEBUG << "[TextureBmsBga] file not found, added dummy: " << d.path;
+            break;
+        }
     }
-    return false;
+}
+
+bool TextureBmsBga::addBmp(size_t idx, Path pBmp)
+{
+    std::vector<DecodedBmp> batch;
+    batch.push_back(decodeBmp(idx, std::move(pBmp)));
+    addDecoded(batch);
+    return batch[0].type != obj::Ty::EMPTY;
 }
 
 bool TextureBmsBga::setSlot(size_t idx, const lunaticvibes::Time& time, bool base, bool layer, bool poor)
@@ -227,6 +367,24 @@ void TextureBmsBga::sortSlot()
     baseIt = baseSlot.begin();
     layerIt = layerSlot.begin();
     poorIt = poorSlot.begin();
+
+    // a slot shows its picture until the next slot of the same channel
+    timeline.clear();
+    firstUse.clear();
+    auto addUses = [this](const decltype(baseSlot)& slot, bool layer) {
+        for (size_t i = 0; i < slot.size(); ++i)
+        {
+            const long long start = slot[i].first.norm();
+            const long long end = i + 1 < slot.size() ? slot[i + 1].first.norm() : LLONG_MAX;
+            timeline.push_back({start, end, slot[i].second, layer});
+            if (auto [it, added] = firstUse.emplace(slot[i].second, start); !added)
+                it->second = std::min(it->second, start);
+        }
+    };
+    addUses(baseSlot, false);
+    addUses(layerSlot, true);
+    addUses(poorSlot, false);
+    std::stable_sort(timeline.begin(), timeline.end(), [](const Use& l, const Use& r) { return l.start < r.start; });
 }
 
 bool TextureBmsBga::setSlotFromBMS(ChartObjectBMS& bms)
@@ -234,9 +392,9 @@ bool TextureBmsBga::setSlotFromBMS(ChartObjectBMS& bms)
     baseSlot.clear();
     layerSlot.clear();
     poorSlot.clear();
-    const auto lBase = bms.getBgaBase();
-    const auto lLayer = bms.getBgaLayer();
-    const auto lPoor = bms.getBgaPoor();
+    const auto& lBase = bms.getBgaBase();
+    const auto& lLayer = bms.getBgaLayer();
+    const auto& lPoor = bms.getBgaPoor();
     for (const auto& l : lBase)
         setSlot(l.dvalue, l.time, true, false, false);
     for (const auto& l : lLayer)
@@ -244,14 +402,20 @@ bool TextureBmsBga::setSlotFromBMS(ChartObjectBMS& bms)
     for (const auto& l : lPoor)
         setSlot(l.dvalue, l.time, false, false, true);
     sortSlot();
-    loaded = true;
     return true;
 }
 
+long long TextureBmsBga::getFirstUse(size_t idx) const
+{
+    auto it = firstUse.find(idx);
+    return it != firstUse.end() ? it->second : LLONG_MAX;
+}
+
 void TextureBmsBga::seek(const lunaticvibes::Time& t)
 {
     if (!isLoaded())
         return;
+    streamTime = t.norm();
 
     auto seekSub = [&t, this](decltype(baseSlot)& slot, size_t& slotIdx, decltype(baseSlot.begin())& slotIt) {
         for (auto it = slot.begin(); it != slot.end(); ++it) // search from beginning
@@ -263,9 +427,10 @@ void TextureBmsBga::seek(const lunaticvibes::Time& t)
                 slotIt = it;
                 if (objs[idx].type == obj::Ty::VIDEO)
                 {
+                    // the video seeks by itself once it sees the new play time
+                    objs[idx].playStartTime = time;
                     auto pt = std::reinterpret_pointer_cast<TextureVideo>(objs[idx].pt);
-                    pt->seek((t - time).norm() / 1000);
-                    pt->update();
+                    pt->setPlayTime((t - time).norm());
                 }
                 return;
             }
@@ -284,6 +449,7 @@ void TextureBmsBga::update(const lunaticvibes::Time& t, bool poor)
 {
     if (!isLoaded())
         return;
+    streamTime = t.norm();
 
     auto seekSub = [&t, this](decltype(baseSlot)& slot, size_t& slotIdx, decltype(baseSlot.begin())& slotIt) {
         auto it = slotIt;
@@ -298,7 +464,8 @@ void TextureBmsBga::update(const lunaticvibes::Time& t, bool poor)
                 if (it != slot.end() && slotIdx != INDEX_INVALID && objs[slotIdx].type == obj::Ty::VIDEO)
                 {
                     auto pt = std::reinterpret_pointer_cast<TextureVideo>(objs[it->second].pt);
-                    pt->start();
+                    if (pt->start())
+                        objs[slotIdx].playStartTime = time;
                     // pt->update();	// Do NOT call update here; videos are updated in main thread with
                     // TextureVideo::updateAll()
                 }
@@ -311,6 +478,16 @@ void TextureBmsBga::update(const lunaticvibes::Time& t, bool poor)
     seekSub(layerSlot, layerIdx, layerIt);
     seekSub(poorSlot, poorIdx, poorIt);
     inPoor = poor;
+
+    // Videos follow the chart clock, so they stay in place through pitch changes and seeks.
+    for (size_t idx : {baseIdx, layerIdx, poorIdx})
+    {
+        if (idx != INDEX_INVALID && objs[idx].type == obj::Ty::VIDEO)
+        {
+            auto pt = std::reinterpret_pointer_cast<TextureVideo>(objs[idx].pt);
+            pt->setPlayTime((t - objs[idx].playStartTime).norm());
+        }
+    }
 }
 
 // LR2 scales bga with some weird rules:
@@ -333,7 +510,7 @@ void lr2ScaleBgaRect(const Rect& srcRect, RectF& dstRect)
 void TextureBmsBga::draw(const Rect& sr, RectF dr, const Color c, const BlendMode b, const bool f, const double a) const
 {
     std::shared_lock l(idxLock);
-    if (inPoor && poorIdx != INDEX_INVALID && objs.at(poorIdx).type != obj::Ty::EMPTY)
+    if (inPoor && poorIdx != INDEX_INVALID && objs.at(poorIdx).type != obj::Ty::EMPTY && objs.at(poorIdx).pt)
     {
         Rect srcRect = objs.at(poorIdx).pt ? objs.at(poorIdx).pt->getRect() : RECT_FULL;
         RectF dstRect = dr;
@@ -342,7 +519,7 @@ void TextureBmsBga::draw(const Rect& sr, RectF dr, const Color c, const BlendMod
     }
     else
     {
-        if (baseIdx != INDEX_INVALID && objs.at(baseIdx).type != obj::Ty::EMPTY)
+        if (baseIdx != INDEX_INVALID && objs.at(baseIdx).type != obj::Ty::EMPTY && objs.at(baseIdx).pt)
         {
             Rect srcRect = objs.at(baseIdx).pt ? objs.at(baseIdx).pt->getRect() : RECT_FULL;
             RectF dstRect = dr;
@@ -352,8 +529,10 @@ void TextureBmsBga::draw(const Rect& sr, RectF dr, const Color c, const BlendMod
 
         if (layerIdx != INDEX_INVALID && objs.at(layerIdx).type != obj::Ty::EMPTY)
         {
-            if (objs.at(layerIdx).type == obj::Ty::PIC && objs_layer.at(layerIdx).pt != nullptr)
+            if (objs.at(layerIdx).type == obj::Ty::PIC)
             {
+                if (objs_layer.at(layerIdx).pt == nullptr)
+                    return; // not resident
                 Rect srcRect = objs_layer.at(layerIdx).pt ? objs_layer.at(layerIdx).pt->getRect() : RECT_FULL;
                 RectF dstRect = dr;
                 lr2ScaleBgaRect(srcRect, dstRect);
@@ -374,7 +553,7 @@ void TextureBmsBga::draw(const Rect& sr, RectF dr, const Color c, const BlendMod
                          const Point& ct) const
 {
     std::shared_lock l(idxLock);
-    if (inPoor && poorIdx != INDEX_INVALID && objs.at(poorIdx).type != obj::Ty::EMPTY)
+    if (inPoor && poorIdx != INDEX_INVALID && objs.at(poorIdx).type != obj::Ty::EMPTY && objs.at(poorIdx).pt)
     {
         Rect srcRect = objs.at(poorIdx).pt ? objs.at(poorIdx).pt->getRect() : RECT_FULL;
         RectF dstRect = dr;
@@ -383,7 +562,7 @@ void TextureBmsBga::draw(const Rect& sr, RectF dr, const Color c, const BlendMod
     }
     else
     {
-        if (baseIdx != INDEX_INVALID && objs.at(baseIdx).type != obj::Ty::EMPTY)
+        if (baseIdx != INDEX_INVALID && objs.at(baseIdx).type != obj::Ty::EMPTY && objs.at(baseIdx).pt)
         {
             Rect srcRect = objs.at(baseIdx).pt ? objs.at(baseIdx).pt->getRect() : RECT_FULL;
             RectF dstRect = dr;
@@ -393,8 +572,10 @@ void TextureBmsBga::draw(const Rect& sr, RectF dr, const Color c, const BlendMod
 
         if (layerIdx != INDEX_INVALID && objs.at(layerIdx).type != obj::Ty::EMPTY)
         {
-            if (objs.at(layerIdx).type == obj::Ty::PIC && objs_layer.at(layerIdx).pt != nullptr)
+            if (objs.at(layerIdx).type == obj::Ty::PIC)
             {
+                if (objs_layer.at(layerIdx).pt == nullptr)
+                    return; // not resident
                 Rect srcRect = objs_layer.at(layerIdx).pt ? objs_layer.at(layerIdx).pt->getRect() : RECT_FULL;
                 RectF dstRect = dr;
                 lr2ScaleBgaRect(srcRect, dstRect);
@@ -445,6 +626,11 @@ void TextureBmsBga::reset()
 
 void TextureBmsBga::clear()
 {
+    streamer = {};
+    streaming = false;
+    residentBytes = 0;
+    timeline.clear();
+    firstUse.clear();
     loaded = false;
     textureRect = Rect();
     baseSlot.clear();
@@ -459,10 +645,176 @@ void TextureBmsBga::clear()
 void TextureBmsBga::setLoaded()
 {
     loaded = true;
+    if (streaming && !streamer.joinable())
+    {
+        LOG_INFO << "[TextureBmsBga] BGA is over the texture budget of " << textureBudget / 1024 / 1024
+                 << " MiB, streaming pictures";
+        streamer = std::jthread([this](std::stop_token st) { streamLoop(st); });
+    }
+}
+
+// Streaming is stopped from the main thread, which then joins the streaming thread. These never wait for the main
+// thread past a stop request.
+
+// Uploads on the main thread. Gives up once stop is requested, the main thread then skips the upload.
+static std::shared_ptr<Texture> uploadUnlessStopped(Image&& image, const std::stop_token& st)
+{
+    struct Upload
+    {
+        explicit Upload(Image&& image) : image(std::move(image)) {}
+        std::mutex m;
+        std::condition_variable_any cv;
+        Image image;
+        std::shared_ptr<Texture> texture;
+        bool done = false;
+        bool abandoned = false;
+    };
+    auto upload = std::make_shared<Upload>(std::move(image));
+    pushMainThreadTask([upload] {
+        std::unique_lock l(upload->m);
+        if (upload->abandoned)
+            return;
+        upload->texture = Texture::createBatch({&upload->image})[0];
+        upload->done = true;
+        upload->cv.notify_all();
+    });
+
+    std::unique_lock l(upload->m);
+    if (!upload->cv.wait(l, st, [&upload] { return upload->done; }))
+    {
+        upload->abandoned = true;
+        return nullptr;
+    }
+    return std::move(upload->texture);
+}
+
+// Destroying a texture waits for the main thread, leave it to the main thread instead.
+static void releaseOnMainThread(std::vector<std::shared_ptr<Texture>>&& textures)
+{
+    if (!textures.empty())
+        pushMainThreadTask([textures = std::move(textures)] {});
+}
+
+void TextureBmsBga::streamLoop(std::stop_token st)
+{
+    SetThreadName("BgaStream");
+    std::mutex m;
+    std::condition_variable_any cv;
+    while (!st.stop_requested())
+    {
+        streamStep(streamTime, st);
+        std::unique_lock l(m);
+        cv.wait_for(l, st, STREAM_INTERVAL, [] { return false; });
+    }
+}
+
+void TextureBmsBga::streamStep(long long t, const std::stop_token& st)
+{
+    // pictures shown within the window, in order of appearance
+    std::vector<std::pair<size_t, bool>> wanted;
+    for (const auto& u : timeline)
+    {
+        if (u.start > t + STREAM_AHEAD_MS)
+            break;
+        if (u.end > t && std::find(wanted.begin(), wanted.end(), std::pair{u.idx, u.layer}) == wanted.end())
+            wanted.emplace_back(u.idx, u.layer);
+    }
+    auto isWanted = [&wanted](size_t idx, bool layer) {
+        return std::find(wanted.begin(), wanted.end(), std::pair{idx, layer}) != wanted.end();
+    };
+
+    for (const auto& [idx, layer] : wanted)
+    {
+        if (st.stop_requested())
+            return;
+
+        Path path;
+        size_t bytes = 0;
+        size_t evictable = 0;
+        {
+            std::shared_lock l(idxLock);
+            auto it = objs.find(idx);
+            if (it == objs.end() || it->second.type != obj::Ty::PIC)
+                continue;
+            const obj& o = layer ? objs_layer.at(idx) : it->second;
+            if (o.pt != nullptr || o.path.empty())
+                continue;
+            path = o.path;
+            bytes = o.bytes;
+
+            for (const auto& [i, e] : objs)
+                if (e.type == obj::Ty::PIC && e.pt && !isWanted(i, false))
+                    evictable += e.bytes;
+            for (const auto& [i, e] : objs_layer)
+                if (e.type == obj::Ty::PIC && e.pt && !isWanted(i, true))
+                    evictable += e.bytes;
+        }
+        if (bytes == 0)
+            bytes = pictureBytes(readPictureSize(path));
+        // The budget is taken by what is shown sooner. A picture of unknown size is decoded if any room is left.
+        if (residentBytes + std::max<size_t>(bytes, 1) > textureBudget + evictable)
+            return;
+
+        Image image(path);
+        if (!image.isLoaded())
+        {
+            std::unique_lock l(idxLock);
+            (layer ? objs_layer : objs)[idx].path.clear(); // do not try again
+            continue;
+        }
+        if (layer)
+            image = image.withTransparentColorRGB(Color(0, 0, 0, 255));
+        bytes = pictureBytes(image.getRect());
+        if (residentBytes + bytes > textureBudget + evictable)
+        {
+            std::unique_lock l(idxLock);
+            (layer ? objs_layer : objs)[idx].bytes = bytes;
+            return;
+        }
+        auto texture = uploadUnlessStopped(std::move(image), st);
+        if (!texture)
+            return;
+
+        // released outside the lock by the main thread, which may be drawing
+        std::vector<std::shared_ptr<Texture>> evicted;
+        bool installed = false;
+        {
+            std::unique_lock l(idxLock);
+            auto evict = [&](std::map<size_t, obj>& m, bool isLayer) {
+                for (auto& [i, e] : m)
+                {
+                    if (residentBytes + bytes <= textureBudget)
+                        return;
+                    if (e.type != obj::Ty::PIC || !e.pt || isWanted(i, isLayer))
+                        continue;
+                    residentBytes -= e.bytes;
+                    evicted.push_back(std::move(e.pt));
+                    e.pt = nullptr;
+                }
+            };
+            evict(objs, false);
+            evict(objs_layer, true);
+            obj& o = (layer ? objs_layer : objs)[idx];
+            o.bytes = bytes;
+            if (residentBytes + bytes <= textureBudget)
+            {
+                o.pt = std::move(texture);
+                residentBytes += bytes;
+                installed = true;
+            }
+        }
+        if (!installed)
+            evicted.push_back(std::move(texture));
+        releaseOnMainThread(std::move(evicted));
+        if (!installed)
+            return;
+    }
 }
 
 void TextureBmsBga::stopUpdate()
 {
+    streamer = {};
+
     auto resetSub = [this](decltype(baseSlot)& slot) {
         for (auto it = slot.begin(); it != slot.end(); ++it) // search from beginning
         {
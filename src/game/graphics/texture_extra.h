@@ -1,7 +1,12 @@
 #pragma once
 
+#include <atomic>
 #include <map>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "common/beat.h"
 #include "video.h"
@@ -10,17 +15,22 @@ class TextureVideo : public Texture
 {
 protected:
     std::shared_ptr<sVideo> pVideo;
-    int64_t decoded_frames = ~0;
+    uint64_t frameSerial = 0;
+    std::atomic<int64_t> playTime = -1; // -1: follow the wall clock
     PixelFormat format;
     bool updated = false;
 
 public:
     TextureVideo(std::shared_ptr<sVideo> pv);
     ~TextureVideo() override;
-    void start();
+    // Returns true if playback started with this call.
+    bool start();
     void stop();
-    void seek(int64_t sec);
+    void seek(int64_t ms);
     void setSpeed(double speed);
+    // Show the frame for this time since start instead of the wall clock, speed is applied on top.
+    void setPlayTime(int64_t ms) { playTime = ms; }
+    sVideo::Stats getStats() const { return pVideo->getStats(); }
     void update();
     void reset();
 
@@ -71,8 +81,10 @@ protected:
             bool base, layer, poor;
         };
 
-        std::shared_ptr<Texture> pt = nullptr;
-        lunaticvibes::Time playStartTime = 0; // video
+        std::shared_ptr<Texture> pt = nullptr; // nullptr for pictures not resident while streaming
+        lunaticvibes::Time playStartTime = 0;  // video
+        Path path;                             // picture, to load it again when streaming
+        size_t bytes = 0;                      // of pt, also kept while not resident. 0 if not known yet
 
         obj() = default;
         obj(Ty t, std::shared_ptr<Texture> pt) : type(t), pt(std::move(pt)) {}
@@ -87,6 +99,28 @@ protected:
     decltype(poorSlot.begin()) poorIt;
     bool inPoor = false;
 
+    // Streaming: with a texture budget, pictures that do not fit at load are kept as paths. A background thread then
+    // keeps the ones shown within the next few seconds of chart time resident, dropping others to make room.
+    struct Use
+    {
+        long long start; // ms
+        long long end;   // next slot of the same channel
+        size_t idx;
+        bool layer; // objs_layer
+    };
+    std::vector<Use> timeline;             // by start
+    std::map<size_t, long long> firstUse;  // ms
+    size_t textureBudget = 0;              // 0 for no limit
+    std::atomic<size_t> residentBytes = 0; // pictures only, including those reserved while decoding
+    bool streaming = false;
+    std::atomic<long long> streamTime = 0; // ms, last update()
+    std::jthread streamer;
+
+    void streamLoop(std::stop_token st);
+    void streamStep(long long t, const std::stop_token& st);
+    // Adds to residentBytes if it stays within the budget.
+    bool reserveBudget(size_t bytes);
+
 public:
     TextureBmsBga(int x = 256, int y = 256) : Texture(nullptr, x, y)
     {
@@ -97,10 +131,33 @@ public:
     ~TextureBmsBga() override { stopUpdate(); }
 
 public:
+    // A #BMP file opened off the main thread, waiting for addDecoded().
+    struct DecodedBmp
+    {
+        size_t idx = INDEX_INVALID;
+        Path path;
+        obj::Ty type = obj::Ty::EMPTY;
+        std::optional<Image> image;
+        std::optional<Image> layer; // black made transparent
+        size_t bytes = 0;           // of each of image and layer, 0 if not known
+        std::shared_ptr<sVideo> video;
+    };
+    // Decodes a picture, or opens a video. Safe to call from several threads at once.
+    // A picture is only decoded if it fits the texture budget, which is then reserved for it. The size is read from the
+    // file header where possible. Pictures that do not fit are only checked for existence and left for streaming.
+    DecodedBmp decodeBmp(size_t idx, Path path);
+    // Uploads the decoded pictures with a single trip to the main thread.
+    void addDecoded(std::vector<DecodedBmp>& batch);
     bool addBmp(size_t idx, Path path);
     bool setSlot(size_t idx, const lunaticvibes::Time& time, bool base, bool layer, bool poor);
     void sortSlot();
+    // Does not mark the texture loaded, call setLoaded() once the pictures are added.
     bool setSlotFromBMS(ChartObjectBMS& bms);
+
+    void setTextureBudget(size_t bytes) { textureBudget = bytes; }
+    // ms of chart time the picture is first shown at, LLONG_MAX if never. Loading in this order fills the budget with
+    // what is needed first.
+    [[nodiscard]] long long getFirstUse(size_t idx) const;
     virtual void seek(const lunaticvibes::Time& t);
 
     virtual void update(const lunaticvibes::Time& t, bool poor);
@@ -112,7 +169,9 @@ public:
     void reset();
     void clear();
 
+    // Starts streaming if some pictures were left out.
     void setLoaded();
+    // Also stops streaming until setLoaded() is called again.
     void stopUpdate();
 
     void setVideoSpeed();
@@ -1,9 +1,11 @@
 #include "video.h"
 #include "common/u8.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <functional>
-#include <thread>
+#include <limits>
 
 extern "C"
 {
@@ -27,15 +29,22 @@ void lunaticvibes::AVPacketDeleter::operator()(AVPacket* avp)
 
 void video_init() {}
 
+// a target this far outside the decoded frames makes the decoder seek instead of catching up
+static constexpr int64_t SEEK_THRESHOLD_MS = 1000;
+// showing a frame this long after it should have been replaced counts as late
+static constexpr int64_t LATE_THRESHOLD_MS = 50;
+
+// timestamps per second
+static double timestampsPerSecond(const AVStream* stream)
+{
+    return stream->time_base.num == 0 ? AV_TIME_BASE : av_q2d(av_inv_q(stream->time_base));
+}
+
 sVideo::~sVideo()
 {
     if (haveVideo)
     {
-        if (playing)
-        {
-            stopPlaying();
-            decodeEnd.wait();
-        }
+        stopPlaying();
         unsetVideo();
     }
 }
@@ -112,19 +121,45 @@ int sVideo::setVideo(const Path& file, double speed, bool loop)
         return -5;
     }
 
+    if (int ret = avcodec_open2(pCodecCtx, pCodec, NULL); ret < 0)
+    {
+        char buf[256];
+        av_strerror(ret, buf, 256);
+        LOG_WARNING << "[Video] Could not open codec of " << file << " (" << buf << ")";
+        return -6;
+    }
+
+    pPacket.reset(av_packet_alloc());
+    for (auto& f : frameQueue)
+        if (!f.frame)
+            f.frame.reset(av_frame_alloc());
+    if (!currentFrame.frame)
+        currentFrame.frame.reset(av_frame_alloc());
+    if (!decodedFrame.frame)
+        decodedFrame.frame.reset(av_frame_alloc());
+
     haveVideo = true;
     w = pCodecCtx->width;
     h = pCodecCtx->height;
+
+    // decodes the first frame right away
+    lunaticvibes::graphics::VideoScheduler::shared().add(this);
     return 0;
 }
 
 int sVideo::unsetVideo()
 {
+    if (haveVideo)
+        lunaticvibes::graphics::VideoScheduler::shared().remove(this);
     haveVideo = false;
     finished = false;
     firstFrame = true;
+    frameHeld = false;
+    draining = false;
+    prefetched = false;
+    loopOffset = 0;
+    loopLength = 0;
     pPacket.reset();
-    pFrame.reset();
     if (pCodecCtx)
         avcodec_free_context(&pCodecCtx);
     if (pFormatCtx)
@@ -156,9 +191,9 @@ void sVideo::startPlaying()
         return;
     if (finished)
         return;
+    startTime = std::chrono::steady_clock::now();
     playing = true;
-    startTime = std::chrono::system_clock::now();
-    decodeEnd = std::async(std::launch::async, std::bind_front(&sVideo::decodeLoop, this));
+    lunaticvibes::graphics::VideoScheduler::shared().wake();
 }
 
 void sVideo::stopPlaying()
@@ -166,171 +201,226 @@ void sVideo::stopPlaying()
     if (!playing)
         return;
     playing = false;
-    decodeEnd.wait();
+    LOG_DEBUG << "[Video] Stopped " << file << ", decoded " << decodedFrames << " dropped " << droppedFrames
+              << " late " << lateFrames;
     seek(0);
 }
 
-void sVideo::decodeLoop()
+bool sVideo::wantsDecode() const
 {
-    if (!haveVideo)
-        return;
-
-    valid = false;
+    if (seekRequest >= 0)
+        return true;
+    if (finished || (!playing && prefetched))
+        return false;
+    return frameQueueTail.load(std::memory_order_relaxed) - frameQueueHead.load(std::memory_order_relaxed) <
+           FRAME_QUEUE_SIZE;
+}
 
-    pFrame.reset(av_frame_alloc());
-    if (pFrame == nullptr)
-    {
-        LOG_WARNING << "[Video] Could not alloc frame object of " << file;
-        return;
-    }
+int64_t sVideo::getDecodeDeadline() const
+{
+    // idle videos only get their first frame, after every playing one is fed
+    if (!playing)
+        return std::numeric_limits<int64_t>::max();
+    return lastQueuedEnd - std::max(int64_t(0), lastTarget.load());
+}
 
-    pPacket.reset(av_packet_alloc());
-    if (pPacket == nullptr)
+void sVideo::decodeStep()
+{
+    if (int64_t target = seekRequest.exchange(-1); target >= 0)
     {
-        LOG_WARNING << "[Video] Could not alloc packet object of " << file;
-        return;
+        int64_t fileTarget = target;
+        loopOffset = 0;
+        if (loop_playback && loopLength > 0)
+        {
+            loopOffset = target - target % loopLength;
+            fileTarget = target % loopLength;
+        }
+        seekFile(fileTarget);
+        skipUntil = target;
+        lastQueuedEnd = target;
+        ++generation;
+        if (frameHeld)
+        {
+            av_frame_unref(decodedFrame.frame.get());
+            frameHeld = false;
+        }
+        draining = false;
+        prefetched = false;
     }
-
-    if (int ret = avcodec_open2(pCodecCtx, pCodec, NULL); ret < 0)
-    {
-        char buf[256];
-        av_strerror(ret, buf, 256);
-        LOG_ERROR << "[Video] Could not open codec of " << file << " (" << buf << ")";
-        unsetVideo();
+    if (finished)
         return;
-    }
 
-    decoding = true;
-
-    // timestamps per second
-    double tsps = pFormatCtx->streams[videoIndex]->time_base.num == 0
-                      ? AV_TIME_BASE
-                      : av_q2d(av_inv_q(pFormatCtx->streams[videoIndex]->time_base));
-    lunaticvibes::AVFramePtr pFrame1{av_frame_alloc()};
-
-    do
+    while (!frameHeld)
     {
-        while (av_read_frame(pFormatCtx, pPacket.get()) == 0 && pPacket != nullptr)
+        int ret = avcodec_receive_frame(pCodecCtx, decodedFrame.frame.get());
+        if (ret == 0)
         {
-            if (!playing)
-                return;
-
-            // Ignore packets from audio streams
-            if (pPacket->stream_index != videoIndex)
-                continue;
-
-            avcodec_send_packet(pCodecCtx, pPacket.get());
-
-            int ret = avcodec_receive_frame(pCodecCtx, pFrame1.get());
-            av_packet_unref(pPacket.get());
-
-            if (ret < 0)
+            frameHeld = stampFrame();
+        }
+        else if (ret == AVERROR(EAGAIN) && !draining)
+        {
+            if (av_read_frame(pFormatCtx, pPacket.get()) < 0)
             {
-                if (ret == AVERROR(EAGAIN))
-                {
-                    continue;
-                }
-                else
-                {
-                    char buf[128];
-                    av_strerror(ret, buf, 128);
-                    LOG_ERROR << "[Video] playback error: " << buf;
-                    decoding = false;
-                    return;
-                }
+                // end of file, get the frames the decoder still holds
+                avcodec_send_packet(pCodecCtx, NULL);
+                draining = true;
             }
-
-            if (pFrame1->best_effort_timestamp >= 0)
+            else
             {
-                if (!(pFrame1->flags & AV_FRAME_FLAG_CORRUPT))
-                {
-                    std::unique_lock l(video_frame_mutex);
-
-                    av_frame_unref(pFrame.get());
-                    av_frame_ref(pFrame.get(), pFrame1.get());
-                    valid = true;
-                }
-
-                using namespace std::chrono;
-                auto frameTime_ms =
-                    static_cast<long long>(std::round(pFrame1->best_effort_timestamp / tsps * 1000 / speed));
-                if (firstFrame)
-                {
-                    firstFrame = false;
-                    startTime -= milliseconds(frameTime_ms);
-                }
-                else
-                {
-                    if (duration_cast<milliseconds>(system_clock::now() - startTime).count() < frameTime_ms)
-                    {
-                        std::this_thread::sleep_until(startTime + milliseconds(frameTime_ms));
-                    }
-                }
+                // Ignore packets from audio streams
+                if (pPacket->stream_index == videoIndex)
+                    avcodec_send_packet(pCodecCtx, pPacket.get());
+                av_packet_unref(pPacket.get());
             }
-            decoded_frames = pCodecCtx->frame_num;
         }
-
-        if (loop_playback)
+        else if (ret == AVERROR_EOF && loop_playback && lastFrameEnd > loopOffset)
         {
-            using namespace std::chrono_literals;
-            // std::this_thread::sleep_for(33ms);
-            decoded_frames = 0;
-            seek(0, true);
-            startTime = std::chrono::system_clock::now();
+            loopLength = lastFrameEnd - loopOffset;
+            loopOffset = lastFrameEnd;
+            seekFile(0);
+            draining = false;
         }
         else
         {
-            // drain
-            avcodec_send_packet(pCodecCtx, NULL);
+            if (ret != AVERROR_EOF)
             {
-                // av_frame_unref(frame) is omitted
-                if (int ret = avcodec_receive_frame(pCodecCtx, pFrame1.get()))
-                {
-                    char buf[128];
-                    av_strerror(ret, buf, 128);
-                    LOG_ERROR << "[Video] playback drain error: " << buf;
-                }
-                if (pFrame1->best_effort_timestamp >= 0)
-                {
-                    std::unique_lock l(video_frame_mutex);
-
-                    av_frame_unref(pFrame.get());
-                    av_frame_ref(pFrame.get(), pFrame1.get());
-                    valid = true;
-                }
-                decoded_frames = pCodecCtx->frame_num;
+                char buf[128];
+                av_strerror(ret, buf, 128);
+                LOG_ERROR << "[Video] playback error: " << buf;
             }
-
-            playing = false;
             finished = true;
+            playing = false;
+            return;
         }
+    }
+    pushFrame();
+}
 
-    } while (playing);
+bool sVideo::stampFrame()
+{
+    AVFrame* frame = decodedFrame.frame.get();
+    if (frame->best_effort_timestamp < 0 || (frame->flags & AV_FRAME_FLAG_CORRUPT))
+    {
+        av_frame_unref(frame);
+        return false;
+    }
 
-    decoding = false;
+    const double tsps = timestampsPerSecond(pFormatCtx->streams[videoIndex]);
+    const auto pts = static_cast<int64_t>(std::round(frame->best_effort_timestamp / tsps * 1000));
+    if (firstFrame)
+    {
+        firstFrame = false;
+        firstFrameTime = pts;
+    }
+    decodedFrame.time = pts - firstFrameTime + loopOffset;
+    decodedFrame.end =
+        decodedFrame.time + std::max(int64_t(1), static_cast<int64_t>(std::round(frame->duration / tsps * 1000)));
+    decodedFrame.generation = generation;
+    lastFrameEnd = decodedFrame.end;
+    ++decodedFrames;
+
+    // decoding from the key frame up to a seek target
+    if (decodedFrame.end <= skipUntil)
+    {
+        av_frame_unref(frame);
+        return false;
+    }
+    return true;
 }
 
-void sVideo::seek(int64_t second, bool backwards)
+bool sVideo::pushFrame()
 {
-    if (!haveVideo)
-        return;
-    if (second == 0)
-        firstFrame = true;
+    const size_t tail = frameQueueTail.load(std::memory_order_relaxed);
+    if (tail - frameQueueHead.load(std::memory_order_acquire) >= FRAME_QUEUE_SIZE)
+        return false;
+
+    QueuedFrame& slot = frameQueue[tail % FRAME_QUEUE_SIZE];
+    av_frame_unref(slot.frame.get());
+    std::swap(slot, decodedFrame);
+    frameQueueTail.store(tail + 1, std::memory_order_release);
+    frameHeld = false;
+    lastQueuedEnd = slot.end;
+    if (!playing)
+        prefetched = true;
+    return true;
+}
+
+AVFrame* sVideo::getFrame(int64_t mediaTime, uint64_t& serial)
+{
+    size_t head = frameQueueHead.load(std::memory_order_relaxed);
+    const size_t tail = frameQueueTail.load(std::memory_order_acquire);
+    // every queued frame is from this generation or an older one
+    const unsigned gen = generation;
 
-    // timestamps per second
-    double tsps = pFormatCtx->streams[videoIndex]->time_base.num == 0
-                      ? AV_TIME_BASE
-                      : av_q2d(av_inv_q(pFormatCtx->streams[videoIndex]->time_base));
+    unsigned popped = 0;
+    for (; head != tail; ++head)
+    {
+        QueuedFrame& f = frameQueue[head % FRAME_QUEUE_SIZE];
+        if (f.generation != gen)
+            continue; // from before a seek
+        if (f.time > mediaTime)
+            break;
+        std::swap(currentFrame, f);
+        ++popped;
+    }
+    frameQueueHead.store(head, std::memory_order_release);
+
+    if (popped > 0)
+    {
+        ++currentFrameSerial;
+        lunaticvibes::graphics::VideoScheduler::shared().wake();
+    }
+    if (popped > 1)
+        droppedFrames += popped - 1;
 
-    if (int ret = av_seek_frame(pFormatCtx, videoIndex, int64_t(std::round(second / tsps)),
-                                backwards ? AVSEEK_FLAG_BACKWARD : 0);
-        ret >= 0)
+    if (mediaTime != lastTarget && playing && seekRequest < 0)
     {
-        finished = false;
-        avcodec_flush_buffers(pCodecCtx);
+        lastTarget = mediaTime;
+        const bool haveCurrent = currentFrameSerial > 0 && currentFrame.generation == gen;
+        const bool seekPending = int(currentFrame.generation - seekGeneration) < 0;
+        if ((haveCurrent && mediaTime < currentFrame.time - SEEK_THRESHOLD_MS) ||
+            (!seekPending && head == tail && mediaTime > (haveCurrent ? currentFrame.end : 0) + SEEK_THRESHOLD_MS))
+        {
+            // jumped back, or too far ahead to catch up by decoding
+            seekGeneration = gen + 1;
+            seek(mediaTime);
+        }
+        else if (haveCurrent && head == tail && mediaTime > currentFrame.end + LATE_THRESHOLD_MS)
+        {
+            ++lateFrames;
+        }
     }
-    else
+
+    serial = currentFrameSerial;
+    return currentFrameSerial > 0 ? currentFrame.frame.get() : nullptr;
+}
+
+int64_t sVideo::getPlaybackTime() const
+{
+    using namespace std::chrono;
+    if (startTime == steady_clock::time_point{})
+        return 0;
+    return static_cast<int64_t>(duration_cast<milliseconds>(steady_clock::now() - startTime).count() * speed);
+}
+
+void sVideo::seek(int64_t ms)
+{
+    if (!haveVideo)
+        return;
+    finished = false;
+    seekRequest = std::max(int64_t(0), ms);
+    lunaticvibes::graphics::VideoScheduler::shared().wake();
+}
+
+bool sVideo::seekFile(int64_t ms)
+{
+    const double tsps = timestampsPerSecond(pFormatCtx->streams[videoIndex]);
+    const auto ts = static_cast<int64_t>(std::round((ms + firstFrameTime) / 1000.0 * tsps));
+    if (int ret = av_seek_frame(pFormatCtx, videoIndex, ts, AVSEEK_FLAG_BACKWARD); ret < 0)
     {
-        LOG_ERROR << "[Video] seek " << second << "s error (" << file << ")";
+        LOG_ERROR << "[Video] seek " << ms << "ms error (" << file << ")";
+        return false;
     }
+    avcodec_flush_buffers(pCodecCtx);
+    return true;
 }
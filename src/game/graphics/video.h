@@ -1,13 +1,14 @@
 #pragma once
 
-#include <future>
+#include <array>
+#include <atomic>
 #include <memory>
 #include <set>
-#include <shared_mutex>
 #include <type_traits>
 
 #include "common/types.h"
 #include "graphics.h"
+#include "video_scheduler.h"
 
 inline const std::set<std::string> video_file_extensions = {
     ".mpg", ".mp2", ".mpeg", ".mpeg2", ".mpe", ".mpv",  ".flv", ".mp4", ".m4p",
@@ -42,7 +43,12 @@ using AVPacketPtr = std::unique_ptr<AVPacket, AVPacketDeleter>;
 } // namespace lunaticvibes
 
 // libav decoder wrap
-class sVideo
+// The decoder runs ahead of playback on a VideoScheduler worker and fills a small ring of frames stamped with their
+// media time (ms since the first frame, growing across loops). The main thread picks the frame for a given media time
+// with getFrame(), so the shown frame follows whichever clock the caller uses; a target far outside the decoded range
+// makes the decoder seek. The ring is single producer (decoder) single consumer (main thread), no locks on either side.
+// While not playing only the first frame is decoded ahead.
+class sVideo : public lunaticvibes::graphics::VideoScheduler::Source
 {
     friend class SceneBase;
     friend class SkinBase;
@@ -51,33 +57,71 @@ public:
     Path file;
     bool haveVideo = false;
 
+    static constexpr size_t FRAME_QUEUE_SIZE = 8;
+
+    struct Stats
+    {
+        uint64_t decoded = 0;
+        uint64_t dropped = 0; // decoded but never shown, the consumer went past them
+        uint64_t late = 0;    // main thread updates where the decoder had nothing recent enough
+    };
+
 private:
+    struct QueuedFrame
+    {
+        lunaticvibes::AVFramePtr frame;
+        int64_t time = 0;        // media time in ms
+        int64_t end = 0;         // time + duration
+        unsigned generation = 0; // frames from before a seek are discarded
+    };
+
     // decoder params
     AVFormatContext* pFormatCtx = nullptr;
     const AVCodec* pCodec = nullptr;
     AVCodecContext* pCodecCtx = nullptr;
-    lunaticvibes::AVFramePtr pFrame;
     lunaticvibes::AVPacketPtr pPacket;
     int videoIndex = -1;
-    int64_t decoded_frames = 0;
-    std::chrono::time_point<std::chrono::system_clock> startTime;
-    std::future<void> decodeEnd;
+    std::chrono::time_point<std::chrono::steady_clock> startTime;
+
+    // frame ring
+    std::array<QueuedFrame, FRAME_QUEUE_SIZE> frameQueue;
+    std::atomic<size_t> frameQueueHead = 0; // next to show, written by the consumer
+    std::atomic<size_t> frameQueueTail = 0; // next to fill, written by the decoder
+    std::atomic<unsigned> generation = 0;
+    std::atomic<int64_t> seekRequest = -1; // media time, handled by the decoder
+    std::atomic<int64_t> lastQueuedEnd = 0;
+    QueuedFrame currentFrame; // consumer owned
+    uint64_t currentFrameSerial = 0;
+    unsigned seekGeneration = 0; // generation of the last seek getFrame() asked for
+    std::atomic<int64_t> lastTarget = -1;
+    std::atomic<uint64_t> decodedFrames = 0;
+    std::atomic<uint64_t> droppedFrames = 0;
+    std::atomic<uint64_t> lateFrames = 0;
+
+    // decoder owned
+    QueuedFrame decodedFrame;   // waiting for room in the ring if frameHeld
+    bool frameHeld = false;
+    bool draining = false;
+    int64_t skipUntil = -1;
+    std::atomic<bool> prefetched = false; // first frame queued while not playing
+    int64_t firstFrameTime = 0;           // pts of the first frame in ms
+    int64_t loopOffset = 0;     // media time where the current loop started
+    int64_t loopLength = 0;     // 0 until the first loop has ended
+    int64_t lastFrameEnd = 0;
 
     // render properties
     Path filePath;
-    double speed = 1.0;
+    std::atomic<double> speed = 1.0;
     int w = -1, h = -1; // set in setVideo()
-    bool playing = false;
-    bool finished = false;
-    bool decoding = false;
+    std::atomic<bool> playing = false;
+    std::atomic<bool> finished = false;
     bool firstFrame = true;
-    bool valid = false;
     bool loop_playback = false;
 
 public:
     sVideo() = default;
     sVideo(const Path& file, double speed = 1.0, bool loop = false) { setVideo(file, speed, loop); }
-    virtual ~sVideo();
+    ~sVideo() override;
     int setVideo(const Path& file, double speed, bool loop = false);
     int unsetVideo();
     int getW() const { return w; }
@@ -92,15 +136,28 @@ public:
     // video playback control
     void startPlaying();
     void stopPlaying();
-    void decodeLoop();
 
-    int64_t getDecodedFrames() const { return decoded_frames; }
-    AVFrame* getFrame() const { return valid ? pFrame.get() : NULL; }
+    // VideoScheduler::Source
+    bool wantsDecode() const override;
+    int64_t getDecodeDeadline() const override;
+    void decodeStep() override;
 
-public:
-    std::shared_mutex video_frame_mutex;
+    // Latest decoded frame at or before the media time, nullptr if there is none yet. serial changes whenever a
+    // different frame is returned. Main thread only.
+    AVFrame* getFrame(int64_t mediaTime, uint64_t& serial);
+    // Media time by the wall clock since startPlaying(), speed applied.
+    int64_t getPlaybackTime() const;
+    Stats getStats() const { return {decodedFrames, droppedFrames, lateFrames}; }
 
 public:
     void setSpeed(double speed) { this->speed = speed; }
-    void seek(int64_t second, bool backwards = false);
-};
\ No newline at end of file
+    double getSpeed() const { return speed; }
+    // Asynchronous, the decoder picks it up on its next packet.
+    void seek(int64_t ms);
+
+private:
+    bool seekFile(int64_t ms);
+    // Stamps a frame fresh out of the decoder, false if it is to be skipped.
+    bool stampFrame();
+    bool pushFrame();
+};
@@ -0,0 +1,117 @@
+#include "video_scheduler.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "common/log.h"
+#include "common/sysutil.h"
+
+namespace lunaticvibes::graphics
+{
+
+unsigned VideoScheduler::defaultWorkerCount()
+{
+    return std::clamp(std::thread::hardware_concurrency() / 4, 1u, 4u);
+}
+
+VideoScheduler::VideoScheduler(unsigned workers)
+{
+    workers = std::max(1u, workers);
+    LOG_DEBUG << "[VideoScheduler] Starting " << workers << " decode workers";
+    _workers.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i)
+        _workers.emplace_back([this](std::stop_token st) { workerLoop(st); });
+}
+
+VideoScheduler::~VideoScheduler()
+{
+    {
+        std::unique_lock l{_mutex};
+        for (auto& w : _workers)
+            w.request_stop();
+    }
+    _cv.notify_all();
+    _workers.clear();
+}
+
+VideoScheduler& VideoScheduler::shared()
+{
+    // never destroyed, videos held by static objects are closed after every function-local static is gone
+    static auto* scheduler = new VideoScheduler();
+    return *scheduler;
+}
+
+void VideoScheduler::add(Source* source)
+{
+    {
+        std::unique_lock l{_mutex};
+        _jobs.push_back({source});
+    }
+    _cv.notify_all();
+}
+
+void VideoScheduler::remove(Source* source)
+{
+    std::unique_lock l{_mutex};
+    auto it = std::find_if(_jobs.begin(), _jobs.end(), [source](const Job& j) { return j.source == source; });
+    if (it == _jobs.end())
+        return;
+    it->removing = true;
+    _cv.wait(l, [&] {
+        // another remove() of the same source may have erased it meanwhile
+        it = std::find_if(_jobs.begin(), _jobs.end(), [source](const Job& j) { return j.source == source; });
+        return it == _jobs.end() || !it->busy;
+    });
+    if (it != _jobs.end())
+        _jobs.erase(it);
+}
+
+void VideoScheduler::wake()
+{
+    // A worker holds the lock from checking the sources until it waits, so the notification cannot slip in between.
+    {
+        std::unique_lock l{_mutex};
+    }
+    _cv.notify_one();
+}
+
+void VideoScheduler::workerLoop(std::stop_token st)
+{
+    SetThreadName("VideoDecode");
+
+    std::unique_lock l{_mutex};
+    while (!st.stop_requested())
+    {
+        Job* next = nullptr;
+        int64_t nextDeadline = std::numeric_limits<int64_t>::max();
+        for (auto& j : _jobs)
+        {
+            if (j.busy || j.removing || !j.source->wantsDecode())
+                continue;
+            if (int64_t d = j.source->getDecodeDeadline(); next == nullptr || d < nextDeadline)
+            {
+                next = &j;
+                nextDeadline = d;
+            }
+        }
+        if (next == nullptr)
+        {
+            // until add(), wake() or another worker finishing a step
+            _cv.wait(l);
+            continue;
+        }
+
+        next->busy = true;
+        Source* source = next->source;
+        l.unlock();
+        source->decodeStep();
+        l.lock();
+
+        // _jobs may have grown meanwhile, but a busy job is never erased
+        auto it = std::find_if(_jobs.begin(), _jobs.end(), [source](const Job& j) { return j.source == source; });
+        it->busy = false;
+        _cv.notify_all();
+    }
+}
+
+} // namespace lunaticvibes::graphics
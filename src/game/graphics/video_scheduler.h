@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lunaticvibes::graphics
+{
+
+// Decodes every open video on a few shared threads instead of one thread per video.
+// A free worker takes the runnable source with the earliest deadline and lets it decode one step, then picks again.
+// A source is only ever decoded by one worker at a time. Workers with nothing to run sleep until woken, sources do not
+// get polled.
+class VideoScheduler
+{
+public:
+    class Source
+    {
+    public:
+        virtual ~Source() = default;
+        // Has work to do: room for another frame while playing, a pending seek, or the first frame while idle.
+        [[nodiscard]] virtual bool wantsDecode() const = 0;
+        // Lower is more urgent, e.g. ms of decoded frames left ahead of the consumer.
+        [[nodiscard]] virtual int64_t getDecodeDeadline() const = 0;
+        // Decode until one frame is queued or nothing can be done right now. Should be short.
+        virtual void decodeStep() = 0;
+    };
+
+    static unsigned defaultWorkerCount();
+
+    explicit VideoScheduler(unsigned workers = defaultWorkerCount());
+    ~VideoScheduler();
+    VideoScheduler(const VideoScheduler&) = delete;
+    VideoScheduler& operator=(const VideoScheduler&) = delete;
+
+    // The process-wide instance used by sVideo.
+    static VideoScheduler& shared();
+
+    void add(Source* source);
+    // Waits for a step of the source running on a worker.
+    void remove(Source* source);
+    // A source may have become runnable. Must be called whenever wantsDecode() of a source may have turned true other
+    // than by its own decodeStep().
+    void wake();
+
+    [[nodiscard]] unsigned getWorkerCount() const { return static_cast<unsigned>(_workers.size()); }
+
+private:
+    struct Job
+    {
+        Source* source;
+        bool busy = false;
+        bool removing = false; // not scheduled again while remove() waits for the running step
+    };
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::vector<Job> _jobs;
+    std::vector<std::jthread> _workers;
+
+    void workerLoop(std::stop_token st);
+};
+
+} // namespace lunaticvibes::graphics
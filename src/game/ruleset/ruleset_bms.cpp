@@ -414,22 +414,28 @@ RulesetBMS::RulesetBMS(std::shared_ptr<ChartFormatBase> format, std::shared_ptr<
 
     if (_chart)
     {
+        std::map<chart::NoteLane, ChartObjectBase::NoteIterator> noteListIterators;
         for (size_t k = Input::S1L; k <= Input::K2SPDDN; ++k)
         {
-            NoteLaneIndex idx;
-            idx = _chart->getLaneFromKey(NoteLaneCategory::Note, (Input::Pad)k);
-            if (idx != NoteLaneIndex::_)
-                _noteListIterators[{NoteLaneCategory::Note, idx}] = _chart->firstNote(NoteLaneCategory::Note, idx);
-            idx = _chart->getLaneFromKey(NoteLaneCategory::LN, (Input::Pad)k);
-            if (idx != NoteLaneIndex::_)
-                _noteListIterators[{NoteLaneCategory::LN, idx}] = _chart->firstNote(NoteLaneCategory::LN, idx);
-            idx = _chart->getLaneFromKey(NoteLaneCategory::Mine, (Input::Pad)k);
-            if (idx != NoteLaneIndex::_)
-                _noteListIterators[{NoteLaneCategory::Mine, idx}] = _chart->firstNote(NoteLaneCategory::Mine, idx);
-            idx = _chart->getLaneFromKey(NoteLaneCategory::Invs, (Input::Pad)k);
-            if (idx != NoteLaneIndex::_)
-                _noteListIterators[{NoteLaneCategory::Invs, idx}] = _chart->firstNote(NoteLaneCategory::Invs, idx);
+            PadLanes& lanes = _padLanes[k];
+            lanes.note = _chart->getLaneFromKey(NoteLaneCategory::Note, (Input::Pad)k);
+            if (lanes.note != NoteLaneIndex::_)
+                noteListIterators[{NoteLaneCategory::Note, lanes.note}] =
+                    _chart->firstNote(NoteLaneCategory::Note, lanes.note);
+            lanes.ln = _chart->getLaneFromKey(NoteLaneCategory::LN, (Input::Pad)k);
+            if (lanes.ln != NoteLaneIndex::_)
+                noteListIterators[{NoteLaneCategory::LN, lanes.ln}] = _chart->firstNote(NoteLaneCategory::LN, lanes.ln);
+            lanes.mine = _chart->getLaneFromKey(NoteLaneCategory::Mine, (Input::Pad)k);
+            if (lanes.mine != NoteLaneIndex::_)
+                noteListIterators[{NoteLaneCategory::Mine, lanes.mine}] =
+                    _chart->firstNote(NoteLaneCategory::Mine, lanes.mine);
+            lanes.invs = _chart->getLaneFromKey(NoteLaneCategory::Invs, (Input::Pad)k);
+            if (lanes.invs != NoteLaneIndex::_)
+                noteListIterators[{NoteLaneCategory::Invs, lanes.invs}] =
+                    _chart->firstNote(NoteLaneCategory::Invs, lanes.invs);
+            lanes.scratch = k == Input::S1L || k == Input::S1R || k == Input::S2L || k == Input::S2R;
         }
+        _noteListIterators.assign(noteListIterators.begin(), noteListIterators.end());
     }
 }
 
@@ -1377,6 +1383,59 @@ void RulesetBMS::updateAxis(double s1, double s2, const lunaticvibes::Time& t)
     }
 }
 
+bool RulesetBMS::_isLaneDue(NoteLaneCategory cat, NoteLaneIndex idx, const lunaticvibes::Time& rt)
+{
+    const LaneDeadline& d = _laneDeadlines[channelToIdx(cat, idx)];
+    const auto incoming =
+        static_cast<size_t>(std::distance(_chart->firstNote(cat, idx), _chart->incomingNote(cat, idx)));
+    return incoming != d.incoming || rt >= d.time;
+}
+
+// Judges and presses only ever expire notes, which can move the deadline later but never earlier, so a stale
+// deadline just costs one pass over the lane that does nothing.
+void RulesetBMS::_updateLaneDeadline(NoteLaneCategory cat, NoteLaneIndex idx, bool scratch)
+{
+    LaneDeadline& d = _laneDeadlines[channelToIdx(cat, idx)];
+    const auto itNote = _chart->incomingNote(cat, idx);
+    d.incoming = static_cast<size_t>(std::distance(_chart->firstNote(cat, idx), itNote));
+    if (_chart->isLastNote(cat, idx, itNote))
+    {
+        d.time = lunaticvibes::Time{LLONG_MAX, true};
+        return;
+    }
+
+    // An expired incoming note stops update() from looking further until the chart moves past it.
+    d.time = itNote->time;
+    if (itNote->expired)
+        return;
+
+    const lunaticvibes::Time& bad = judgeTime[(size_t)_judgeDifficulty].BAD;
+    switch (cat)
+    {
+    case NoteLaneCategory::Note:
+        if (!scratch || _judgeScratch)
+            d.time = itNote->time + bad;
+        break;
+
+    case NoteLaneCategory::LN:
+        if (!(itNote->flags & Note::LN_TAIL))
+        {
+            d.time = itNote->time + bad;
+            auto itTail = std::next(itNote);
+            if (!_chart->isLastNote(cat, idx, itTail) && (itTail->flags & Note::LN_TAIL) && d.time > itTail->time)
+                d.time = itTail->time;
+        }
+        break;
+
+    case NoteLaneCategory::Invs: d.time = itNote->time - bad; break;
+
+    case NoteLaneCategory::_:
+    case NoteLaneCategory::Mine:
+    case NoteLaneCategory::EXTRA:
+    case NoteLaneCategory::NOTECATEGORY_COUNT: break;
+    }
+}
+
 void RulesetBMS::update(const lunaticvibes::Time& t)
 {
     if (!_hasStartTime)
@@ -1413,22 +1472,13 @@ void RulesetBMS::update(const lunaticvibes::Time& t)
     auto updateRange = [&](Input::Pad begin, Input::Pad end, int slot) {
         for (size_t k = begin; k <= static_cast<size_t>(end); ++k)
         {
-            auto is_scratch_input = [](size_t k) {
-                switch (k)
-                {
-                case Input::S1L:
-                case Input::S1R:
-                case Input::S2L:
-                case Input::S2R: return true;
-                default: return false;
-                }
-            };
-            const bool scratch = is_scratch_input(k);
+            const PadLanes& lanes = _padLanes[k];
+            const bool scratch = lanes.scratch;
 
             NoteLaneIndex idx;
 
-            idx = _chart->getLaneFromKey(NoteLaneCategory::Note, (Input::Pad)k);
-            if (idx != NoteLaneIndex::_)
+            idx = lanes.note;
+            if (idx != NoteLaneIndex::_ && _isLaneDue(NoteLaneCategory::Note, idx, rt))
             {
                 auto itNote = _chart->incomingNote(NoteLaneCategory::Note, idx);
                 while (!_chart->isLastNote(NoteLaneCategory::Note, idx, itNote) && !itNote->expired)
@@ -1461,16 +1511,25 @@ void RulesetBMS::update(const lunaticvibes::Time& t)
                         notesExpired++;
                         // LOG_DEBUG << "LATE   POOR    "; break;
                     }
+                    else
+                    {
+                        // notes are sorted by time, the rest of the lane is not due either
+                        break;
+                    }
                     itNote++;
                 }
+                _updateLaneDeadline(NoteLaneCategory::Note, idx, scratch);
             }
 
-            idx = _chart->getLaneFromKey(NoteLaneCategory::LN, (Input::Pad)k);
-            if (idx != NoteLaneIndex::_)
+            idx = lanes.ln;
+            if (idx != NoteLaneIndex::_ && _isLaneDue(NoteLaneCategory::LN, idx, rt))
             {
                 auto itNote = _chart->incomingNote(NoteLaneCategory::LN, idx);
                 while (!_chart->isLastNote(NoteLaneCategory::LN, idx, itNote) && !itNote->expired)
                 {
+                    if (rt < itNote->time)
+                        break;
+
                     if (!(itNote->flags & Note::LN_TAIL))
                     {
                         if (rt >= itNote->time)
@@ -1529,10 +1588,11 @@ void RulesetBMS::update(const lunaticvibes::Time& t)
                     }
                     itNote++;
                 }
+                _updateLaneDeadline(NoteLaneCategory::LN, idx, scratch);
             }
 
-            idx = _chart->getLaneFromKey(NoteLaneCategory::Invs, (Input::Pad)k);
-            if (idx != NoteLaneIndex::_)
+            idx = lanes.invs;
+            if (idx != NoteLaneIndex::_ && _isLaneDue(NoteLaneCategory::Invs, idx, rt))
             {
                 const lunaticvibes::Time& hitTime = -judgeTime[(size_t)_judgeDifficulty].BAD;
                 auto itNote = _chart->incomingNote(NoteLaneCategory::Invs, idx);
@@ -1542,10 +1602,11 @@ void RulesetBMS::update(const lunaticvibes::Time& t)
                     itNote->expired = true;
                     itNote++;
                 }
+                _updateLaneDeadline(NoteLaneCategory::Invs, idx, scratch);
             }
 
-            idx = _chart->getLaneFromKey(NoteLaneCategory::Mine, (Input::Pad)k);
-            if (idx != NoteLaneIndex::_)
+            idx = lanes.mine;
+            if (idx != NoteLaneIndex::_ && _isLaneDue(NoteLaneCategory::Mine, idx, rt))
             {
                 auto itNote = _chart->incomingNote(NoteLaneCategory::Mine, idx);
                 while (!_chart->isLastNote(NoteLaneCategory::Mine, idx, itNote) && !itNote->expired &&
@@ -1554,6 +1615,7 @@ void RulesetBMS::update(const lunaticvibes::Time& t)
                     itNote->expired = true;
                     itNote++;
                 }
+                _updateLaneDeadline(NoteLaneCategory::Mine, idx, scratch);
             }
         }
     };
@@ -4,7 +4,11 @@
 #include "game/scene/scene_context.h"
 #include "ruleset.h"
 
+#include <array>
+#include <limits>
 #include <memory>
+#include <utility>
+#include <vector>
 
 using lunaticvibes::parser_bms::JudgeDifficulty;
 
@@ -181,12 +185,32 @@ protected:
     std::string modifierText, modifierTextShort;
     Option::e_lamp_type saveLampMax;
 
+    // Lanes of each input pad, looked up once instead of on every update.
+    struct PadLanes
+    {
+        chart::NoteLaneIndex note = chart::NoteLaneIndex::_;
+        chart::NoteLaneIndex ln = chart::NoteLaneIndex::_;
+        chart::NoteLaneIndex invs = chart::NoteLaneIndex::_;
+        chart::NoteLaneIndex mine = chart::NoteLaneIndex::_;
+        bool scratch = false;
+    };
+    std::array<PadLanes, Input::LANE_COUNT> _padLanes{};
+
 protected:
     // members change in game
     std::array<JudgeArea, chart::NOTELANEINDEX_COUNT> _lnJudge{JudgeArea::NOTHING};
     std::array<JudgeRes, 2> _lastNoteJudge{};
 
-    std::map<chart::NoteLane, ChartObjectBase::NoteIterator> _noteListIterators;
+    std::vector<std::pair<chart::NoteLane, ChartObjectBase::NoteIterator>> _noteListIterators;
+
+    // Earliest play time at which update() may have to expire a note in the lane, valid while the incoming note
+    // of the lane stays at the same position. Lanes are skipped until then.
+    struct LaneDeadline
+    {
+        size_t incoming = std::numeric_limits<size_t>::max();
+        lunaticvibes::Time time{0};
+    };
+    std::array<LaneDeadline, chart::LANE_ALL_KEY_COUNT> _laneDeadlines{};
 
     std::array<AxisDir, 2> playerScratchDirection = {0, 0};
     std::array<lunaticvibes::Time, 2> playerScratchLastUpdate = {TIMER_NEVER, TIMER_NEVER};
@@ -221,6 +245,8 @@ private:
     void judgeNoteRelease(Input::Pad k, const lunaticvibes::Time& t, const lunaticvibes::Time& rt, int slot);
     void _updateHp(double diff);
     void _updateHp(JudgeArea judge);
+    bool _isLaneDue(chart::NoteLaneCategory cat, chart::NoteLaneIndex idx, const lunaticvibes::Time& rt);
+    void _updateLaneDeadline(chart::NoteLaneCategory cat, chart::NoteLaneIndex idx, bool scratch);
 
 public:
     // Register to InputWrapper
@@ -3,6 +3,7 @@
 #include "common/types.h"
 
 State State::_inst;
+thread_local const State::Snapshot* State::_readSnapshot = nullptr;
 
 State::State()
 {
@@ -27,6 +28,8 @@ bool State::set(IndexBargraph ind, Ratio val)
 
 double State::get(IndexBargraph ind)
 {
+    if (_readSnapshot)
+        return decltype(_inst.gBargraphs)::get(_readSnapshot->bargraphs, ind);
     return _inst.gBargraphs.get(ind);
 }
 
@@ -37,6 +40,8 @@ bool State::set(IndexNumber ind, int val)
 
 int State::get(IndexNumber ind)
 {
+    if (_readSnapshot)
+        return decltype(_inst.gNumbers)::get(_readSnapshot->numbers, ind);
     return _inst.gNumbers.get(ind);
 }
 
@@ -47,6 +52,8 @@ bool State::set(IndexOption ind, unsigned val)
 
 unsigned State::get(IndexOption ind)
 {
+    if (_readSnapshot)
+        return decltype(_inst.gOptions)::get(_readSnapshot->options, ind);
     return _inst.gOptions.get(ind);
 }
 
@@ -57,6 +64,8 @@ bool State::set(IndexSlider ind, Ratio val)
 
 double State::get(IndexSlider ind)
 {
+    if (_readSnapshot)
+        return decltype(_inst.gSliders)::get(_readSnapshot->sliders, ind);
     return _inst.gSliders.get(ind);
 }
 
@@ -67,6 +76,8 @@ bool State::set(IndexSwitch ind, bool val)
 
 bool State::get(IndexSwitch ind)
 {
+    if (_readSnapshot)
+        return decltype(_inst.gSwitches)::get(_readSnapshot->switches, ind);
     return _inst.gSwitches.get(ind);
 }
 
@@ -87,6 +98,8 @@ bool State::set(IndexTimer ind, long long val)
 
 long long State::get(IndexTimer ind)
 {
+    if (_readSnapshot)
+        return decltype(_inst.gTimers)::get(_readSnapshot->timers, ind);
     return _inst.gTimers.get(ind);
 }
 
@@ -96,3 +109,35 @@ void State::resetTimer()
     _inst.gTimers.reset();
     set(IndexTimer::_SCENE_CUSTOMIZE_START, customizeTimer);
 }
+
+void State::publishSnapshot()
+{
+    std::unique_lock l{_inst._snapshotPublishMutex, std::try_to_lock};
+    if (!l.owns_lock())
+        return;
+
+    Snapshot& s = _inst._snapshots[_inst._snapshotBack];
+    _inst.gBargraphs.copyTo(s.bargraphs);
+    _inst.gNumbers.copyTo(s.numbers);
+    _inst.gOptions.copyTo(s.options);
+    _inst.gSliders.copyTo(s.sliders);
+    _inst.gSwitches.copyTo(s.switches);
+    _inst.gTimers.copyTo(s.timers);
+    _inst._snapshotBack =
+        _inst._snapshotShared.exchange(_inst._snapshotBack | SNAPSHOT_FRESH, std::memory_order_acq_rel) & 3;
+    _inst._snapshotValid.store(true, std::memory_order_release);
+}
+
+const State::Snapshot* State::acquireSnapshot()
+{
+    if (!_inst._snapshotValid.load(std::memory_order_acquire))
+        return nullptr;
+    if (_inst._snapshotShared.load(std::memory_order_relaxed) & SNAPSHOT_FRESH)
+        _inst._snapshotFront = _inst._snapshotShared.exchange(_inst._snapshotFront, std::memory_order_acq_rel) & 3;
+    return &_inst._snapshots[_inst._snapshotFront];
+}
+
+void State::invalidateSnapshot()
+{
+    _inst._snapshotValid.store(false, std::memory_order_release);
+}
@@ -8,14 +8,13 @@
 #include "index/switch.h"
 #include "index/text.h"
 #include "index/timer.h"
+#include "state_container.h"
 
 #include <array>
+#include <atomic>
 #include <mutex>
-#include <shared_mutex>
 #include <string>
 #include <string_view>
-#include <type_traits>
-#include <utility>
 
 // Global state value manager
 class State
@@ -24,75 +23,8 @@ private:
     static State _inst;
 
 protected:
-    template <class Key, class Value, size_t _size> class StateContainer
-    {
-    public:
-        using KeyType = Key;
-        using ValType = Value;
-
-    public:
-        StateContainer() : _data{{}}, _dataDefault{{}} { static_assert(_size > 0); }
-        StateContainer(Value defVal) : StateContainer()
-        {
-            _data.fill(defVal);
-            _dataDefault.fill(defVal);
-        }
-
-    private:
-        std::array<Value, _size> _data;
-        std::array<Value, _size> _dataDefault;
-        mutable std::shared_mutex _mutex;
-
-    public:
-        Value get(Key n) const
-        {
-            size_t idx = (size_t)n;
-            if (idx < _size)
-            {
-                std::shared_lock l{_mutex};
-                return _data.data()[idx];
-            }
-            return {};
-        }
-
-        bool set(Key n, const Value& value)
-        {
-            size_t idx = static_cast<size_t>(n);
-            if (idx < _size)
-            {
-                std::unique_lock l{_mutex};
-                _data[idx] = value;
-                return true;
-            }
-            return false;
-        }
-
-        template <typename = typename std::enable_if<std::is_same_v<Value, std::string>>>
-        bool set(Key n, std::string_view value)
-        {
-            size_t idx = (size_t)n;
-            if (idx < _size)
-            {
-                std::unique_lock l{_mutex};
-                _data[idx] = value;
-                return true;
-            }
-            return false;
-        }
-
-        bool setDefault(Key n, Value value)
-        {
-            size_t idx = (size_t)n;
-            if (idx < _size)
-            {
-                _dataDefault[idx] = std::move(value);
-                return true;
-            }
-            return false;
-        }
-
-        void reset() { _data = _dataDefault; }
-    };
+    template <class Key, class Value, size_t _size>
+    using StateContainer = lunaticvibes::StateContainer<Key, Value, _size>;
     StateContainer<IndexBargraph, Ratio, (size_t)IndexBargraph::BARGRAPH_COUNT> gBargraphs;
     StateContainer<IndexNumber, int, (size_t)IndexNumber::NUMBER_COUNT> gNumbers;
     StateContainer<IndexOption, unsigned, (size_t)IndexOption::OPTION_COUNT> gOptions;
@@ -101,9 +33,58 @@ protected:
     StateContainer<IndexText, std::string, (size_t)IndexText::TEXT_COUNT> gTexts;
     StateContainer<IndexTimer, long long, (size_t)IndexTimer::TIMER_COUNT> gTimers{TIMER_NEVER};
 
+public:
+    // One copy of every scalar value, taken by the scene update loop after each tick. The render thread reads from it
+    // so a frame never mixes values from different ticks, e.g. a combo number and the judge timer that goes with it.
+    // Texts are not included.
+    struct Snapshot
+    {
+        decltype(gBargraphs)::Values bargraphs;
+        decltype(gNumbers)::Values numbers;
+        decltype(gOptions)::Values options;
+        decltype(gSliders)::Values sliders;
+        decltype(gSwitches)::Values switches;
+        decltype(gTimers)::Values timers;
+    };
+
+private:
+    // Triple buffer: the producer fills _snapshotBack, then swaps it with the shared slot. The consumer swaps its
+    // front buffer with the shared slot when that holds a newer snapshot. Neither side ever waits for the other.
+    static constexpr unsigned SNAPSHOT_FRESH = 4;
+    std::array<Snapshot, 3> _snapshots;
+    std::atomic<unsigned> _snapshotShared{1};
+    unsigned _snapshotBack = 0;
+    unsigned _snapshotFront = 2;
+    std::atomic<bool> _snapshotValid{false};
+    std::mutex _snapshotPublishMutex; // only one update loop is meant to publish, this guards the customize overlap
+    static thread_local const Snapshot* _readSnapshot;
+
 private:
     State();
 
+public:
+    // Called by the update loop after each tick.
+    static void publishSnapshot();
+    // Latest published snapshot, main thread only. It stays valid until the next call. nullptr if nothing has been
+    // published since invalidateSnapshot().
+    static const Snapshot* acquireSnapshot();
+    // Drop the snapshot of a stopped update loop, e.g. when scenes are switched.
+    static void invalidateSnapshot();
+
+    // While in scope, get() on this thread reads scalars from the snapshot instead of the live values. Writes always
+    // go to the live values. Passing nullptr reads live values.
+    class SnapshotScope
+    {
+        const Snapshot* _prev;
+
+    public:
+        explicit SnapshotScope(const Snapshot* snapshot) : _prev(_readSnapshot) { _readSnapshot = snapshot; }
+        ~SnapshotScope() { _readSnapshot = _prev; }
+        SnapshotScope(const SnapshotScope&) = delete;
+        SnapshotScope& operator=(const SnapshotScope&) = delete;
+    };
+    static const Snapshot* currentSnapshot() { return _readSnapshot; }
+
 public:
     static bool set(IndexBargraph ind, Ratio val);
     static double get(IndexBargraph ind);
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace lunaticvibes
+{
+
+// Fixed-size value table indexed by an enum. Reads never take a lock, as they happen hundreds of times per frame from
+// the render thread and the input/update loops at the same time.
+// Scalars are stored in atomics; every value is independent, there is no ordering between two different indices.
+template <class Key, class Value, size_t _size> class StateContainer
+{
+    static_assert(_size > 0);
+    static_assert(std::atomic<Value>::is_always_lock_free);
+
+public:
+    using KeyType = Key;
+    using ValType = Value;
+    using Values = std::array<Value, _size>;
+
+public:
+    StateContainer() = default;
+    StateContainer(Value defVal)
+    {
+        _dataDefault.fill(defVal);
+        reset();
+    }
+
+private:
+    std::array<std::atomic<Value>, _size> _data{};
+    Values _dataDefault{};
+
+public:
+    Value get(Key n) const
+    {
+        size_t idx = (size_t)n;
+        if (idx < _size)
+            return _data[idx].load(std::memory_order_acquire);
+        return {};
+    }
+
+    // Same bounds handling as get(), for values copied out with copyTo().
+    static Value get(const Values& values, Key n)
+    {
+        size_t idx = (size_t)n;
+        if (idx < _size)
+            return values[idx];
+        return {};
+    }
+
+    void copyTo(Values& out) const
+    {
+        for (size_t i = 0; i < _size; ++i)
+            out[i] = _data[i].load(std::memory_order_acquire);
+    }
+
+    bool set(Key n, const Value& value)
+    {
+        size_t idx = static_cast<size_t>(n);
+        if (idx < _size)
+        {
+            _data[idx].store(value, std::memory_order_release);
+            return true;
+        }
+        return false;
+    }
+
+    bool setDefault(Key n, Value value)
+    {
+        size_t idx = (size_t)n;
+        if (idx < _size)
+        {
+            _dataDefault[idx] = value;
+            return true;
+        }
+        return false;
+    }
+
+    void reset()
+    {
+        for (size_t i = 0; i < _size; ++i)
+            _data[i].store(_dataDefault[i], std::memory_order_release);
+    }
+};
+
+// Texts are published RCU style: a write swaps in a new immutable string, a reader copies out of whichever string it
+// picked up. Old strings are freed by the last reader still holding them.
+template <class Key, size_t _size> class StateContainer<Key, std::string, _size>
+{
+    static_assert(_size > 0);
+    using Ptr = std::shared_ptr<const std::string>;
+
+public:
+    using KeyType = Key;
+    using ValType = std::string;
+
+public:
+    StateContainer() = default;
+
+private:
+    std::array<std::atomic<Ptr>, _size> _data{};
+    std::array<Ptr, _size> _dataDefault{};
+
+public:
+    std::string get(Key n) const
+    {
+        size_t idx = (size_t)n;
+        if (idx < _size)
+        {
+            if (const Ptr p = _data[idx].load(std::memory_order_acquire))
+                return *p;
+        }
+        return {};
+    }
+
+    bool set(Key n, std::string_view value)
+    {
+        size_t idx = (size_t)n;
+        if (idx < _size)
+        {
+            _data[idx].store(std::make_shared<const std::string>(value), std::memory_order_release);
+            return true;
+        }
+        return false;
+    }
+
+    bool setDefault(Key n, std::string_view value)
+    {
+        size_t idx = (size_t)n;
+        if (idx < _size)
+        {
+            _dataDefault[idx] = std::make_shared<const std::string>(value);
+            return true;
+        }
+        return false;
+    }
+
+    // Defaults are immutable as well, so they are shared instead of copied.
+    void reset()
+    {
+        for (size_t i = 0; i < _size; ++i)
+            _data[i].store(_dataDefault[i], std::memory_order_release);
+    }
+};
+
+} // namespace lunaticvibes
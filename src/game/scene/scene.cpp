@@ -27,6 +27,9 @@ SceneBase::SceneBase(const std::shared_ptr<SkinMgr>& skinMgr, SkinType skinType,
     : AsyncLooper("UpdateLoop", std::bind_front(&SceneBase::_updateAsync1, this), rate), _type(SceneType::NOT_INIT),
       _input(ConfigMgr::get('P', cfg::P_INPUT_POLLING_RATE, 1000), backgroundInput)
 {
+    // Whatever the previous update loop published is stale now. Read live values until this scene's loop runs.
+    State::invalidateSnapshot();
+
     // Disable skin caching for now. dst options are changing all the time
     const bool simple_skin = gInCustomize && skinType != SkinType::THEME_SELECT;
     if (skinMgr)
@@ -144,10 +147,17 @@ void SceneBase::update()
     lunaticvibes::Time t;
     gUpdateContext.updateTime = t;
 
+    _frameSnapshot = State::acquireSnapshot();
+
     if (pSkin)
     {
         // update skin
-        pSkin->update();
+        {
+            // Skin reads come from one tick of the update loop, draw() reuses the same snapshot. Only the skin reads
+            // from it, the code below writes State on this thread and expects to read those values back.
+            State::SnapshotScope snapshotScope(_frameSnapshot);
+            pSkin->update();
+        }
         auto [x, y] = _input.getCursorPos();
         pSkin->update_mouse(x, y);
 
@@ -243,6 +253,8 @@ bool SceneBase::showFPS = false;
 
 void SceneBase::draw() const
 {
+    State::SnapshotScope snapshotScope(_frameSnapshot);
+
     if (pSkin)
     {
         pSkin->draw();
@@ -304,7 +316,10 @@ void SceneBase::_updateAsync1()
     }
 
     if ((!gInCustomize && _type != SceneType::CUSTOMIZE) || (gInCustomize && _type == SceneType::CUSTOMIZE))
+    {
+        State::publishSnapshot();
         gFrameCount[FRAMECOUNT_IDX_SCENE]++;
+    }
 }
 
 static bool should_show_text_overlay()
@@ -339,6 +354,7 @@ void SceneBase::updateImgui()
                 ImGui::PushID("##fps");
                 ImGui::Text("FPS: Render %d | Input %d | Update %d", State::get(IndexNumber::FPS),
                             State::get(IndexNumber::INPUT_DETECT_FPS), State::get(IndexNumber::SCENE_UPDATE_FPS));
+                ImGui::Text("Draw calls: %u", lunaticvibes::graphics::get_draw_call_count());
                 ImGui::PopID();
             }
 
@@ -383,6 +399,8 @@ void SceneBase::updateImgui()
             imguiMonitorBargraph();
         if (imguiShowMonitorTimer)
             imguiMonitorTimer();
+        if (imguiShowMonitorTextureCache)
+            imguiMonitorTextureCache();
     }
 }
 
@@ -425,6 +443,10 @@ void SceneBase::DebugToggle(InputMask& p, const lunaticvibes::Time& t)
     {
         imguiShowMonitorTimer = !imguiShowMonitorTimer;
     }
+    if (p[Input::F10])
+    {
+        imguiShowMonitorTextureCache = !imguiShowMonitorTextureCache;
+    }
 }
 
 bool SceneBase::isInTextEdit() const
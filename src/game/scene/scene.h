@@ -2,6 +2,7 @@
 
 #include <common/types.h>
 #include <game/input/input_wrapper.h>
+#include <game/runtime/state.h>
 #include <game/skin/skin.h>
 #include <game/skin/skin_mgr.h>
 
@@ -84,6 +85,9 @@ protected:
 
     static bool showFPS;
 
+    // Acquired in update(), main thread only.
+    const State::Snapshot* _frameSnapshot = nullptr;
+
 public:
     SceneBase() = delete;
     SceneBase(const std::shared_ptr<SkinMgr>& skinMgr, SkinType skinType, unsigned rate = 240,
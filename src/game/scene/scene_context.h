@@ -9,6 +9,7 @@
 #include "game/ruleset/ruleset.h"
 #include "scene.h"
 #include <array>
+#include <list>
 #include <memory>
 #include <shared_mutex>
 #include <string>
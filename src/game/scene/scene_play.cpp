@@ -1,12 +1,15 @@
 #include "scene_play.h"
 
 #include <array>
+#include <deque>
 #include <functional>
 #include <future>
+#include <latch>
 #include <random>
 
 #include <common/assert.h>
 #include <common/chartformat/chartformat_bms.h>
+#include <common/dir_index.h>
 #include <common/log.h>
 #include <common/sysutil.h>
 #include <config/config_mgr.h>
@@ -1189,6 +1192,9 @@ void ScenePlay::loadChart()
                 return;
             }
 
+            // resolve every sample against a single listing of the chart folder instead of probing each file
+            lunaticvibes::DirectoryIndex chartDirIndex(chartDir);
+
             const auto thread_count = std::thread::hardware_concurrency();
             boost::asio::thread_pool pool(thread_count > 2 ? thread_count : 1);
             for (size_t i = 0; i < _pChart->wavFiles.size(); ++i)
@@ -1200,22 +1206,21 @@ void ScenePlay::loadChart()
                 if (wav.empty())
                     continue;
 
-                boost::asio::post(pool, [&, i]() {
+                Path p;
+                if (Path pWav = PathFromUTF8(wav); pWav.is_absolute())
+                {
+                    LOG_WARNING << "[Play] Absolute path to sample, this is forbidden";
+                }
+                else if (p = chartDirIndex.resolve(wav, NOTE_SAMPLE_FALLBACK_EXTENSIONS); p.empty())
+                {
+                    p = chartDir / pWav; // missing, let the driver report it
+                }
+
+                boost::asio::post(pool, [&, i, p = std::move(p)]() {
                     if (shouldDiscard(*this))
                         return;
-                    Path pWav = PathFromUTF8(wav);
-                    if (pWav.is_absolute())
-                    {
-                        LOG_WARNING << "[Play] Absolute path to sample, this is forbidden";
-                    }
-                    else
-                    {
-                        fs::path p{chartDir / pWav};
-#ifndef _WIN32
-                        p = lunaticvibes::resolve_windows_path(lunaticvibes::u8str(p));
-#endif // _WIN32
+                    if (!p.empty())
                         SoundMgr::loadNoteSample(p, i);
-                    }
                     ++wavLoaded;
                 });
             }
@@ -1227,7 +1232,10 @@ void ScenePlay::loadChart()
                 return;
             }
 
-            LOG_DEBUG << "[Play] Samples loaded";
+            const auto cacheStats = SoundMgr::getNoteSampleCacheStats();
+            LOG_DEBUG << "[Play] Samples loaded (cache: " << cacheStats.hits << " hits, " << cacheStats.misses
+                      << " misses, " << cacheStats.evictions << " evictions, " << cacheStats.bytesResident / 1024 / 1024
+                      << "/" << cacheStats.bytesBudget / 1024 / 1024 << " MiB resident)";
             gChartContext.isSampleLoaded = true;
             gChartContext.sampleLoadedHash = gChartContext.hash;
         });
@@ -1264,33 +1272,71 @@ void ScenePlay::loadChart()
                     return;
                 }
 
+                // BMS commonly refers to .bmp files that were converted to .jpg or .png afterwards
+                static constexpr std::string_view bmpFallbackExtensions[]{".jpg", ".png"};
+                lunaticvibes::DirectoryIndex chartDirIndex(chartDir);
+                std::vector<std::pair<size_t, Path>> files;
                 for (size_t i = 0; i < _pChart->bgaFiles.size(); ++i)
                 {
-                    if (shouldDiscard(*this))
-                        break;
                     const auto& bmp = _pChart->bgaFiles[i];
                     if (bmp.empty())
                         continue;
+                    const auto pBmp = PathFromUTF8(bmp);
+                    if (pBmp.is_absolute())
                     {
-                        if (shouldDiscard(*this))
-                            break;
-                        const auto pBmp = PathFromUTF8(bmp);
-                        if (pBmp.is_absolute())
-                        {
-                            LOG_WARNING << "[Play] Absolute path to BGA picture, this is forbidden";
-                        }
-                        else
-                        {
-                            fs::path p{chartDir / pBmp};
-#ifndef _WIN32
-                            p = lunaticvibes::resolve_windows_path(lunaticvibes::u8str(p));
-#endif // _WIN32
-                            gPlayContext.bgaTexture->addBmp(i, p);
-                        }
-                        ++bmpLoaded;
+                        LOG_WARNING << "[Play] Absolute path to BGA picture, this is forbidden";
+                        files.emplace_back(INDEX_INVALID, Path());
+                        continue;
                     }
+                    const bool isBmp = lunaticvibes::iequals(lunaticvibes::s(pBmp.extension().u8string()), ".bmp");
+                    Path p = chartDirIndex.resolve(
+                        bmp, isBmp ? std::span{bmpFallbackExtensions} : std::span<const std::string_view>{});
+                    files.emplace_back(i, p.empty() ? chartDir / pBmp : p);
                 }
 
+                // What is shown first is loaded first. Once the texture budget is full the rest is streamed in
+                // during play.
+                auto& bga = *gPlayContext.bgaTexture;
+                bga.setTextureBudget(
+                    size_t(std::max(0, ConfigMgr::get('V', cfg::V_BGA_TEXTURE_BUDGET_MB, 512))) * 1024 * 1024);
+                bga.setSlotFromBMS(
+                    *std::reinterpret_pointer_cast<ChartObjectBMS>(gPlayContext.chartObj[PLAYER_SLOT_PLAYER]));
+                std::stable_sort(files.begin(), files.end(), [&bga](const auto& l, const auto& r) {
+                    return bga.getFirstUse(l.first) < bga.getFirstUse(r.first);
+                });
+
+                // Decode on a pool, then upload every batch with one trip to the main thread while the rest is
+                // still decoding.
+                static constexpr size_t BATCH_SIZE = 64;
+                std::vector<TextureBmsBga::DecodedBmp> decoded(files.size());
+                std::deque<std::latch> batchDone;
+                for (size_t first = 0; first < files.size(); first += BATCH_SIZE)
+                    batchDone.emplace_back(static_cast<std::ptrdiff_t>(std::min(BATCH_SIZE, files.size() - first)));
+
+                const auto thread_count = std::thread::hardware_concurrency();
+                boost::asio::thread_pool pool(thread_count > 2 ? thread_count - 1 : 1);
+                for (size_t k = 0; k < files.size(); ++k)
+                {
+                    boost::asio::post(pool, [&, k]() {
+                        if (!shouldDiscard(*this))
+                            decoded[k] = bga.decodeBmp(files[k].first, files[k].second);
+                        batchDone[k / BATCH_SIZE].count_down();
+                    });
+                }
+                for (size_t b = 0; b < batchDone.size(); ++b)
+                {
+                    batchDone[b].wait();
+                    if (shouldDiscard(*this))
+                        continue;
+                    const size_t first = b * BATCH_SIZE;
+                    const size_t last = std::min(first + BATCH_SIZE, files.size());
+                    std::vector<TextureBmsBga::DecodedBmp> batch(std::make_move_iterator(decoded.begin() + first),
+                                                                 std::make_move_iterator(decoded.begin() + last));
+                    bga.addDecoded(batch);
+                    bmpLoaded += static_cast<unsigned>(last - first);
+                }
+                pool.wait();
+
                 if (shouldDiscard(*this))
                 {
                     LOG_DEBUG << "[Play] State changed, discarding BGA";
@@ -1298,12 +1344,7 @@ void ScenePlay::loadChart()
                 }
 
                 LOG_DEBUG << "[Play] BGA loaded";
-                if (bmpLoaded > 0)
-                {
-                    gPlayContext.bgaTexture->setLoaded();
-                }
-                gPlayContext.bgaTexture->setSlotFromBMS(
-                    *std::reinterpret_pointer_cast<ChartObjectBMS>(gPlayContext.chartObj[PLAYER_SLOT_PLAYER]));
+                bga.setLoaded();
                 gChartContext.isBgaLoaded = true;
                 gChartContext.bgaLoadedHash = gChartContext.hash;
             });
@@ -1312,6 +1353,8 @@ void ScenePlay::loadChart()
         {
             // set playback speed on each play
             gPlayContext.bgaTexture->setVideoSpeed();
+            // streaming was stopped with the previous play
+            gPlayContext.bgaTexture->setLoaded();
         }
     }
 
@@ -46,6 +46,7 @@ ScenePreSelect::ScenePreSelect() : SceneBase(nullptr, SkinType::PRE_SELECT, 240)
         if (!fs::exists(dbPath))
             fs::create_directories(dbPath);
         g_pSongDB = std::make_shared<SongDB>(dbPath / "song.db");
+        g_pSongDB->setThreadCount(ConfigMgr::get('E', cfg::E_SCAN_THREADS, 0));
 
         std::unique_lock l(gSelectContext._mutex);
         gSelectContext.entries.clear();
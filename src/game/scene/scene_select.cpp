@@ -10,6 +10,7 @@
 
 #include <common/assert.h>
 #include <common/chartformat/chartformat_types.h>
+#include <common/dir_index.h>
 #include <common/entry/entry.h>
 #include <common/entry/entry_random_song.h>
 #include <common/entry/entry_song.h>
@@ -953,6 +954,7 @@ void SceneSelect::_updateAsync()
     if (!gInCustomize && (t - navigateTimestamp).norm() > 500)
     {
         updatePreview();
+        updateSkinPreload();
     }
 }
 
@@ -2233,6 +2235,9 @@ void SceneSelect::decide()
         default: break;
         }
 
+        // usually done already while hovering the chart, otherwise at least overlap with SceneDecide
+        _skinMgr->preload(gPlayContext.mode);
+
         break;
     }
     case eEntryType::COURSE: {
@@ -3291,6 +3296,43 @@ bool tryLoadDedicatedPreview(ChartFormatBMS& bms)
     return false;
 }
 
+// Build the play skin of the hovered chart in the background, so starting it does not have to parse the skin.
+void SceneSelect::updateSkinPreload()
+{
+    if (gPlayContext.isBattle)
+        return;
+
+    unsigned keys = 0;
+    {
+        std::shared_lock l{gSelectContext._mutex};
+        if (gSelectContext.entries.empty())
+            return;
+        const auto& entry = gSelectContext.entries[gSelectContext.selectedEntryIndex].first;
+        if (entry == nullptr || (entry->type() != eEntryType::CHART && entry->type() != eEntryType::RIVAL_CHART))
+            return;
+        const auto chart = std::reinterpret_pointer_cast<EntryChart>(entry)->_file;
+        if (chart == nullptr || chart->type() != eChartFormat::BMS)
+            return;
+        keys = std::reinterpret_pointer_cast<ChartFormatBMSMeta>(chart)->gamemode;
+    }
+
+    SkinType type;
+    switch (keys)
+    {
+    case 5:
+    case 7:
+    case 9:
+    case 10:
+    case 14: type = lunaticvibes::skinTypeForKeys(keys); break;
+    default: return;
+    }
+    if (type == _skinPreloadType)
+        return;
+
+    _skinPreloadType = type;
+    _skinMgr->preload(type);
+}
+
 void SceneSelect::updatePreview()
 {
     const EntryList& e = gSelectContext.entries;
@@ -3419,6 +3461,7 @@ void SceneSelect::updatePreview()
                         return false;
                     };
 
+                    lunaticvibes::DirectoryIndex chartDirIndex(chartDir);
                     boost::asio::thread_pool pool(std::max(1u, std::thread::hardware_concurrency() - 2));
                     for (size_t i = 0; i < bms->wavFiles.size(); ++i)
                     {
@@ -3426,19 +3469,19 @@ void SceneSelect::updatePreview()
                         if (wav.empty())
                             continue;
 
-                        boost::asio::post(pool, [&, i]() {
+                        Path pWav = PathFromUTF8(wav);
+                        if (pWav.is_absolute())
+                        {
+                            LOG_WARNING << "[Select] Absolute path to sample, this is forbidden";
+                            continue;
+                        }
+                        Path p = chartDirIndex.resolve(wav, NOTE_SAMPLE_FALLBACK_EXTENSIONS);
+                        if (p.empty())
+                            p = chartDir / pWav;
+
+                        boost::asio::post(pool, [&, i, p = std::move(p)]() {
                             if (shouldDiscard(*this, bms))
                                 return;
-                            Path pWav = PathFromUTF8(wav);
-                            if (pWav.is_absolute())
-                            {
-                                LOG_WARNING << "[Select] Absolute path to sample, this is forbidden";
-                                return;
-                            }
-                            fs::path p{chartDir / pWav};
-#ifndef _WIN32
-                            p = lunaticvibes::resolve_windows_path(lunaticvibes::u8str(p));
-#endif // _WIN32
                             SoundMgr::loadNoteSample(p, i);
                         });
                     }
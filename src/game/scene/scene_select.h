@@ -74,6 +74,7 @@ private:
     // virtual Customize scene, customize option toggle in select scene support
     std::shared_ptr<SceneCustomize> _virtualSceneCustomize;
     std::shared_ptr<SkinMgr> _skinMgr;
+    SkinType _skinPreloadType = SkinType::MODE_COUNT;
 
     // smooth scrolling
     lunaticvibes::Time scrollButtonTimestamp;
@@ -157,6 +158,7 @@ protected:
 protected:
     void updatePreview();
     void postStartPreview();
+    void updateSkinPreload();
 
     /// //////////////////////////////////////////////////////
 protected:
@@ -1099,7 +1099,7 @@ void SceneSelect::imguiPageDebugMain()
 
     ImGui::Checkbox("Enable skin debug monitors", &lunaticvibes::g_enable_imgui_debug_monitor);
     ImGui::SameLine();
-    HelpMarker("F1-F8");
+    HelpMarker("F1-F8, F10");
 
     ImGui::BeginDisabled(!lunaticvibes::g_enable_imgui_debug_monitor);
     ImGui::Checkbox("imguiShowMonitorLR2DST", &imguiShowMonitorLR2DST);
@@ -1110,6 +1110,7 @@ void SceneSelect::imguiPageDebugMain()
     ImGui::Checkbox("imguiShowMonitorText", &imguiShowMonitorText);
     ImGui::Checkbox("imguiShowMonitorBargraph", &imguiShowMonitorBargraph);
     ImGui::Checkbox("imguiShowMonitorTimer", &imguiShowMonitorTimer);
+    ImGui::Checkbox("imguiShowMonitorTextureCache", &imguiShowMonitorTextureCache);
     ImGui::EndDisabled();
 
     ImGui::Checkbox("Show clicked sprite", &lunaticvibes::g_enable_show_clicked_sprite);
@@ -12,7 +12,6 @@
 
 // FIXME: get rid of preDefinedTextures.
 std::map<std::string, std::shared_ptr<Texture>> SkinBase::preDefinedTextures;
-std::map<std::string, std::shared_ptr<Texture>> SkinBase::textureNameMap;
 
 SkinBase::SkinBase()
 {
@@ -52,8 +51,31 @@ void SkinBase::update()
         State::set(IndexNumber::_TEST3, (int)(gUpdateContext.metre * 1000));
     }
 
+    // Sprites sharing a start timer get it read once.
+    if (_spritesByMotionTimer.size() != _sprites.size())
+    {
+        _spritesByMotionTimer.clear();
+        for (const auto& s : _sprites)
+            _spritesByMotionTimer.push_back(s.get());
+        std::stable_sort(_spritesByMotionTimer.begin(), _spritesByMotionTimer.end(),
+                         [](const SpriteBase* a, const SpriteBase* b) {
+                             return a->getMotionStartTimer() < b->getMotionStartTimer();
+                         });
+    }
+    for (size_t i = 0; i < _spritesByMotionTimer.size();)
+    {
+        const IndexTimer timer = _spritesByMotionTimer[i]->getMotionStartTimer();
+        const long long startTime = State::get(timer);
+        for (; i < _spritesByMotionTimer.size() && _spritesByMotionTimer[i]->getMotionStartTimer() == timer; ++i)
+            _spritesByMotionTimer[i]->setMotionStartTime(startTime);
+    }
+
+    // Worker threads read from the same snapshot as the calling thread.
     std::for_each(std::execution::par, _sprites.begin(), _sprites.end(),
-                  [](const std::shared_ptr<SpriteBase>& s) { s->update(gUpdateContext.updateTime); });
+                  [snapshot = State::currentSnapshot()](const std::shared_ptr<SpriteBase>& s) {
+                      State::SnapshotScope snapshotScope(snapshot);
+                      s->update(gUpdateContext.updateTime);
+                  });
     std::for_each(_sprites.begin(), _sprites.end(),
                   [](const std::shared_ptr<SpriteBase>& s) { s->update_on_main(gUpdateContext.updateTime); });
 }
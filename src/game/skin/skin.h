@@ -37,6 +37,9 @@ protected:
 public:
     constexpr bool isLoaded() { return loaded; }
     virtual void setGaugeDisplayType(unsigned slot, GaugeDisplayType type) {};
+    // For skins built ahead of time in the background: make the skin current. Returns false if the state it was built
+    // against has changed since, the skin must be rebuilt then.
+    virtual bool activate() { return true; }
 
     ////////////////////////////////////////////////////////////////////////////////
     // Images
@@ -46,8 +49,8 @@ protected:
     ////////////////////////////////////////////////////////////////////////////////
     // Textures
 protected:
-    static std::map<std::string, std::shared_ptr<Texture>> textureNameMap; // Use this to get texture instance from name
-    std::map<std::string, std::shared_ptr<sVideo>> videoNameMap;           // Use this to get video instance from name
+    std::map<std::string, std::shared_ptr<Texture>> textureNameMap; // Use this to get texture instance from name
+    std::map<std::string, std::shared_ptr<sVideo>> videoNameMap;    // Use this to get video instance from name
 
     ////////////////////////////////////////////////////////////////////////////////
     // Sprite elements
@@ -55,6 +58,9 @@ protected:
     std::vector<std::shared_ptr<SpriteBase>> _sprites;      // Only modified while parsing the skin.
     std::vector<std::shared_ptr<SpriteBase>> _mouseSprites; // Portion of '_sprites' which are also iSpriteMouse.
 
+private:
+    std::vector<SpriteBase*> _spritesByMotionTimer; // '_sprites' ordered by start timer, built on first update()
+
     // functional support
 protected:
     bool handleMouseEvents = true;
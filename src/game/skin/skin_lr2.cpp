@@ -1,5 +1,6 @@
 #include "skin_lr2.h"
 
+#include <atomic>
 #include <cstdint>
 #include <execution>
 #include <fstream>
@@ -13,10 +14,12 @@
 #include <re2/re2.h>
 
 #include "common/log.h"
+#include "common/sysutil.h"
 #include "common/u8.h"
 #include "common/utils.h"
 #include "config/config_mgr.h"
 #include "game/graphics/dxa.h"
+#include "game/graphics/texture_cache.h"
 #include "game/graphics/video.h"
 #include "game/runtime/i18n.h"
 #include "game/runtime/state.h"
@@ -79,8 +82,8 @@ size_t convertOpsToInt(const Tokens& tokens, int* pData, size_t offset, size_t s
     return i;
 }
 
-static bool flipSideFlag = false;
-static bool flipResultFlag = false; // Set in play skin
+static std::atomic<bool> flipSideFlag = false;
+static std::atomic<bool> flipResultFlag = false; // Set by the play skin shown
 static bool flipSide = false;
 
 static int flipTimer(int timer)
@@ -472,6 +475,9 @@ BlendMode convertBlend(int blend)
 std::map<std::string, Path> SkinLR2::LR2SkinFontPathCache;
 std::map<Path, std::shared_ptr<SkinLR2::LR2Font>> SkinLR2::LR2FontCache;
 
+std::mutex SkinLR2::shownTextureNameMapMutex;
+std::map<std::string, std::shared_ptr<Texture>> SkinLR2::shownTextureNameMap;
+
 std::map<std::string, std::shared_ptr<SkinLR2::LR2Font>> SkinLR2::prevSkinLR2FontNameMap;
 std::map<std::string, std::shared_ptr<SkinLR2::LR2Font>> SkinLR2::LR2FontNameMap;
 
@@ -737,6 +743,17 @@ int SkinLR2::HELPFILE()
     return 1;
 }
 
+// Large images, e.g. backgrounds, stay standalone textures.
+std::shared_ptr<Texture> SkinLR2::loadImageTexture(const Path& path, std::optional<Color> transparentColor)
+{
+    Image img{path};
+    if (!img.hasAlphaLayer() && transparentColor)
+        img.setTransparentColorRGB(*transparentColor);
+    if (auto region = textureAtlas.add(img))
+        return region;
+    return std::make_shared<Texture>(img);
+}
+
 int SkinLR2::IMAGE()
 {
     if (!matchToken(parseKeyBuf, "#IMAGE"))
@@ -768,10 +785,9 @@ int SkinLR2::IMAGE()
         }
         else
         {
-            Image img{pathFile};
-            if (!img.hasAlphaLayer() && info.hasTransparentColor)
-                img.setTransparentColorRGB(info.transparentColor);
-            textureNameMap[textureMapKey] = std::make_shared<Texture>(img);
+            textureNameMap[textureMapKey] = lunaticvibes::graphics::TextureCache::shared().get(
+                pathFile, info.hasTransparentColor ? std::optional{info.transparentColor} : std::nullopt,
+                std::bind_front(&SkinLR2::loadImageTexture, this));
         }
 
         LOG_DEBUG << "[Skin] " << csvLineNumber << ": Added IMAGE[" << imageCount << "]: " << pathFile;
@@ -877,7 +893,8 @@ int SkinLR2::LR2FONT()
                 // スキンcsvとは違って「lr2fontファイルからの相対参照」で画像ファイルを指定します。
                 Path p = path.parent_path() / PathFromUTF8(tokens[2]);
                 findAndExtractDXA(p);
-                pf->T_texture.push_back(std::make_shared<Texture>(Image{p}));
+                pf->T_texture.push_back(lunaticvibes::graphics::TextureCache::shared().get(
+                    p, std::nullopt, std::bind_front(&SkinLR2::loadImageTexture, this)));
             }
             else if (matchToken(key, "#R"))
             {
@@ -1103,14 +1120,14 @@ int SkinLR2::others()
     }
     if (matchToken(parseKeyBuf, "#FLIPRESULT"))
     {
-        lr2skin::flipResultFlag = true;
+        // lr2skin::flipResultFlag is set by publish()
+        flipResult = true;
 
         switch (info.mode)
         {
         case SkinType::RESULT:
         case SkinType::COURSE_RESULT:
-            lr2skin::flipSide = (lr2skin::flipSideFlag || lr2skin::flipResultFlag) && !disableFlipResult;
-            State::set(IndexSwitch::FLIP_RESULT, lr2skin::flipSide);
+            lr2skin::flipSide = (lr2skin::flipSideFlag || lr2skin::flipResultFlag || flipResult) && !disableFlipResult;
             break;
         default: break;
         }
@@ -1125,8 +1142,7 @@ int SkinLR2::others()
         {
         case SkinType::RESULT:
         case SkinType::COURSE_RESULT:
-            lr2skin::flipSide = (lr2skin::flipSideFlag || lr2skin::flipResultFlag) && !disableFlipResult;
-            State::set(IndexSwitch::FLIP_RESULT, lr2skin::flipSide);
+            lr2skin::flipSide = (lr2skin::flipSideFlag || lr2skin::flipResultFlag || flipResult) && !disableFlipResult;
             break;
         default: break;
         }
@@ -3436,6 +3452,7 @@ int SkinLR2::parseHeader(const Tokens& raw)
             break;
         default: LOG_WARNING << "[SkinLR2] Invalid #RESOLUTION value '" << parseParamBuf[0] << "' ignored"; break;
         }
+        return 4;
     }
     else if (matchToken(parseKeyBuf, "#ENDOFHEADER"))
     {
@@ -3459,6 +3476,10 @@ int SkinLR2::parseBody(const Tokens& raw)
         parseParamBuf[idx] = lunaticvibes::trim(raw[idx + 1]);
     }
 
+    // included lines are recorded by the nested loadCSV()
+    if (csvCacheRecord && !matchToken(parseKeyBuf, "#INCLUDE"))
+        csvCacheRecord->lines.push_back({lunaticvibes::SkinLR2CSVCache::BODY, csvLineNumber, raw});
+
     try
     {
         if (IMAGE())
@@ -3557,6 +3578,8 @@ void SkinLR2::IF(const Tokens& t, std::istream& lr2skin, eFileEncoding enc, bool
                 break;
             }
             bool dst = getDstOpt(res->first);
+            if (csvCacheRecord)
+                csvCacheRecord->addCondition(res->first, dst);
             if (res->second)
                 dst = !dst;
             ifStmtTrue = ifStmtTrue && dst;
@@ -3658,7 +3681,10 @@ SkinLR2::SkinLR2(std::shared_ptr<std::array<std::shared_ptr<SpriteBase>, SPRITE_
     _version = SkinVersion::LR2beta3;
 
     // load images from last skin
-    prevSkinTextureNameMap = textureNameMap;
+    {
+        std::unique_lock l(shownTextureNameMapMutex);
+        prevSkinTextureNameMap = shownTextureNameMap;
+    }
     textureNameMap = preDefinedTextures;
     prevSkinLR2FontNameMap = LR2FontNameMap;
     LR2FontNameMap.clear();
@@ -3689,6 +3715,9 @@ SkinLR2::SkinLR2(std::shared_ptr<std::array<std::shared_ptr<SpriteBase>, SPRITE_
 
     prevSkinTextureNameMap.clear();
     prevSkinLR2FontNameMap.clear();
+
+    if (IsMainThread())
+        publish();
 }
 
 SkinLR2::~SkinLR2()
@@ -3734,7 +3763,8 @@ SkinLR2::~SkinLR2()
 
 bool SkinLR2::loadCSV(Path p)
 {
-    if (filePath.empty())
+    const bool isRootFile = filePath.empty();
+    if (isRootFile)
         filePath = p;
 
     auto srcLineNumberParent = csvLineNumber;
@@ -3746,6 +3776,8 @@ bool SkinLR2::loadCSV(Path p)
     if (!ifsFile.is_open())
     {
         LOG_ERROR << "[Skin] File Not Found: " << p;
+        if (csvCacheRecord)
+            csvCacheRecord->addMissingFile(p);
         csvLineNumber = srcLineNumberParent;
         return false;
     }
@@ -3755,6 +3787,8 @@ bool SkinLR2::loadCSV(Path p)
     csvFile << ifsFile.rdbuf();
     csvFile.sync();
     ifsFile.close();
+    if (csvCacheRecord)
+        csvCacheRecord->addFile(p, csvFile.str());
 
     auto encoding = getFileEncoding(csvFile);
 
@@ -3771,12 +3805,18 @@ bool SkinLR2::loadCSV(Path p)
         if (tokens.empty())
             continue;
 
-        if (parseHeader(tokens) == -1)
+        const int headerRet = parseHeader(tokens);
+        if (headerRet == -1)
         {
             // #ENDOFHEADER
             haveEndOfHeader = true;
             break;
         }
+        if (headerRet != 0 && csvCacheRecord)
+        {
+            // header of an included file
+            csvCacheRecord->lines.push_back({lunaticvibes::SkinLR2CSVCache::HEADER, csvLineNumber, tokens});
+        }
     }
     LOG_DEBUG << "[Skin] File: " << p << "(Line " << csvLineNumber << "): Header loading finished";
 
@@ -3791,15 +3831,15 @@ bool SkinLR2::loadCSV(Path p)
     case SkinType::PLAY14: lr2skin::flipSide = false; break;
     case SkinType::RESULT:
     case SkinType::COURSE_RESULT:
-        lr2skin::flipSide = (lr2skin::flipSideFlag || lr2skin::flipResultFlag) && !disableFlipResult;
-        break;
-    default:
-        lr2skin::flipSide = false;
-        lr2skin::flipSideFlag = false;
-        lr2skin::flipResultFlag = false;
+        lr2skin::flipSide = (lr2skin::flipSideFlag || lr2skin::flipResultFlag || flipResult) && !disableFlipResult;
         break;
+    default: lr2skin::flipSide = false; break;
     }
-    State::set(IndexSwitch::FLIP_RESULT, lr2skin::flipSide);
+    flipResultSwitch = lr2skin::flipSide;
+    // #IF blocks of the body may test the switch. A skin built in the background leaves the skin on screen alone,
+    // activate() checks the blocks again.
+    if (IsMainThread())
+        State::set(IndexSwitch::FLIP_RESULT, flipResultSwitch);
 
     if (loadMode < 2)
     {
@@ -3885,17 +3925,20 @@ bool SkinLR2::loadCSV(Path p)
             {
                 LOG_WARNING << "[Skin] Bad customize config file: " << pCustomize;
             }
-            for (const auto& c : customize)
+            applyCustomDstOpt();
+        }
+
+        Path csvCachePath;
+        if (isRootFile)
+        {
+            csvCachePath = lunaticvibes::SkinLR2CSVCache::getCachePath(getCSVCacheKey(p));
+            if (loadCSVCache(csvCachePath))
             {
-                if (c.dst_op != 0)
-                {
-                    for (size_t i = 0; i < c.label.size(); ++i)
-                    {
-                        setCustomDstOpt(c.dst_op, i, false);
-                    }
-                    setCustomDstOpt(c.dst_op, c.value, true);
-                }
+                csvLineNumber = srcLineNumberParent;
+                return true;
             }
+            csvCacheRecord = std::make_unique<lunaticvibes::SkinLR2CSVCache>();
+            csvCacheRecord->addFile(p, csvFile.str());
         }
 
         // Add extra textures
@@ -3933,14 +3976,128 @@ bool SkinLR2::loadCSV(Path p)
                 parseBody(tokens);
             }
         }
+
+        if (isRootFile)
+        {
+            csvCacheRecord->save(csvCachePath);
+            ifConditions = std::move(csvCacheRecord->conditions);
+            csvCacheRecord.reset();
+        }
     }
 
     csvLineNumber = srcLineNumberParent;
     return true;
 }
 
+std::string SkinLR2::getCSVCacheKey(const Path& p) const
+{
+    std::stringstream ss;
+    ss << lunaticvibes::SkinLR2CSVCache::VERSION << '|' << lunaticvibes::u8str(p) << '|'
+       << ConfigMgr::get('E', cfg::E_LR2PATH, ".") << '|' << loadMode << '|' << info.resolution.first << 'x'
+       << info.resolution.second << '\n';
+    for (const auto& c : customize)
+        ss << c.title << '=' << c.value << '\n';
+    return ss.str();
+}
+
+bool SkinLR2::loadCSVCache(const Path& p)
+{
+    lunaticvibes::SkinLR2CSVCache cache;
+    if (!cache.load(p))
+        return false;
+
+    for (const auto& c : cache.conditions)
+    {
+        if (getDstOpt(c.op) != c.value)
+        {
+            LOG_DEBUG << "[Skin] Cache " << p << " was built with different #IF results, reparsing";
+            return false;
+        }
+    }
+    if (!cache.filesUnchanged())
+    {
+        LOG_DEBUG << "[Skin] Cache " << p << " is out of date, reparsing";
+        return false;
+    }
+
+    LOG_INFO << "[Skin] Loading body from cache: " << p;
+    for (const auto& line : cache.lines)
+    {
+        csvLineNumber = line.number;
+        if (line.type == lunaticvibes::SkinLR2CSVCache::HEADER)
+            parseHeader(line.tokens);
+        else
+            parseBody(line.tokens);
+    }
+    ifConditions = std::move(cache.conditions);
+    loadedFromCSVCache = true;
+    return true;
+}
+
+void SkinLR2::applyCustomDstOpt() const
+{
+    for (const auto& c : customize)
+    {
+        if (c.dst_op != 0)
+        {
+            for (size_t i = 0; i < c.label.size(); ++i)
+            {
+                setCustomDstOpt(c.dst_op, i, false);
+            }
+            setCustomDstOpt(c.dst_op, c.value, true);
+        }
+    }
+}
+
+void SkinLR2::publish() const
+{
+    switch (info.mode)
+    {
+    case SkinType::PLAY5:
+    case SkinType::PLAY5_2:
+    case SkinType::PLAY7:
+    case SkinType::PLAY7_2:
+    case SkinType::PLAY9:
+    case SkinType::PLAY10:
+    case SkinType::PLAY14:
+    case SkinType::RESULT:
+    case SkinType::COURSE_RESULT:
+        if (flipResult)
+            lr2skin::flipResultFlag = true;
+        break;
+    default:
+        lr2skin::flipSideFlag = false;
+        lr2skin::flipResultFlag = false;
+        break;
+    }
+    State::set(IndexSwitch::FLIP_RESULT, flipResultSwitch);
+
+    std::unique_lock l(shownTextureNameMapMutex);
+    shownTextureNameMap = textureNameMap;
+}
+
+bool SkinLR2::activate()
+{
+    publish();
+    updateDstOpt();
+    applyCustomDstOpt();
+    for (const auto& c : ifConditions)
+    {
+        if (getDstOpt(c.op) != c.value)
+        {
+            LOG_DEBUG << "[Skin] dst option " << c.op << " changed since " << filePath << " was built";
+            return false;
+        }
+    }
+    startSpriteVideoPlayback();
+    return true;
+}
+
 void SkinLR2::postLoad()
 {
+    for (auto& e : drawQueue)
+        e.dstCond = DstOptCondition::compile(e.dstOpt);
+
     // try to detect resolution
     if (info.resolution.first == -1 || info.resolution.second == -1)
     {
@@ -4388,10 +4545,22 @@ void SkinLR2::update()
     lunaticvibes::Time t;
 
     {
+        DstOptBits dstOptBits;
+        getDstOptBits(dstOptBits);
+        DstOptBits dstOptChanged;
+        for (size_t i = 0; i < dstOptBits.size(); ++i)
+            dstOptChanged[i] = dstOptBits[i] ^ dstOptBitsSeen[i];
+        dstOptBitsSeen = dstOptBits;
+
         const int ttAngle1P = State::get(IndexNumber::_ANGLE_TT_1P);
         const int ttAngle2P = State::get(IndexNumber::_ANGLE_TT_2P);
-        auto updateSprite = [ttAngle1P, ttAngle2P](element& e) {
-            e.ps->setHideExternal(std::any_of(e.dstOpt.begin(), e.dstOpt.end(), std::not_fn(&getDstOpt)));
+        auto updateSprite = [&dstOptBits, &dstOptChanged, ttAngle1P, ttAngle2P](element& e) {
+            if (!e.dstEvaluated || e.dstCond.affectedBy(dstOptChanged))
+            {
+                e.dstVisible = e.dstCond.eval(dstOptBits);
+                e.dstEvaluated = true;
+            }
+            e.ps->setHideExternal(!e.dstVisible);
 
             switch (e.op4)
             {
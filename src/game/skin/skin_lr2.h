@@ -4,7 +4,9 @@
 #include <cstdint>
 #include <filesystem>
 #include <functional>
+#include <list>
 #include <map>
+#include <mutex>
 #include <stack>
 #include <variant>
 
@@ -15,9 +17,11 @@
 #include "game/graphics/sprite_imagetext.h"
 #include "game/graphics/sprite_lane.h"
 #include "game/graphics/sprite_video.h"
+#include "game/graphics/texture_atlas.h"
 #include "game/input/input_mgr.h"
 #include "game/runtime/state.h"
 #include "skin.h"
+#include "skin_lr2_cache.h"
 
 namespace LR2SkinDef
 {
@@ -697,6 +701,34 @@ enum dst_option : int16_t
     DST_OPTION_COUNT
 };
 
+// All dst options as one flat bitset indexed by option number. Options beyond it are never set.
+constexpr size_t DST_OPT_COUNT = 2048;
+using DstOptBits = std::array<uint64_t, DST_OPT_COUNT / 64>;
+
+inline bool testDstOptBit(const DstOptBits& bits, size_t idx)
+{
+    return idx < DST_OPT_COUNT && (bits[idx / 64] >> (idx % 64) & 1);
+}
+
+// An element's dst options, compiled once at load time. Options are grouped by 64-bit word, the condition holds when
+// every term's word has all of 'set' and none of 'clear'.
+struct DstOptCondition
+{
+    struct Term
+    {
+        uint16_t word;
+        uint64_t set;
+        uint64_t clear;
+    };
+    std::vector<Term> terms;
+    bool never = false;
+
+    static DstOptCondition compile(const std::vector<dst_option>& ops);
+    bool eval(const DstOptBits& bits) const;
+    // Whether any option this condition looks at differs in 'changed' (old ^ new).
+    bool affectedBy(const DstOptBits& changed) const;
+};
+
 // int
 enum num
 {
@@ -1312,10 +1344,14 @@ public:
 
 public:
     void setGaugeDisplayType(unsigned slot, GaugeDisplayType type) override;
+    bool activate() override;
 
 private:
     static std::map<std::string, Path> LR2SkinFontPathCache;
     std::map<std::string, std::shared_ptr<Texture>> prevSkinTextureNameMap;
+    // Textures of the skin last built or activated on the main thread, what #IMAGE,CONTINUE refers to.
+    static std::mutex shownTextureNameMapMutex;
+    static std::map<std::string, std::shared_ptr<Texture>> shownTextureNameMap;
 
     struct Customize
     {
@@ -1340,6 +1376,7 @@ private:
     };
     std::vector<Customize> customize;
     std::map<size_t, size_t> customizeRandom;
+    void applyCustomDstOpt() const;
 
     struct LR2Font
     {
@@ -1364,6 +1401,13 @@ protected:
     bool reloadBanner = false; // unused
     bool flipSide = false;     // flip 1P/2P defs: note indices, timers (42-139, 143, 144)
     bool disableFlipResult = false;
+    bool flipResult = false;       // #FLIPRESULT
+    bool flipResultSwitch = false; // IndexSwitch::FLIP_RESULT while this skin is shown
+
+    // Hands what the next skin is built against (#FLIPRESULT, #IMAGE,CONTINUE) and the FLIP_RESULT switch over to the
+    // shared state. Main thread only: right after building there, or from activate() for a skin built in the
+    // background.
+    void publish() const;
 
 public:
     int adjustPlaySkinX = 0;
@@ -1386,6 +1430,8 @@ public:
 
 protected:
     bool loadCSV(Path p);
+    bool loadCSVCache(const Path& p);
+    [[nodiscard]] std::string getCSVCacheKey(const Path& p) const;
     void postLoad();
     void findAndExtractDXA(const Path& path);
 
@@ -1416,6 +1462,20 @@ protected:
 private:
     unsigned csvLineNumber = 0; // line parsing index
 
+    // Non-null while the body of a cache miss is parsed, collects what loadCSVCache() replays next time.
+    std::unique_ptr<lunaticvibes::SkinLR2CSVCache> csvCacheRecord;
+    // What the #IF blocks of the body were resolved against.
+    std::vector<lunaticvibes::SkinLR2CSVCache::Condition> ifConditions;
+
+    // Holds the small images of this skin, so consecutive sprites rarely switch textures.
+    lunaticvibes::graphics::TextureAtlas textureAtlas;
+    std::shared_ptr<Texture> loadImageTexture(const Path& path, std::optional<Color> transparentColor);
+
+protected:
+    bool loadedFromCSVCache = false;
+
+private:
+
     // #XXX_XXXXX with #
     StringContent parseKeyBuf;
 
@@ -1616,8 +1676,14 @@ protected:
         std::vector<dst_option> dstOpt;
         // Turntable angle. Either 1 for P1 or 2 for P2.
         int op4;
+
+        // dstOpt compiled in postLoad(), and its result, only re-evaluated when one of its options changed.
+        DstOptCondition dstCond;
+        bool dstVisible = false;
+        bool dstEvaluated = false;
     };
     std::vector<element> drawQueue;
+    DstOptBits dstOptBitsSeen{};
 
 public:
     void update() override;
@@ -1643,3 +1709,18 @@ void updateDstOpt();
 void setCustomDstOpt(unsigned base, size_t offset, bool val);
 void clearCustomDstOpt();
 bool getDstOpt(int d);
+// Copy of all options in one go, for evaluating many DstOptConditions.
+void getDstOptBits(DstOptBits& bits);
+
+// While alive, custom options (900-999) set and read on this thread are private to it, so a skin can be built in the
+// background without changing the options of the skin on screen.
+class PrivateCustomDstOptScope
+{
+    DstOptBits _customBits{};
+
+public:
+    PrivateCustomDstOptScope();
+    ~PrivateCustomDstOptScope();
+    PrivateCustomDstOptScope(const PrivateCustomDstOptScope&) = delete;
+    PrivateCustomDstOptScope& operator=(const PrivateCustomDstOptScope&) = delete;
+};
@@ -0,0 +1,129 @@
+#include "skin_lr2_cache.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <cereal/archives/portable_binary.hpp>
+
+#include "common/hash.h"
+#include "common/log.h"
+#include "common/meta.h"
+#include "common/u8.h"
+#include "common/utils.h"
+
+namespace lunaticvibes
+{
+
+static int64_t getWriteTime(const Path& path)
+{
+    std::error_code ec;
+    const auto t = fs::last_write_time(path, ec);
+    return ec ? 0 : static_cast<int64_t>(t.time_since_epoch().count());
+}
+
+void SkinLR2CSVCache::addFile(const Path& path, std::string_view content)
+{
+    files.push_back({u8str(path), md5(content).hexdigest(), content.size(), getWriteTime(path)});
+}
+
+void SkinLR2CSVCache::addMissingFile(const Path& path)
+{
+    files.push_back({u8str(path), {}});
+}
+
+void SkinLR2CSVCache::addCondition(unsigned op, bool value)
+{
+    if (std::none_of(conditions.begin(), conditions.end(), [op](const Condition& c) { return c.op == op; }))
+        conditions.push_back({op, value});
+}
+
+bool SkinLR2CSVCache::filesUnchanged() const
+{
+    for (const auto& f : files)
+    {
+        const Path p = PathFromUTF8(f.path);
+        std::error_code ec;
+        const bool exists = fs::is_regular_file(p, ec);
+        if (f.md5.empty())
+        {
+            if (exists)
+                return false;
+            continue;
+        }
+        if (!exists)
+            return false;
+
+        // touched files are hashed, a same-size edit within the clock resolution is not noticed
+        const auto size = fs::file_size(p, ec);
+        if (!ec && size == f.size && getWriteTime(p) == f.writeTime)
+            continue;
+        if (md5file(p).hexdigest() != f.md5)
+            return false;
+    }
+    return !files.empty();
+}
+
+static Path& cacheFolder()
+{
+    static Path folder = Path(GAMEDATA_PATH) / "cache" / "skin";
+    return folder;
+}
+
+Path SkinLR2CSVCache::getCachePath(std::string_view key)
+{
+    return cacheFolder() / (md5(key).hexdigest() + ".bin");
+}
+
+void SkinLR2CSVCache::setCacheFolder(const Path& folder)
+{
+    cacheFolder() = folder;
+}
+
+bool SkinLR2CSVCache::load(const Path& path)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.good())
+        return false;
+
+    // one read for the whole file, the archive then works from memory
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    ifs.close();
+    try
+    {
+        cereal::PortableBinaryInputArchive ia(ss);
+        ia(*this);
+    }
+    catch (const cereal::Exception& e)
+    {
+        LOG_WARNING << "[SkinLR2CSVCache] Bad cache file " << path << ": " << e.what();
+        return false;
+    }
+    return version == VERSION;
+}
+
+bool SkinLR2CSVCache::save(const Path& path) const
+{
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs.good())
+    {
+        LOG_WARNING << "[SkinLR2CSVCache] Cannot write " << path;
+        return false;
+    }
+    try
+    {
+        cereal::PortableBinaryOutputArchive oa(ofs);
+        oa(*this);
+    }
+    catch (const cereal::Exception& e)
+    {
+        LOG_WARNING << "[SkinLR2CSVCache] save() cereal exception: " << e.what();
+        return false;
+    }
+    return true;
+}
+
+} // namespace lunaticvibes
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include "common/types.h"
+
+namespace lunaticvibes
+{
+
+// Body of an LR2 CSV skin after preprocessing: #IF branches resolved, #INCLUDE files inlined and every line already
+// tokenized. Replaying the lines skips reading includes, re-encoding, tokenizing and evaluating #IF blocks on each
+// scene change. Source files are only hashed again when their size or write time changed.
+struct SkinLR2CSVCache
+{
+    static constexpr uint32_t VERSION = 2;
+
+    enum LineType : uint8_t
+    {
+        HEADER, // header defs of included files
+        BODY,
+    };
+    struct Line
+    {
+        uint8_t type = BODY;
+        uint32_t number = 0; // source line, for logs
+        std::vector<std::string> tokens;
+
+        template <class Archive> void serialize(Archive& ar) { ar(type, number, tokens); }
+    };
+
+    // Every file the lines came from, the cache is stale as soon as one of them changes.
+    struct File
+    {
+        std::string path; // utf-8
+        std::string md5;  // empty if the file did not exist
+        uint64_t size = 0;
+        int64_t writeTime = 0; // fs::last_write_time ticks, only compared on the same machine
+
+        template <class Archive> void serialize(Archive& ar) { ar(path, md5, size, writeTime); }
+    };
+
+    // Dst options the #IF blocks looked at, with the value they had.
+    struct Condition
+    {
+        uint32_t op = 0;
+        bool value = false;
+
+        template <class Archive> void serialize(Archive& ar) { ar(op, value); }
+    };
+
+    uint32_t version = VERSION;
+    std::vector<File> files;
+    std::vector<Condition> conditions;
+    std::vector<Line> lines;
+
+    template <class Archive> void serialize(Archive& ar) { ar(version, files, conditions, lines); }
+
+    void addFile(const Path& path, std::string_view content);
+    void addMissingFile(const Path& path);
+    void addCondition(unsigned op, bool value);
+    [[nodiscard]] bool filesUnchanged() const;
+
+    // <cache folder>/<md5 of key>.bin
+    [[nodiscard]] static Path getCachePath(std::string_view key);
+    // gamedata/cache/skin unless set. Not synchronized, set it before loading skins.
+    static void setCacheFolder(const Path& folder);
+    // False if the file is missing, unreadable or written by another VERSION. The skin is parsed again then.
+    bool load(const Path& path);
+    bool save(const Path& path) const;
+};
+
+} // namespace lunaticvibes
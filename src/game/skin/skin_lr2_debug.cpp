@@ -1,6 +1,7 @@
 #include "skin_lr2_debug.h"
 
 #include "common/sysutil.h"
+#include "game/graphics/texture_cache.h"
 #include "game/runtime/state.h"
 #include "game/skin/skin_lr2.h"
 #include "imgui.h"
@@ -232,3 +233,43 @@ void imguiMonitorTimer()
         ImGui::End();
     }
 }
+
+void imguiMonitorTextureCache()
+{
+    LVF_DEBUG_ASSERT(IsMainThread());
+    if (!imguiShowMonitorTextureCache)
+        return;
+
+    if (ImGui::Begin("Texture cache (F10)", &imguiShowMonitorTextureCache, ImGuiWindowFlags_NoCollapse))
+    {
+        auto& cache = lunaticvibes::graphics::TextureCache::shared();
+        const auto stats = cache.getStats();
+        constexpr double MB = 1024.0 * 1024.0;
+        ImGui::Text("Resident: %zu textures, %.1f / %.1f MB", stats.entries, stats.bytes / MB, stats.budget / MB);
+        ImGui::Text("Referenced: %zu textures, %.1f MB", stats.referenced, stats.referencedBytes / MB);
+        ImGui::Text("Atlas pages: %zu", stats.pages);
+        ImGui::Text("Hits: %llu  Misses: %llu  Evictions: %llu", (unsigned long long)stats.hits,
+                    (unsigned long long)stats.misses, (unsigned long long)stats.evictions);
+        if (ImGui::Button("Purge unreferenced"))
+            cache.purge();
+
+        if (ImGui::CollapsingHeader("Entries (most recently used first)"))
+        {
+            if (ImGui::BeginTable("##texturecache", 3, ImGuiTableFlags_SizingFixedFit))
+            {
+                for (const auto& e : cache.getEntries())
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::Text("%ld", e.refs);
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%dx%d", e.size.w, e.size.h);
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::TextUnformatted(e.path.c_str());
+                }
+                ImGui::EndTable();
+            }
+        }
+        ImGui::End();
+    }
+}
@@ -19,6 +19,7 @@ inline bool imguiShowMonitorSwitch = false;
 inline bool imguiShowMonitorText = false;
 inline bool imguiShowMonitorBargraph = false;
 inline bool imguiShowMonitorTimer = false;
+inline bool imguiShowMonitorTextureCache = false;
 void imguiMonitorLR2DST();
 void imguiMonitorNumber();
 void imguiMonitorOption();
@@ -27,3 +28,4 @@ void imguiMonitorSwitch();
 void imguiMonitorText();
 void imguiMonitorBargraph();
 void imguiMonitorTimer();
+void imguiMonitorTextureCache();
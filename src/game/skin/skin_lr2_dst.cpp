@@ -1,3 +1,4 @@
+#include "common/assert.h"
 #include "game/arena/arena_data.h"
 #include "game/scene/scene_context.h"
 #include "skin_lr2.h"
@@ -7,9 +8,12 @@
 namespace
 {
 static std::shared_mutex _mutex;
-static std::bitset<900> _op;
-static std::bitset<100> _customOp;
-static std::map<size_t, bool> _extendedOp;
+// Published options. 900-999 are the skin's custom options, set outside of updateDstOpt().
+static DstOptBits _bits{};
+// updateDstOpt() builds the next state here before publishing it. Skins may be built on a worker thread meanwhile.
+static thread_local DstOptBits _next{};
+// Custom options of a skin being built on this thread, see PrivateCustomDstOptScope.
+static thread_local DstOptBits* t_customBits = nullptr;
 } // namespace
 
 static bool any_of(std::initializer_list<unsigned> entries, unsigned val)
@@ -25,12 +29,17 @@ inline bool sw(IndexSwitch entry)
     return State::get(entry);
 }
 
+static void setBit(DstOptBits& bits, size_t idx, bool val)
+{
+    if (idx >= DST_OPT_COUNT)
+        return;
+    const uint64_t mask = uint64_t{1} << (idx % 64);
+    bits[idx / 64] = val ? (bits[idx / 64] | mask) : (bits[idx / 64] & ~mask);
+}
+
 inline void set(unsigned idx, bool val = true)
 {
-    if (idx >= 1000)
-        _extendedOp[idx] = val;
-    else
-        _op.set(idx, val);
+    setBit(_next, idx, val);
 }
 inline void set(std::initializer_list<unsigned> idx)
 {
@@ -39,10 +48,7 @@ inline void set(std::initializer_list<unsigned> idx)
 }
 inline bool get(int idx)
 {
-    if (idx >= 1000)
-        return _extendedOp[idx];
-    else
-        return _op[idx];
+    return testDstOptBit(_next, idx);
 }
 
 bool getDstOpt(int d)
@@ -55,43 +61,112 @@ bool getDstOpt(int d)
         result = true;
     else if (d == DST_FALSE)
         result = false;
-    else if (op < 900)
+    else if (t_customBits && op >= 900 && op <= 999)
+        result = testDstOptBit(*t_customBits, op);
+    else
     {
         std::shared_lock l(_mutex);
-        result = _op[op];
+        result = testDstOptBit(_bits, op);
     }
-    else if (op >= 900)
+    return (d >= 0) ? result : !result;
+}
+
+void getDstOptBits(DstOptBits& bits)
+{
+    std::shared_lock l(_mutex);
+    bits = _bits;
+}
+
+DstOptCondition DstOptCondition::compile(const std::vector<dst_option>& ops)
+{
+    // Mirrors getDstOpt().
+    static constexpr int is_lunatic_vibes{9999};
+    DstOptCondition c;
+    for (const int d : ops)
     {
-        std::shared_lock l(_mutex);
-        if (op > 999)
-            result = _extendedOp[op];
-        else
-            result = _customOp[op - 900];
+        if (d == is_lunatic_vibes || d == DST_TRUE)
+            continue;
+        if (d == DST_FALSE)
+        {
+            c.never = true;
+            continue;
+        }
+        const size_t op = std::abs(d);
+        if (op >= DST_OPT_COUNT)
+        {
+            // never set, i.e. always false
+            if (d > 0)
+                c.never = true;
+            continue;
+        }
+
+        const auto word = static_cast<uint16_t>(op / 64);
+        auto it = std::find_if(c.terms.begin(), c.terms.end(), [word](const Term& t) { return t.word == word; });
+        if (it == c.terms.end())
+            it = c.terms.insert(c.terms.end(), {word, 0, 0});
+        (d > 0 ? it->set : it->clear) |= uint64_t{1} << (op % 64);
     }
-    return (d >= 0) ? result : !result;
+    return c;
+}
+
+bool DstOptCondition::eval(const DstOptBits& bits) const
+{
+    if (never)
+        return false;
+    for (const auto& t : terms)
+        if ((bits[t.word] & t.set) != t.set || (bits[t.word] & t.clear) != 0)
+            return false;
+    return true;
+}
+
+bool DstOptCondition::affectedBy(const DstOptBits& changed) const
+{
+    for (const auto& t : terms)
+        if (changed[t.word] & (t.set | t.clear))
+            return true;
+    return false;
 }
 
 void setCustomDstOpt(unsigned base, size_t offset, bool val)
 {
     if (base + offset < 900 || base + offset > 999)
         return;
+    if (t_customBits)
+    {
+        setBit(*t_customBits, base + offset, val);
+        return;
+    }
     std::unique_lock l(_mutex);
-    _customOp[base + offset - 900] = val;
+    setBit(_bits, base + offset, val);
 }
 
 void clearCustomDstOpt()
 {
+    if (t_customBits)
+    {
+        for (size_t i = 900; i < 1000; ++i)
+            setBit(*t_customBits, i, false);
+        return;
+    }
     std::unique_lock l(_mutex);
-    _customOp.reset();
+    for (size_t i = 900; i < 1000; ++i)
+        setBit(_bits, i, false);
 }
 
-void updateDstOpt()
+PrivateCustomDstOptScope::PrivateCustomDstOptScope()
 {
-    std::unique_lock l(_mutex);
-    _op.reset();
+    LVF_DEBUG_ASSERT(t_customBits == nullptr);
+    t_customBits = &_customBits;
+}
 
-    for (auto& [i, o] : _extendedOp)
-        o = false;
+PrivateCustomDstOptScope::~PrivateCustomDstOptScope()
+{
+    t_customBits = nullptr;
+}
+
+void updateDstOpt()
+{
+    _next.fill(0);
 
     // 0 常にtrue
     set(0);
@@ -169,7 +244,7 @@ void updateDstOpt()
     // 38 scoregraph off
     // 39 scoregraph on
     set(38, !sw(IndexSwitch::SYSTEM_SCOREGRAPH));
-    set(39, !_op[38]);
+    set(39, !get(38));
 
     // 40 BGA off
     // 41 BGA on
@@ -207,26 +282,26 @@ void updateDstOpt()
     // 50 オフライン
     // 51 オンライン
     set(50, !sw(IndexSwitch::NETWORK));
-    set(51, !_op[50]);
+    set(51, !get(50));
 
     // 52 EXTRA MODE OFF
     // 53 EXTRA MODE ON
     set(52, !sw(IndexSwitch::PLAY_OPTION_EXTRA));
-    set(53, !_op[52]);
+    set(53, !get(52));
 
     // 54 AUTOSCRATCH 1P OFF
     // 55 AUTOSCRATCH 1P ON
     // 56 AUTOSCRATCH 2P OFF
     // 57 AUTOSCRATCH 2P ON
     set(54, !sw(IndexSwitch::PLAY_OPTION_AUTOSCR_1P));
-    set(55, !_op[54]);
+    set(55, !get(54));
     set(56, !sw(IndexSwitch::PLAY_OPTION_AUTOSCR_2P));
-    set(57, !_op[56]);
+    set(57, !get(56));
 
     // 60 スコアセーブ不可能
     // 61 スコアセーブ可能
     set(60, !sw(IndexSwitch::CHART_CAN_SAVE_SCORE));
-    set(61, !_op[60]);
+    set(61, !get(60));
 
     // 62 クリアセーブ不可能
     // 63 EASYゲージ （仕様書では「イージーでセーブ」）
@@ -263,11 +338,11 @@ void updateDstOpt()
         set(72, State::get(IndexNumber::MUSIC_HYPER_LEVEL) <= ceiling);
         set(73, State::get(IndexNumber::MUSIC_ANOTHER_LEVEL) <= ceiling);
         set(74, State::get(IndexNumber::MUSIC_INSANE_LEVEL) <= ceiling);
-        set(75, !_op[70]);
-        set(76, !_op[71]);
-        set(77, !_op[72]);
-        set(78, !_op[73]);
-        set(79, !_op[74]);
+        set(75, !get(70));
+        set(76, !get(71));
+        set(77, !get(72));
+        set(78, !get(73));
+        set(79, !get(74));
     }
 
     // 80 ロード未完了
@@ -275,7 +350,7 @@ void updateDstOpt()
     {
         using namespace Option;
         set(80, any_of({SPLAY_PREPARE, SPLAY_LOADING}, State::get(IndexOption::PLAY_SCENE_STAT)));
-        set(81, !_op[80]);
+        set(81, !get(80));
     }
 
     // 82 リプレイオフ
@@ -288,7 +363,7 @@ void updateDstOpt()
     // 90 リザ クリア
     // 91 リザ ミス
     set(90, sw(IndexSwitch::RESULT_CLEAR));
-    set(91, !_op[90]);
+    set(91, !get(90));
 
     // /////////////////////////////////
     // //選曲リスト用
@@ -309,7 +384,7 @@ void updateDstOpt()
         using namespace Option;
         switch (State::get(IndexOption::SELECT_ENTRY_LAMP))
         {
-        case LAMP_NOPLAY: set(100, _op[5]); break;
+        case LAMP_NOPLAY: set(100, get(5)); break;
         case LAMP_FAILED: set(101); break;
         case LAMP_ASSIST:
             set(102);
@@ -414,7 +489,7 @@ void updateDstOpt()
     // 145 SP TO DP (もしかしたら今後DP TO SPや 9 TO 7と共有項目になるかも。
 
     // 150 difficulty0 (未設定)
-    if (_op[5])
+    if (get(5))
     {
         switch (State::get(IndexOption::CHART_DIFFICULTY))
         {
@@ -431,29 +506,29 @@ void updateDstOpt()
     // 170 BGA無し
     // 171 BGA有り
     set(170, !sw(IndexSwitch::CHART_HAVE_BGA));
-    set(171, !_op[170]);
+    set(171, !get(170));
 
     // 172 ロングノート無し
     // 173 ロングノート有り
     set(172, !sw(IndexSwitch::CHART_HAVE_LN));
-    set(173, !_op[172]);
+    set(173, !get(172));
 
     // 174 付属テキスト無し
     // 175 付属テキスト有り
     set(174, !sw(IndexSwitch::CHART_HAVE_README));
-    set(175, !_op[174]);
+    set(175, !get(174));
 
     // 176 BPM変化無し
     // 177 BPM変化有り
     set(176, !sw(IndexSwitch::CHART_HAVE_BPMCHANGE));
-    set(177, !_op[176]);
+    set(177, !get(176));
 
     // 178 ランダム命令無し
     // 179 ランダム命令有り
     set(178, !sw(IndexSwitch::CHART_HAVE_RANDOM));
-    set(179, !_op[178]);
+    set(179, !get(178));
 
-    if (_op[5]) // is playable
+    if (get(5)) // is playable
     {
 
         // //元データ
@@ -503,24 +578,24 @@ void updateDstOpt()
             using namespace Option;
             // case DIFF_ANY: set(185); break;
         case DIFF_BEGINNER:
-            set(185, _op[70]);
-            set(186, _op[75]);
+            set(185, get(70));
+            set(186, get(75));
             break;
         case DIFF_NORMAL:
-            set(185, _op[71]);
-            set(186, _op[76]);
+            set(185, get(71));
+            set(186, get(76));
             break;
         case DIFF_HYPER:
-            set(185, _op[72]);
-            set(186, _op[77]);
+            set(185, get(72));
+            set(186, get(77));
             break;
         case DIFF_ANOTHER:
-            set(185, _op[73]);
-            set(186, _op[78]);
+            set(185, get(73));
+            set(186, get(78));
             break;
         case DIFF_INSANE:
-            set(185, _op[74]);
-            set(186, _op[79]);
+            set(185, get(74));
+            set(186, get(79));
             break;
         }
     }
@@ -528,22 +603,22 @@ void updateDstOpt()
     // 190 STAGEFILE無し
     // 191 STAGEFILE有り
     set(190, !sw(IndexSwitch::CHART_HAVE_STAGEFILE));
-    set(191, !_op[190]);
+    set(191, !get(190));
 
     // 192 BANNER無し
     // 193 BANNER有り
     set(192, !sw(IndexSwitch::CHART_HAVE_BANNER));
-    set(193, !_op[192]);
+    set(193, !get(192));
 
     // 194 BACKBMP無し
     // 195 BACKBMP有り
     set(194, !sw(IndexSwitch::CHART_HAVE_BACKBMP));
-    set(195, !_op[194]);
+    set(195, !get(194));
 
     // 196 リプレイ無し
     // 197 リプレイ有り
     set(196, !sw(IndexSwitch::CHART_HAVE_REPLAY));
-    set(197, !_op[196]);
+    set(197, !get(196));
 
     // /////////////////////////////////
     // //プレイ中
@@ -833,7 +908,7 @@ void updateDstOpt()
     // 350 リザルトフリップ無効(プレイスキンで#FLIPRESULT命令無し、もしくは#DISABLEFLIP命令以降
     // 351 リザルトフリップ有効(プレイスキンで#FLIPRESULT命令有り
     set(350, sw(IndexSwitch::FLIP_RESULT));
-    set(351, !_op[350]);
+    set(351, !get(350));
 
     // 352 1PWIN 2PLOSE
     // 353 1PLOSE 2PWIN
@@ -867,7 +942,7 @@ void updateDstOpt()
     // ///////////////////////////////////
     // //その他
 
-    if (_op[2])
+    if (get(2))
     {
         // 500 同じフォルダにbeginner譜面が存在しない
         // 501 同じフォルダにnormal譜面が存在しない
@@ -885,11 +960,11 @@ void updateDstOpt()
         // 507 同じフォルダにhyper譜面が存在する
         // 508 同じフォルダにanother譜面が存在する
         // 509 同じフォルダにinsane譜面が存在する
-        set(505, !_op[500]);
-        set(506, !_op[501]);
-        set(507, !_op[502]);
-        set(508, !_op[503]);
-        set(509, !_op[504]);
+        set(505, !get(500));
+        set(506, !get(501));
+        set(507, !get(502));
+        set(508, !get(503));
+        set(509, !get(504));
 
         const bool have_mult_1 = State::get(IndexSwitch::CHART_HAVE_MULTIPLE_DIFFICULTY_1);
         const bool have_mult_2 = State::get(IndexSwitch::CHART_HAVE_MULTIPLE_DIFFICULTY_2);
@@ -902,22 +977,22 @@ void updateDstOpt()
         // 512 同じフォルダに一個のhyper譜面が存在する
         // 513 同じフォルダに一個のanother譜面が存在する
         // 514 同じフォルダに一個のnsane譜面が存在する
-        set(510, _op[505] && !have_mult_1);
-        set(511, _op[506] && !have_mult_2);
-        set(512, _op[507] && !have_mult_3);
-        set(513, _op[508] && !have_mult_4);
-        set(514, _op[509] && !have_mult_5);
+        set(510, get(505) && !have_mult_1);
+        set(511, get(506) && !have_mult_2);
+        set(512, get(507) && !have_mult_3);
+        set(513, get(508) && !have_mult_4);
+        set(514, get(509) && !have_mult_5);
 
         // 515 同じフォルダに複数のbeginner譜面が存在する
         // 516 同じフォルダに複数のnormal譜面が存在する
         // 517 同じフォルダに複数のhyper譜面が存在する
         // 518 同じフォルダに複数のanother譜面が存在する
         // 519 同じフォルダに複数のnsane譜面が存在する
-        set(515, _op[505] && have_mult_1);
-        set(516, _op[506] && have_mult_2);
-        set(517, _op[507] && have_mult_3);
-        set(518, _op[508] && have_mult_4);
-        set(519, _op[509] && have_mult_5);
+        set(515, get(505) && have_mult_1);
+        set(516, get(506) && have_mult_2);
+        set(517, get(507) && have_mult_3);
+        set(518, get(508) && have_mult_4);
+        set(519, get(509) && have_mult_5);
 
         switch (State::get(IndexOption::CHART_DIFFICULTY))
         {
@@ -1261,4 +1336,9 @@ void updateDstOpt()
             set(1401 + i, gArenaData.isPlayerReady(i));
         }
     }
+
+    std::unique_lock l(_mutex);
+    for (size_t i = 900; i < 1000; ++i)
+        setBit(_next, i, testDstOptBit(_bits, i));
+    _bits = _next;
 }
@@ -1,21 +1,21 @@
 #include "skin_mgr.h"
+#include "common/log.h"
+#include "common/sysutil.h"
 #include "common/utils.h"
 #include "config/config_mgr.h"
 #include "game/skin/skin.h"
 #include "game/skin/skin_lr2.h"
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <thread>
 
-SkinMgr::SkinMgr() : _sharedSprites(std::make_shared<std::array<std::shared_ptr<SpriteBase>, SPRITE_GLOBAL_MAX>>()) {}
+SkinMgr::SkinMgr() : _sharedSprites(std::make_shared<SharedSprites>()) {}
 
-void SkinMgr::reload(SkinType e, bool simple)
+// Configured and default skin file of a type.
+static SkinVersion getSkinFilePath(SkinType e, Path& skinFilePath, Path& skinFilePathDefault)
 {
-    auto& skinObj = _skins[static_cast<size_t>(e)];
-    if (skinObj != nullptr)
-        unload(e);
-
     std::string skinFilePathStr;
-    Path skinFilePath;
-    Path skinFilePathDefault;
     SkinVersion version = SkinVersion::LR2beta3;
 
     switch (e)
@@ -86,16 +86,180 @@ void SkinMgr::reload(SkinType e, bool simple)
     }
 
     skinFilePath = convertLR2Path(ConfigMgr::get('E', cfg::E_LR2PATH, "."), skinFilePathStr);
+    return version;
+}
 
-    switch (version)
+// SkinLR2 parses into static state (texture and font name maps, dst options), only one skin is built at a time.
+static std::mutex s_buildMutex;
+
+static std::unique_lock<std::mutex> lockBuild()
+{
+    std::unique_lock l(s_buildMutex, std::defer_lock);
+    if (!IsMainThread())
+    {
+        l.lock();
+        return l;
+    }
+    // The preload thread may be holding the lock while waiting for a texture upload on this thread.
+    while (!l.try_lock())
+    {
+        doMainThreadTask(true);
+        std::this_thread::yield();
+    }
+    return l;
+}
+
+SkinMgr::~SkinMgr()
+{
+    waitPreload();
+}
+
+std::shared_ptr<SkinBase> SkinMgr::build(SkinType e, bool simple, const std::shared_ptr<SharedSprites>& sharedSprites)
+{
+    Path skinFilePath;
+    Path skinFilePathDefault;
+    std::shared_ptr<SkinBase> skinObj;
+    switch (getSkinFilePath(e, skinFilePath, skinFilePathDefault))
     {
     case SkinVersion::LR2beta3:
-        skinObj = std::make_shared<SkinLR2>(_sharedSprites, skinFilePath, simple ? 1 : 0);
+        skinObj = std::make_shared<SkinLR2>(sharedSprites, skinFilePath, simple ? 1 : 0);
         if (!skinObj->isLoaded())
-            skinObj = std::make_shared<SkinLR2>(_sharedSprites, skinFilePathDefault, simple ? 1 : 0);
+            skinObj = std::make_shared<SkinLR2>(sharedSprites, skinFilePathDefault, simple ? 1 : 0);
         break;
     case SkinVersion::UNDEF: break;
     }
+    return skinObj;
+}
+
+void SkinMgr::reload(SkinType e, bool simple)
+{
+    auto& skinObj = _skins[static_cast<size_t>(e)];
+    skinObj.reset();
+
+    if (!simple)
+    {
+        std::shared_ptr<SharedSprites> sharedSprites;
+        if (auto preloaded = takePreloaded(e, sharedSprites); preloaded && preloaded->activate())
+        {
+            LOG_INFO << "[SkinMgr] Using preloaded skin for type " << e;
+            skinObj = std::move(preloaded);
+            _sharedSprites = std::move(sharedSprites);
+            return;
+        }
+    }
+
+    auto l = lockBuild();
+    skinObj = build(e, simple, _sharedSprites);
+}
+
+void SkinMgr::preload(SkinType e)
+{
+    std::unique_lock l(_preloadMutex);
+    if (e == _preloadRequested)
+        return;
+    _preloadRequested = e;
+
+    // a running worker picks the new request up when it is done
+    if (_preloadWorker.valid() && _preloadWorker.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+    _preloadWorker = std::async(std::launch::async, std::bind_front(&SkinMgr::preloadLoop, this)).share();
+}
+
+void SkinMgr::preloadLoop()
+{
+    SetThreadName("SkinPreload");
+    SetThreadMainThreadTasksDeferred(true);
+    while (true)
+    {
+        SkinType e;
+        {
+            std::unique_lock l(_preloadMutex);
+            e = _preloadRequested;
+            if (e == SkinType::MODE_COUNT || e == _preloadedType)
+                return;
+        }
+
+        Path skinFilePath;
+        Path skinFilePathDefault;
+        getSkinFilePath(e, skinFilePath, skinFilePathDefault);
+
+        LOG_DEBUG << "[SkinMgr] Preloading skin for type " << e << ": " << skinFilePath;
+        std::shared_ptr<SkinBase> skin;
+        auto sharedSprites = std::make_shared<SharedSprites>();
+        {
+            PrivateCustomDstOptScope customDstOpt;
+            auto buildLock = lockBuild();
+            skin = build(e, false, sharedSprites);
+        }
+        // restarted by activate()
+        if (skin)
+            skin->stopSpriteVideoPlayback();
+
+        std::unique_lock l(_preloadMutex);
+        _preloaded = std::move(skin);
+        _preloadedSprites = std::move(sharedSprites);
+        _preloadedType = e;
+        _preloadedPath = std::move(skinFilePath);
+    }
+}
+
+void SkinMgr::waitPreload()
+{
+    std::shared_future<void> worker;
+    {
+        std::unique_lock l(_preloadMutex);
+        worker = _preloadWorker;
+    }
+    if (!worker.valid())
+        return;
+    if (IsMainThread())
+    {
+        // uploads of the preload thread are run on this thread
+        while (worker.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready)
+            doMainThreadTask(true);
+    }
+    worker.wait();
+}
+
+std::shared_ptr<SkinBase> SkinMgr::takePreloaded(SkinType e, std::shared_ptr<SharedSprites>& sharedSprites)
+{
+    bool building;
+    {
+        std::unique_lock l(_preloadMutex);
+        building = _preloadRequested == e && _preloadedType != e;
+        if (!building && _preloadedType != e)
+            return nullptr;
+    }
+    if (building)
+        waitPreload();
+
+    Path skinFilePath;
+    Path skinFilePathDefault;
+    getSkinFilePath(e, skinFilePath, skinFilePathDefault);
+
+    std::unique_lock l(_preloadMutex);
+    if (_preloadedType != e)
+        return nullptr;
+    std::shared_ptr<SkinBase> skin = std::move(_preloaded);
+    sharedSprites = std::move(_preloadedSprites);
+    const bool sameFile = _preloadedPath == skinFilePath;
+    _preloadedType = SkinType::MODE_COUNT;
+    if (_preloadRequested == e)
+        _preloadRequested = SkinType::MODE_COUNT;
+    return sameFile ? skin : nullptr;
+}
+
+void SkinMgr::dropPreloaded(SkinType e)
+{
+    std::unique_lock l(_preloadMutex);
+    if (_preloadedType == e)
+    {
+        _preloaded.reset();
+        _preloadedSprites.reset();
+        _preloadedType = SkinType::MODE_COUNT;
+    }
+    if (_preloadRequested == e)
+        _preloadRequested = SkinType::MODE_COUNT;
 }
 
 std::shared_ptr<SkinBase> SkinMgr::get(SkinType e)
@@ -105,4 +269,6 @@ std::shared_ptr<SkinBase> SkinMgr::get(SkinType e)
 void SkinMgr::unload(SkinType e)
 {
     _skins[static_cast<size_t>(e)].reset();
+    // settings of that skin may have changed
+    dropPreloaded(e);
 }
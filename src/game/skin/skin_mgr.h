@@ -1,12 +1,15 @@
 #pragma once
 #include "skin.h"
 #include <array>
+#include <future>
 #include <memory>
+#include <mutex>
 
 class SkinMgr
 {
 public:
     SkinMgr();
+    ~SkinMgr();
     SkinMgr& operator=(SkinMgr&&) = delete;
     SkinMgr& operator=(SkinMgr&) = delete;
     SkinMgr(SkinMgr&&) = delete;
@@ -18,7 +21,30 @@ public:
     /// May return `nullptr` if that skin has not been loaded yet.
     std::shared_ptr<SkinBase> get(SkinType);
 
+    /// Build the skin of that type on a worker thread, the next reload() of the type takes it instead of parsing.
+    /// Texture uploads are spread over frames. Only the latest request is kept.
+    void preload(SkinType);
+
 protected:
+    using SharedSprites = std::array<std::shared_ptr<SpriteBase>, SPRITE_GLOBAL_MAX>;
+
     std::array<std::shared_ptr<SkinBase>, static_cast<size_t>(SkinType::MODE_COUNT)> _skins{};
-    std::shared_ptr<std::array<std::shared_ptr<SpriteBase>, SPRITE_GLOBAL_MAX>> _sharedSprites{};
-};
\ No newline at end of file
+    std::shared_ptr<SharedSprites> _sharedSprites{};
+
+    std::shared_ptr<SkinBase> build(SkinType, bool simple, const std::shared_ptr<SharedSprites>& sharedSprites);
+
+private:
+    std::mutex _preloadMutex;
+    SkinType _preloadRequested = SkinType::MODE_COUNT;
+    SkinType _preloadedType = SkinType::MODE_COUNT;
+    Path _preloadedPath;
+    std::shared_ptr<SkinBase> _preloaded;
+    // Written by the preloaded skin instead of _sharedSprites, which the skins on screen read. Replaces it when taken.
+    std::shared_ptr<SharedSprites> _preloadedSprites;
+    std::shared_future<void> _preloadWorker;
+
+    void preloadLoop();
+    void waitPreload();
+    std::shared_ptr<SkinBase> takePreloaded(SkinType, std::shared_ptr<SharedSprites>& sharedSprites);
+    void dropPreloaded(SkinType);
+};
@@ -4,11 +4,15 @@
 #include <array>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <utility>
 
 using size_t = std::size_t;
 using uint8_t = std::uint8_t;
 
+// Extensions tried in order when a chart refers to a sample file that does not exist.
+inline constexpr std::string_view NOTE_SAMPLE_FALLBACK_EXTENSIONS[]{".wav", ".ogg", ".flac"};
+
 enum class DSPType : uint8_t
 {
     OFF,
@@ -53,6 +57,16 @@ enum class SoundChannelType : uint8_t
 
 constexpr int DriverIDUnknownASIO = -10;
 
+struct SampleCacheStats
+{
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t bytesResident = 0;
+    size_t bytesBudget = 0;
+};
+
 class SoundDriver : public AsyncLooper
 {
     friend class SoundMgr;
@@ -72,6 +86,7 @@ public:
     virtual void stopNoteSamples() = 0;
     virtual void freeNoteSamples() = 0;
     virtual long long getNoteSampleLength(size_t index) = 0; // in ms
+    virtual SampleCacheStats getNoteSampleCacheStats() = 0;
     virtual int loadSysSample(const Path& path, size_t index, bool isStream = false, bool loop = false) = 0;
     virtual void playSysSample(SoundChannelType ch, size_t index) = 0;
     virtual void stopSysSamples() = 0;
@@ -3,7 +3,9 @@
 
 #include <cstdlib>
 #include <functional>
+#include <string_view>
 #include <type_traits>
+#include <vector>
 
 #include <common/assert.h>
 #include <common/log.h>
@@ -20,6 +22,8 @@
 
 SoundDriverFMOD::SoundDriverFMOD() : SoundDriver(std::bind_front(&SoundDriverFMOD::update, this))
 {
+    setNoteSampleCacheBudget(size_t(std::max(0, ConfigMgr::get('A', cfg::A_SAMPLE_CACHE_MB, 256))) * 1024 * 1024);
+
     // load device
     int driver = -1;
     FMOD_OUTPUTTYPE outputType = FMOD_OUTPUTTYPE_AUTODETECT;
@@ -295,7 +299,10 @@ SoundDriverFMOD::~SoundDriverFMOD()
     // FIXME: free FMOD::DSP*, valgrind complains.
 
     // release before system release
-    freeNoteSamples();
+    const auto stats = getNoteSampleCacheStats();
+    LOG_DEBUG << "[FMOD] Sample cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions
+              << " evictions";
+    clearNoteSampleCache();
     freeSysSamples();
     channelGroup.clear();
 
@@ -465,9 +472,10 @@ int SoundDriverFMOD::findDriver(const std::string& driverName, int driverIDUnkno
 int SoundDriverFMOD::setDevice(size_t index)
 {
     FMOD::System* pOldSystem = fmodSystem;
-    fmodSystem = nullptr;
 
-    freeNoteSamples();
+    // sounds belong to the old system, drop them all
+    clearNoteSampleCache();
+    fmodSystem = nullptr;
     freeSysSamples();
     channelGroup.clear();
 
@@ -533,13 +541,6 @@ int SoundDriverFMOD::setDevice(size_t index)
             pSystem->createSound(s.path.c_str(), s.flags, 0, &s.objptr);
         }
     }
-    for (auto& s : noteSamples)
-    {
-        if (!s.path.empty())
-        {
-            pSystem->createSound(s.path.c_str(), s.flags, 0, &s.objptr);
-        }
-    }
 
     {
         LOG_DEBUG << "[FMOD] FMOD System Initialize Finished.";
@@ -588,6 +589,14 @@ int SoundDriverFMOD::setDevice(size_t index)
         ConfigMgr::set('A', cfg::A_BUFCOUNT, buffers);
     }
 
+    for (size_t i = 0; i < noteSamples.size(); ++i)
+    {
+        if (!noteSamples[i].path.empty())
+        {
+            createNoteSample(PathFromUTF8(noteSamples[i].path), noteSamples[i].flags, i);
+        }
+    }
+
     createChannelGroups();
 
     setVolume(SampleChannel::MASTER, volume[SampleChannel::MASTER]);
@@ -620,58 +629,185 @@ int SoundDriverFMOD::setAsyncIO(bool async)
     return 0;
 }
 
-static constexpr const char8_t* wavExtensionList[]{
-    u8".wav", u8".ogg", u8".flac",
+// Same stem with each of NOTE_SAMPLE_FALLBACK_EXTENSIONS.
+static std::vector<Path> getFallbackSamplePaths(const Path& path)
+{
+    std::vector<Path> paths;
+    for (std::string_view ext : NOTE_SAMPLE_FALLBACK_EXTENSIONS)
+    {
+        paths.push_back(Path(path).replace_extension(ext));
 // Alternatively we could try each of these with resolve_windows_path.
 #ifndef _WIN32
-    u8".WAV", u8".OGG", u8".FLAC",
+        paths.push_back(Path(path).replace_extension(toUpper(ext)));
 #endif //  _WIN32
-};
+    }
+    return paths;
+}
+
+FMOD_RESULT SoundDriverFMOD::createNoteSample(const Path& path, int flags, size_t index)
+{
+    std::string key{lunaticvibes::s(path.u8string())};
+    std::error_code ec;
+    const long long mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+
+    // A sound already used by another slot is not shared; FMOD_UNIQUE would cut it off when both slots play.
+    bool cacheable = true;
+    {
+        std::unique_lock l(noteSampleCacheMutex);
+        if (auto it = noteSampleCacheIndex.find(key); it != noteSampleCacheIndex.end())
+        {
+            auto entry = it->second;
+            if (entry->refs != 0)
+            {
+                cacheable = false;
+            }
+            else if (entry->mtime == mtime)
+            {
+                ++entry->refs;
+                ++noteSampleCacheHits;
+                noteSampleCache.splice(noteSampleCache.begin(), noteSampleCache, entry);
+                noteSamples[index].objptr = entry->objptr;
+                noteSamples[index].path = std::move(key);
+                noteSamples[index].flags = flags;
+                return FMOD_OK;
+            }
+            else
+            {
+                // file changed on disk
+                entry->objptr->release();
+                noteSampleCacheBytes -= entry->bytes;
+                noteSampleCacheIndex.erase(it);
+                noteSampleCache.erase(entry);
+                ++noteSampleCacheEvictions;
+            }
+        }
+    }
+
+    // decode outside the lock, samples of a chart are loaded in parallel
+    FMOD::Sound* sound = nullptr;
+    FMOD_RESULT r = fmodSystem->createSound(key.c_str(), flags, 0, &sound);
+    if (r != FMOD_OK)
+        return r;
+
+    unsigned bytes = 0;
+    sound->getLength(&bytes, FMOD_TIMEUNIT_PCMBYTES);
+
+    std::unique_lock l(noteSampleCacheMutex);
+    ++noteSampleCacheMisses;
+    if (cacheable && !noteSampleCacheIndex.contains(key))
+    {
+        noteSampleCache.push_front({key, mtime, sound, bytes, 1});
+        noteSampleCacheIndex[key] = noteSampleCache.begin();
+        noteSampleCacheBytes += bytes;
+        trimNoteSampleCache();
+    }
+    noteSamples[index].objptr = sound;
+    noteSamples[index].path = std::move(key);
+    noteSamples[index].flags = flags;
+    return FMOD_OK;
+}
+
+void SoundDriverFMOD::releaseNoteSample(size_t index)
+{
+    auto& s = noteSamples[index];
+    if (s.objptr == nullptr)
+        return;
+
+    if (auto it = noteSampleCacheIndex.find(s.path); it != noteSampleCacheIndex.end() && it->second->objptr == s.objptr)
+    {
+        LVF_DEBUG_ASSERT(it->second->refs > 0);
+        --it->second->refs;
+    }
+    else
+    {
+        // not owned by the cache
+        s.objptr->release();
+    }
+    s.objptr = nullptr;
+}
+
+void SoundDriverFMOD::trimNoteSampleCache()
+{
+    for (auto it = noteSampleCache.end(); it != noteSampleCache.begin() && noteSampleCacheBytes > noteSampleCacheBudget;)
+    {
+        --it;
+        if (it->refs != 0)
+            continue;
+
+        it->objptr->release();
+        noteSampleCacheBytes -= it->bytes;
+        noteSampleCacheIndex.erase(it->path);
+        it = noteSampleCache.erase(it);
+        ++noteSampleCacheEvictions;
+    }
+}
+
+void SoundDriverFMOD::clearNoteSampleCache()
+{
+    std::unique_lock l(noteSampleCacheMutex);
+    for (size_t i = 0; i < noteSamples.size(); ++i)
+        releaseNoteSample(i);
+    for (auto& entry : noteSampleCache)
+        entry.objptr->release();
+    noteSampleCache.clear();
+    noteSampleCacheIndex.clear();
+    noteSampleCacheBytes = 0;
+}
+
+SampleCacheStats SoundDriverFMOD::getNoteSampleCacheStats()
+{
+    std::unique_lock l(noteSampleCacheMutex);
+    SampleCacheStats stats;
+    stats.hits = noteSampleCacheHits;
+    stats.misses = noteSampleCacheMisses;
+    stats.evictions = noteSampleCacheEvictions;
+    stats.entries = noteSampleCache.size();
+    stats.bytesResident = noteSampleCacheBytes;
+    stats.bytesBudget = noteSampleCacheBudget;
+    return stats;
+}
+
+void SoundDriverFMOD::setNoteSampleCacheBudget(size_t bytes)
+{
+    std::unique_lock l(noteSampleCacheMutex);
+    noteSampleCacheBudget = bytes;
+    trimNoteSampleCache();
+}
 
 int SoundDriverFMOD::loadNoteSample(const Path& spath, size_t index)
 {
     if (spath.empty())
         return -1;
 
-    if (noteSamples[index].objptr != nullptr)
     {
-        noteSamples[index].objptr->release();
-        noteSamples[index].objptr = nullptr;
+        std::unique_lock l(noteSampleCacheMutex);
+        releaseNoteSample(index);
     }
 
     int flags = FMOD_LOOP_OFF | FMOD_UNIQUE | FMOD_CREATESAMPLE | FMOD_IGNORETAGS | FMOD_LOWMEM;
 
-    std::string path;
+    // callers normally pass a path resolved against the chart folder listing, so a single stat suffices
     FMOD_RESULT r = FMOD_ERR_FILE_NOTFOUND;
-    if (fs::exists(spath) && fs::is_regular_file(spath))
+    if (std::error_code ec; fs::is_regular_file(spath, ec))
     {
-        path = lunaticvibes::s(spath.u8string());
-        r = fmodSystem->createSound(path.c_str(), flags, 0, &noteSamples[index].objptr);
+        r = createNoteSample(spath, flags, index);
     }
 
     if (r == FMOD_ERR_FILE_NOTFOUND)
     {
         // Also find ogg with the same filename
-        Path dir = spath.parent_path();
-        for (auto& ext : wavExtensionList)
+        for (const auto& filePath : getFallbackSamplePaths(spath))
         {
-            Path filePath = dir / Path(spath.stem().u8string() + ext);
             if (fs::exists(filePath) && fs::is_regular_file(filePath))
             {
-                path = lunaticvibes::s(filePath.u8string());
-                r = fmodSystem->createSound(path.c_str(), flags, 0, &noteSamples[index].objptr);
+                r = createNoteSample(filePath, flags, index);
                 if (r == FMOD_OK)
                     break;
             }
         }
     }
 
-    if (r == FMOD_OK)
-    {
-        noteSamples[index].path = path;
-        noteSamples[index].flags = flags;
-    }
-    else
+    if (r != FMOD_OK)
     {
         LOG_DEBUG << "[FMOD] Loading Sample (" << spath << ") Error: " << r << ", " << FMOD_ErrorString(r);
     }
@@ -702,14 +838,10 @@ void SoundDriverFMOD::stopNoteSamples()
 
 void SoundDriverFMOD::freeNoteSamples()
 {
-    for (auto& s : noteSamples)
-    {
-        if (s.objptr != nullptr)
-        {
-            s.objptr->release();
-            s.objptr = nullptr;
-        }
-    }
+    std::unique_lock l(noteSampleCacheMutex);
+    for (size_t i = 0; i < noteSamples.size(); ++i)
+        releaseNoteSample(i);
+    trimNoteSampleCache();
 }
 
 long long SoundDriverFMOD::getNoteSampleLength(size_t index)
@@ -749,10 +881,8 @@ int SoundDriverFMOD::loadSysSample(const Path& spath, size_t index, bool isStrea
     if (r == FMOD_ERR_FILE_NOTFOUND)
     {
         // Also find ogg with the same filename
-        Path dir = spath.parent_path();
-        for (auto& ext : wavExtensionList)
+        for (const auto& filePath : getFallbackSamplePaths(spath))
         {
-            Path filePath = dir / Path(spath.stem().u8string() + ext);
             if (fs::exists(filePath) && fs::is_regular_file(filePath))
             {
                 path = lunaticvibes::s(filePath.u8string());
@@ -5,7 +5,10 @@
 #include "fmod.hpp"
 #include "sound_driver.h"
 #include <array>
+#include <list>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 // This game uses FMOD Low Level API to play sounds as we don't use FMOD Studio,
 
@@ -52,6 +55,30 @@ protected:
     std::array<SoundSample, NOTESAMPLES> noteSamples{}; // Sound samples of key sound
     std::array<SoundSample, SYSSAMPLES> sysSamples{};   // Sound samples of BGM, effect, etc
 
+    // Decoded key sounds are kept after freeNoteSamples() until the memory budget is exceeded, so charts of the same
+    // song sharing most of their samples do not decode them again. Keyed by resolved path, invalidated by mtime.
+    struct CachedNoteSample
+    {
+        std::string path;
+        long long mtime = 0;
+        FMOD::Sound* objptr = nullptr;
+        size_t bytes = 0;
+        unsigned refs = 0; // note sample slots currently playing this sound
+    };
+    std::mutex noteSampleCacheMutex;
+    std::list<CachedNoteSample> noteSampleCache; // most recently used first
+    std::unordered_map<std::string, std::list<CachedNoteSample>::iterator> noteSampleCacheIndex;
+    size_t noteSampleCacheBytes = 0;
+    size_t noteSampleCacheBudget = 0;
+    size_t noteSampleCacheHits = 0;
+    size_t noteSampleCacheMisses = 0;
+    size_t noteSampleCacheEvictions = 0;
+
+    FMOD_RESULT createNoteSample(const Path& path, int flags, size_t index);
+    void releaseNoteSample(size_t index);   // noteSampleCacheMutex must be held
+    void trimNoteSampleCache();             // noteSampleCacheMutex must be held
+    void clearNoteSampleCache();
+
 public:
     SoundDriverFMOD();
     ~SoundDriverFMOD() override;
@@ -74,6 +101,8 @@ public:
     void stopNoteSamples() override;
     void freeNoteSamples() override;
     long long getNoteSampleLength(size_t index) override;
+    SampleCacheStats getNoteSampleCacheStats() override;
+    void setNoteSampleCacheBudget(size_t bytes);
     virtual void update();
 
 public:
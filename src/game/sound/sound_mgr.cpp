@@ -83,6 +83,12 @@ long long SoundMgr::getNoteSampleLength(size_t sample)
         return 0;
     return _inst.driver->getNoteSampleLength(sample);
 }
+SampleCacheStats SoundMgr::getNoteSampleCacheStats()
+{
+    if (!_inst._initialized)
+        return {};
+    return _inst.driver->getNoteSampleCacheStats();
+}
 int SoundMgr::loadSysSample(const Path& path, eSoundSample sample, bool isStream, bool loop)
 {
     if (!_inst._initialized)
@@ -26,6 +26,7 @@ public:
     static void stopNoteSamples();
     static void freeNoteSamples();
     static long long getNoteSampleLength(size_t sample); // in ms
+    static SampleCacheStats getNoteSampleCacheStats();
     static int loadSysSample(const Path& path, eSoundSample sample, bool isStream = false, bool loop = false);
     static void playSysSample(SoundChannelType ch, eSoundSample sample);
     static void stopSysSamples();
@@ -3,7 +3,9 @@
 
 #include "gmock/gmock.h"
 
+#include <fstream>
 #include <optional>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -11,6 +13,7 @@
 #include "../../src/common/utils.h"
 #include "common/chartformat/chartformat_bms.h"
 #include "common/hash.h"
+#include "game/chart/chart_bms.h"
 
 using lunaticvibes::parser_bms::JudgeDifficulty;
 
@@ -428,3 +431,212 @@ TEST(tBMS, ln)
     EXPECT_TRUE(ExpectNotePosition(*bms, bms::LaneCode::NOTELN2, 0, 4, 4, std::vector<int>{3}));
     EXPECT_TRUE(ExpectNotePosition(*bms, bms::LaneCode::NOTELN2, 0, 5, 4, std::vector<int>{0}));
 }
+
+// Every chart under bms/, the parameterized suites below run on all of them.
+constexpr const char* ALL_CHARTS[] = {
+    "bms/10k.bms", "bms/14k.bme", "bms/5k.bms", "bms/5k_世界.bms", "bms/7k.bme", "bms/9k_mixed_channels.pms",
+    "bms/bar.bms", "bms/bgm32.bms", "bms/bpm.bms", "bms/ln.bme", "bms/rank_hard.bms", "bms/rank_invalid.bms",
+    "bms/rank_veryeasy.bms", "bms/stop.bms",
+};
+
+class tBMSParseMode : public ::testing::TestWithParam<const char*>
+{
+};
+
+TEST_P(tBMSParseMode, MappedMatchesStream)
+{
+    ChartFormatBMS mapped(PathFromUTF8(GetParam()), 0, ChartFormatBMS::ParseMode::Mapped);
+    ChartFormatBMS stream(PathFromUTF8(GetParam()), 0, ChartFormatBMS::ParseMode::Stream);
+    ASSERT_TRUE(mapped.isLoaded());
+    ASSERT_TRUE(stream.isLoaded());
+
+    EXPECT_EQ(mapped.fileHash, stream.fileHash);
+    EXPECT_EQ(mapped.title, stream.title);
+    EXPECT_EQ(mapped.title2, stream.title2);
+    EXPECT_EQ(mapped.artist, stream.artist);
+    EXPECT_EQ(mapped.genre, stream.genre);
+    EXPECT_EQ(mapped.gamemode, stream.gamemode);
+    EXPECT_EQ(mapped.player, stream.player);
+    EXPECT_EQ(mapped.difficulty, stream.difficulty);
+    EXPECT_EQ(mapped.raw_rank, stream.raw_rank);
+    EXPECT_EQ(mapped.total, stream.total);
+    EXPECT_EQ(mapped.notes_total, stream.notes_total);
+    EXPECT_EQ(mapped.notes_key, stream.notes_key);
+    EXPECT_EQ(mapped.notes_scratch, stream.notes_scratch);
+    EXPECT_EQ(mapped.notes_key_ln, stream.notes_key_ln);
+    EXPECT_EQ(mapped.notes_scratch_ln, stream.notes_scratch_ln);
+    EXPECT_EQ(mapped.notes_mine, stream.notes_mine);
+    EXPECT_EQ(mapped.minBPM, stream.minBPM);
+    EXPECT_EQ(mapped.maxBPM, stream.maxBPM);
+    EXPECT_EQ(mapped.wavFiles, stream.wavFiles);
+    EXPECT_EQ(mapped.bgaFiles, stream.bgaFiles);
+    EXPECT_EQ(mapped.metres, stream.metres);
+    ASSERT_EQ(mapped.lastBarIdx, stream.lastBarIdx);
+
+    for (unsigned bar = 0; bar <= mapped.lastBarIdx; ++bar)
+    {
+        for (int code = static_cast<int>(LaneCode::BGM); code <= static_cast<int>(LaneCode::NOTEMINE2); ++code)
+        {
+            for (unsigned ch = 0; ch < 10; ++ch)
+            {
+                const auto& lhs = mapped.getLane(static_cast<LaneCode>(code), ch, bar);
+                const auto& rhs = stream.getLane(static_cast<LaneCode>(code), ch, bar);
+                ASSERT_EQ(lhs.resolution, rhs.resolution) << "code=" << code << " ch=" << ch << " bar=" << bar;
+                ASSERT_EQ(lhs.notes.size(), rhs.notes.size()) << "code=" << code << " ch=" << ch << " bar=" << bar;
+                for (size_t i = 0; i < lhs.notes.size(); ++i)
+                {
+                    EXPECT_EQ(lhs.notes[i].segment, rhs.notes[i].segment);
+                    EXPECT_EQ(lhs.notes[i].value, rhs.notes[i].value);
+                    EXPECT_EQ(lhs.notes[i].flags, rhs.notes[i].flags);
+                }
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllCharts, tBMSParseMode,
+                         ::testing::ValuesIn(ALL_CHARTS));
+
+namespace
+{
+
+// Everything the parser produced, one line per field and per non-empty lane.
+std::string dumpChart(const ChartFormatBMS& bms)
+{
+    std::ostringstream ss;
+    ss << bms.title << '\n'
+       << bms.title2 << '\n'
+       << bms.artist << '\n'
+       << bms.artist2 << '\n'
+       << bms.genre << '\n'
+       << bms.version << '\n';
+    ss << bms.gamemode << ' ' << bms.player << ' ' << bms.playLevel << ' ' << bms.difficulty << ' ' << bms.raw_rank
+       << ' ' << bms.total << '\n';
+    ss << bms.notes_total << ' ' << bms.notes_key << ' ' << bms.notes_scratch << ' ' << bms.notes_key_ln << ' '
+       << bms.notes_scratch_ln << ' ' << bms.notes_mine << '\n';
+    ss << bms.startBPM << ' ' << bms.minBPM << ' ' << bms.maxBPM << '\n';
+    for (const auto& f : bms.wavFiles)
+        ss << f << '|';
+    ss << '\n';
+    for (const auto& f : bms.bgaFiles)
+        ss << f << '|';
+    ss << '\n';
+    for (const auto& m : bms.metres)
+        ss << m.division_level() << "/" << m.multiple_level() << " ";
+    ss << '\n';
+    for (size_t i = 0; i < bms.exBPM.size(); ++i)
+        if (bms.exBPM[i] != 0.0 || bms.stop[i] != 0.0)
+            ss << i << ':' << bms.exBPM[i] << ':' << bms.stop[i] << ' ';
+    ss << '\n' << bms.lastBarIdx << '\n';
+    for (unsigned bar = 0; bar <= bms.lastBarIdx; ++bar)
+    {
+        for (int code = static_cast<int>(LaneCode::BGM); code <= static_cast<int>(LaneCode::NOTEMINE2); ++code)
+        {
+            for (unsigned ch = 0; ch < 10; ++ch)
+            {
+                const auto& lane = bms.getLane(static_cast<LaneCode>(code), ch, bar);
+                if (lane.notes.empty())
+                    continue;
+                ss << bar << ' ' << code << ' ' << ch << ' ' << lane.resolution;
+                for (const auto& n : lane.notes)
+                    ss << ' ' << n.segment << ':' << n.value << ':' << n.flags;
+                ss << '\n';
+            }
+        }
+    }
+    return ss.str();
+}
+
+} // namespace
+
+// bms/dump/ holds dumpChart() of every chart as parsed before charts were memory-mapped, back when lines were read
+// one by one into std::list lanes. The file hash is left out, it depends on the line endings of the checkout.
+class tBMSParseModeBaseline : public ::testing::TestWithParam<const char*>
+{
+};
+
+TEST_P(tBMSParseModeBaseline, MatchesOldParser)
+{
+    const Path path = PathFromUTF8(GetParam());
+    const Path fixturePath = Path("bms/dump") / path.filename().concat(".txt");
+    for (auto mode : {ChartFormatBMS::ParseMode::Mapped, ChartFormatBMS::ParseMode::Stream})
+    {
+        ChartFormatBMS bms(path, 0, mode);
+        ASSERT_TRUE(bms.isLoaded());
+
+        std::ifstream fixture(fixturePath);
+        ASSERT_TRUE(fixture.is_open()) << fixturePath;
+        std::istringstream dump(dumpChart(bms));
+        std::string expected, actual;
+        for (unsigned line = 1; std::getline(fixture, expected); ++line)
+        {
+            ASSERT_TRUE(std::getline(dump, actual)) << "mode=" << static_cast<int>(mode) << " ends at line " << line;
+            ASSERT_EQ(actual, expected) << "mode=" << static_cast<int>(mode) << " " << fixturePath << ":" << line;
+        }
+        EXPECT_FALSE(std::getline(dump, actual)) << "mode=" << static_cast<int>(mode) << " extra line: " << actual;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllCharts, tBMSParseModeBaseline, ::testing::ValuesIn(ALL_CHARTS));
+
+class tBMSMetaScan : public ::testing::TestWithParam<const char*>
+{
+};
+
+TEST_P(tBMSMetaScan, MatchesFullParse)
+{
+    ChartFormatBMS full(PathFromUTF8(GetParam()), 2356);
+    ChartFormatBMSMetaScan scan(PathFromUTF8(GetParam()), 2356);
+    ASSERT_TRUE(full.isLoaded());
+    ASSERT_TRUE(scan.isLoaded());
+
+    EXPECT_EQ(scan.fileHash, full.fileHash);
+    EXPECT_EQ(scan.title, full.title);
+    EXPECT_EQ(scan.title2, full.title2);
+    EXPECT_EQ(scan.gamemode, full.gamemode);
+    EXPECT_EQ(scan.player, full.player);
+    EXPECT_EQ(scan.difficulty, full.difficulty);
+    EXPECT_EQ(scan.lastBarIdx, full.lastBarIdx);
+    EXPECT_EQ(scan.notes_total, full.notes_total);
+    EXPECT_EQ(scan.notes_key, full.notes_key);
+    EXPECT_EQ(scan.notes_scratch, full.notes_scratch);
+    EXPECT_EQ(scan.notes_key_ln, full.notes_key_ln);
+    EXPECT_EQ(scan.notes_scratch_ln, full.notes_scratch_ln);
+    EXPECT_EQ(scan.notes_mine, full.notes_mine);
+    EXPECT_EQ(scan.haveNote, full.haveNote);
+    EXPECT_EQ(scan.haveLN, full.haveLN);
+    EXPECT_EQ(scan.haveMine, full.haveMine);
+    EXPECT_EQ(scan.haveInvisible, full.haveInvisible);
+    EXPECT_EQ(scan.haveMetricMod, full.haveMetricMod);
+    EXPECT_EQ(scan.haveStop, full.haveStop);
+    EXPECT_EQ(scan.haveBPMChange, full.haveBPMChange);
+    EXPECT_EQ(scan.haveBGA, full.haveBGA);
+    EXPECT_EQ(scan.startBPM, full.startBPM);
+    EXPECT_EQ(scan.minBPM, full.minBPM);
+    EXPECT_EQ(scan.maxBPM, full.maxBPM);
+    EXPECT_EQ(scan.metres, full.metres);
+    EXPECT_EQ(scan.totalNotes, static_cast<int>(full.notes_total));
+
+    // SongDB used to store these from the chart object built for playing
+    const ChartObjectBMS chart(0, full);
+    EXPECT_EQ(scan.totalLength, chart.getTotalLength().norm() / 1000);
+    EXPECT_EQ(scan.totalNotes, static_cast<int>(chart.getNoteTotalCount()));
+
+    for (unsigned bar = 0; bar <= scan.lastBarIdx; ++bar)
+    {
+        EXPECT_TRUE(scan.getLane(LaneCode::NOTE1, 1, bar).notes.empty());
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllCharts, tBMSMetaScan,
+                         ::testing::ValuesIn(ALL_CHARTS));
+
+TEST(tBMSMetaScan, TotalLength)
+{
+    // 3 bars at 150 BPM, plus one more for the last measure.
+    EXPECT_EQ(ChartFormatBMSMetaScan("bms/7k.bme").totalLength, 6);
+    // Same, plus 7 beats of stops.
+    EXPECT_EQ(ChartFormatBMSMetaScan("bms/stop.bms").totalLength, 9);
+    // Half of bar 2 is played at BPM 0.1, bar 3 only contains a BPM change.
+    EXPECT_EQ(ChartFormatBMSMetaScan("bms/bpm.bms").totalLength, 1206);
+}
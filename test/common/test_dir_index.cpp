@@ -0,0 +1,67 @@
+#include <gmock/gmock.h>
+
+#include <fstream>
+
+#include <common/dir_index.h>
+#include <common/types.h>
+
+using lunaticvibes::DirectoryIndex;
+
+namespace
+{
+
+class DirectoryIndexTest : public testing::Test
+{
+protected:
+    Path root = fs::temp_directory_path() / "lv_test_dir_index";
+
+    void SetUp() override
+    {
+        fs::remove_all(root);
+        fs::create_directories(root / "Wav");
+        for (const char* f : {"Kick.WAV", "snare.ogg", "bga.JPG", "Wav/Hat.flac"})
+            std::ofstream{root / f} << "x";
+    }
+    void TearDown() override { fs::remove_all(root); }
+};
+
+} // namespace
+
+TEST_F(DirectoryIndexTest, ResolvesCaseInsensitively)
+{
+    DirectoryIndex index(root);
+    EXPECT_EQ(index.resolve("kick.wav"), root / "Kick.WAV");
+    EXPECT_EQ(index.resolve("KICK.wav"), root / "Kick.WAV");
+    EXPECT_EQ(index.resolve("wav\\hat.FLAC"), root / "Wav/Hat.flac");
+    EXPECT_EQ(index.resolve("./WAV/hat.flac"), root / "Wav/Hat.flac");
+    EXPECT_EQ(index.resolve("missing.wav"), Path{});
+    EXPECT_EQ(index.resolve("nodir/kick.wav"), Path{});
+    EXPECT_EQ(index.resolve(""), Path{});
+    EXPECT_EQ(index.resolve("wav"), Path{}); // directories are not files
+    EXPECT_EQ(index.directoriesListed(), 2u);
+}
+
+TEST_F(DirectoryIndexTest, FallbackExtensions)
+{
+    static constexpr std::string_view wav[]{".wav", ".ogg", ".flac"};
+    static constexpr std::string_view bmp[]{".jpg", ".png"};
+
+    DirectoryIndex index(root);
+    EXPECT_EQ(index.resolve("snare.wav", wav), root / "snare.ogg");
+    EXPECT_EQ(index.resolve("kick.ogg", wav), root / "Kick.WAV");
+    EXPECT_EQ(index.resolve("wav/hat.wav", wav), root / "Wav/Hat.flac");
+    EXPECT_EQ(index.resolve("BGA.bmp", bmp), root / "bga.JPG");
+    EXPECT_EQ(index.resolve("BGA.bmp"), Path{});
+    EXPECT_EQ(index.resolve("tom.wav", wav), Path{});
+}
+
+TEST_F(DirectoryIndexTest, ListsOnlyOnce)
+{
+    DirectoryIndex index(root);
+    EXPECT_EQ(index.resolve("kick.wav"), root / "Kick.WAV");
+
+    // later changes are not seen, the listing is taken once
+    std::ofstream{root / "late.wav"} << "x";
+    EXPECT_EQ(index.resolve("late.wav"), Path{});
+    EXPECT_EQ(DirectoryIndex(root).resolve("late.wav"), root / "late.wav");
+}
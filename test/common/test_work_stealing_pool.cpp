@@ -0,0 +1,75 @@
+#include "common/work_stealing_pool.h"
+#include "gmock/gmock.h"
+
+#include <atomic>
+
+using lunaticvibes::WorkStealingPool;
+
+TEST(WorkStealingPool, ZeroThreadsRunsOnOne)
+{
+    WorkStealingPool pool("test", 0);
+    EXPECT_EQ(pool.threadCount(), 1u);
+
+    std::atomic<int> count = 0;
+    pool.post([&] { ++count; });
+    pool.wait();
+    EXPECT_EQ(count, 1);
+}
+
+TEST(WorkStealingPool, RecursivePosts)
+{
+    WorkStealingPool pool("test", 4);
+
+    // a tree of depth 6 with 4 children per node, like nested folders
+    std::atomic<int> count = 0;
+    std::function<void(int)> walk = [&](int depth) {
+        ++count;
+        if (depth == 0)
+            return;
+        for (int i = 0; i < 4; ++i)
+            pool.post([&walk, depth] { walk(depth - 1); });
+    };
+    pool.post([&] { walk(6); });
+    pool.wait();
+    EXPECT_EQ(count, (1 + 4 + 16 + 64 + 256 + 1024 + 4096));
+
+    // reusable after wait
+    pool.post([&] { ++count; });
+    pool.wait();
+    EXPECT_EQ(count, (1 + 4 + 16 + 64 + 256 + 1024 + 4096) + 1);
+}
+
+TEST(WorkStealingPool, TaskExceptionDoesNotStopPool)
+{
+    WorkStealingPool pool("test", 2);
+    std::atomic<int> count = 0;
+    pool.post([] { throw std::runtime_error("test"); });
+    for (int i = 0; i < 10; ++i)
+        pool.post([&] { ++count; });
+    pool.wait();
+    EXPECT_EQ(count, 10);
+}
+
+TEST(WorkStealingPool, CancelDropsPendingTasks)
+{
+    WorkStealingPool pool("test", 1);
+
+    std::mutex gate;
+    std::unique_lock blocked(gate);
+    std::atomic<bool> started = false;
+    std::atomic<int> count = 0;
+    pool.post([&] {
+        started = true;
+        std::unique_lock l(gate);
+    });
+    while (!started)
+        std::this_thread::yield();
+
+    // the only worker is blocked, nothing below can start
+    for (int i = 0; i < 100; ++i)
+        pool.post([&] { ++count; });
+    EXPECT_EQ(pool.cancel(), 100);
+    blocked.unlock();
+    pool.wait();
+    EXPECT_EQ(count, 0);
+}
@@ -35,3 +35,89 @@ TEST(DbConn, MigrationSystemWorks)
     };
     TestSQLite{}.runTest();
 }
+
+TEST(DbConn, TypedRows)
+{
+    struct TestSQLite : public SQLite
+    {
+        TestSQLite() : SQLite(IN_MEMORY_DB_PATH, "TypedRows") {};
+        void runTest()
+        {
+            ASSERT_EQ(exec("CREATE TABLE t(id INTEGER, name TEXT, rate REAL, md5 TEXT);"), SQLITE_OK);
+            ASSERT_EQ(exec("INSERT INTO t VALUES (?,?,?,?);", {1, "one", 0.5, md5("1").hexdigest()}), SQLITE_OK);
+            ASSERT_EQ(exec("INSERT INTO t VALUES (?,?,?,?);", {2, nullptr, nullptr, nullptr}), SQLITE_OK);
+
+            std::vector<std::tuple<int, std::optional<std::string>, double, HashMD5>> rows;
+            int count = queryAs<int, std::optional<std::string>, double, HashMD5>(
+                "SELECT id,name,rate,md5 FROM t WHERE id>=? ORDER BY id", {1},
+                [&](int id, std::optional<std::string>& name, double rate, HashMD5& hash) {
+                    rows.emplace_back(id, name, rate, hash);
+                });
+            ASSERT_EQ(count, 2);
+            ASSERT_EQ(rows.size(), 2);
+            EXPECT_EQ(std::get<0>(rows[0]), 1);
+            EXPECT_EQ(std::get<1>(rows[0]), "one");
+            EXPECT_EQ(std::get<2>(rows[0]), 0.5);
+            EXPECT_EQ(std::get<3>(rows[0]), md5("1"));
+            EXPECT_EQ(std::get<0>(rows[1]), 2);
+            EXPECT_FALSE(std::get<1>(rows[1]).has_value());
+            EXPECT_EQ(std::get<2>(rows[1]), 0.0);
+            EXPECT_TRUE(std::get<3>(rows[1]).empty());
+
+            std::string names;
+            count = queryEach("SELECT name FROM t", {}, [&](const SQLiteRow& row) {
+                EXPECT_EQ(row.columnCount(), 1);
+                names += row.getText(0);
+                names += row.isNull(0) ? "-" : "+";
+            });
+            EXPECT_EQ(count, 2);
+            EXPECT_EQ(names, "one+-");
+
+            EXPECT_EQ(queryEach("SELECT * FROM missing_table", {}, [](const SQLiteRow&) {}), -1);
+        }
+    };
+    TestSQLite{}.runTest();
+}
+
+TEST(DbConn, StatementCache)
+{
+    struct TestSQLite : public SQLite
+    {
+        TestSQLite() : SQLite(IN_MEMORY_DB_PATH, "StatementCache") {};
+        void runTest()
+        {
+            ASSERT_EQ(exec("CREATE TABLE t(id INTEGER);"), SQLITE_OK);
+            for (int i = 0; i < 3; ++i)
+                ASSERT_EQ(exec("INSERT INTO t(id) VALUES (?);", {i}), SQLITE_OK);
+
+            const auto before = getStatementCacheStats();
+            for (int i = 0; i < 3; ++i)
+            {
+                auto res = query("SELECT id FROM t WHERE id=?;", {i});
+                ASSERT_EQ(res.size(), 1);
+                EXPECT_EQ(ANY_INT(res[0][0]), i);
+            }
+            auto stats = getStatementCacheStats();
+            EXPECT_EQ(stats.misses - before.misses, 1);
+            EXPECT_EQ(stats.hits - before.hits, 2);
+
+            // the same statement used while it is stepping gets its own copy
+            int inner = 0;
+            queryEach("SELECT id FROM t ORDER BY id;", {}, [&](const SQLiteRow&) {
+                queryEach("SELECT id FROM t ORDER BY id;", {}, [&](const SQLiteRow&) { ++inner; });
+            });
+            EXPECT_EQ(inner, 9);
+
+            setStatementCacheCapacity(1);
+            EXPECT_EQ(getStatementCacheStats().size, 1);
+            setStatementCacheCapacity(0);
+            EXPECT_EQ(getStatementCacheStats().size, 0);
+            const auto uncached = getStatementCacheStats();
+            EXPECT_EQ(query("SELECT id FROM t WHERE id=?;", {0}).size(), 1);
+            EXPECT_EQ(query("SELECT id FROM t WHERE id=?;", {0}).size(), 1);
+            EXPECT_EQ(getStatementCacheStats().misses - uncached.misses, 2);
+            EXPECT_EQ(getStatementCacheStats().size, 0);
+        }
+    };
+    TestSQLite{}.runTest();
+}
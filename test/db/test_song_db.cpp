@@ -1,8 +1,12 @@
 #include "common/hash.h"
+#include "common/utils.h"
 #include <gmock/gmock.h>
 
+#include <common/work_stealing_pool.h>
 #include <db/db_song.h>
 
+#include <future>
+
 static constexpr auto&& IN_MEMORY_DB_PATH = ":memory:";
 
 TEST(SongDb, SongInserting)
@@ -33,3 +37,155 @@ TEST(SongDb, SongInserting)
         EXPECT_EQ(chart->fileName, "10k.bms");
     }
 }
+
+TEST(SongDb, RefreshOnlyChangedFiles)
+{
+    const Path folder = fs::temp_directory_path() / "lunaticvibes_test_song_db_refresh";
+    fs::remove_all(folder);
+    fs::create_directories(folder);
+    fs::copy_file("bms/5k.bms", folder / "a.bms");
+    fs::copy_file("bms/7k.bme", folder / "b.bme");
+
+    SongDB song_db{IN_MEMORY_DB_PATH};
+    song_db.addSubFolder(folder);
+    song_db.waitLoadingFinish();
+    EXPECT_EQ(song_db.addChartSuccess, 2);
+
+    // Folder entries did not change, nothing is checked.
+    song_db.resetAddSummary();
+    song_db.addSubFolder(folder);
+    song_db.waitLoadingFinish();
+    EXPECT_EQ(song_db.addChartTaskCount, 0);
+
+    // Only the replaced chart is parsed again.
+    fs::copy_file("bms/stop.bms", folder / "a.bms", fs::copy_options::overwrite_existing);
+    fs::last_write_time(folder, fs::last_write_time(folder) + std::chrono::seconds(10));
+    song_db.resetAddSummary();
+    song_db.addSubFolder(folder);
+    song_db.waitLoadingFinish();
+    EXPECT_EQ(song_db.addChartTaskCount, 1);
+    EXPECT_EQ(song_db.addChartModified, 1);
+    EXPECT_EQ(song_db.addChartSuccess, 1);
+
+    song_db.prepareCache();
+    const auto charts = song_db.findChartByHash(md5file(folder / "a.bms"), false);
+    ASSERT_EQ(charts.size(), 1);
+    EXPECT_EQ(charts[0]->fileName, "a.bms");
+
+    fs::remove_all(folder);
+}
+
+TEST(SongDb, CancelledScanContinuesNextTime)
+{
+    const Path folder = fs::temp_directory_path() / "lunaticvibes_test_song_db_cancel";
+    fs::remove_all(folder);
+    fs::create_directories(folder / "songs" / "a");
+    fs::create_directories(folder / "songs" / "b");
+    fs::copy_file("bms/5k.bms", folder / "songs" / "a" / "a.bms");
+    fs::copy_file("bms/7k.bme", folder / "songs" / "b" / "b.bme");
+    const Path dbPath = folder / "song.db";
+
+    // Loading stops while the tasks for the sub folders are still queued.
+    {
+        struct mock_SongDB : public SongDB
+        {
+            using SongDB::getThreadPool;
+            using SongDB::SongDB;
+        };
+        mock_SongDB song_db{dbPath};
+        song_db.setThreadCount(1);
+        std::promise<void> release;
+        song_db.getThreadPool().post([f = release.get_future().share()] { f.wait(); });
+        song_db.addSubFolder(folder / "songs");
+        song_db.stopLoading();
+        release.set_value();
+        song_db.waitLoadingFinish();
+        EXPECT_EQ(song_db.addChartSuccess, 0);
+    }
+
+    SongDB song_db{dbPath};
+    song_db.addSubFolder(folder / "songs");
+    song_db.waitLoadingFinish();
+    EXPECT_EQ(song_db.addChartSuccess, 2);
+    song_db.prepareCache();
+    EXPECT_EQ(song_db.findChartByHash(md5file(folder / "songs" / "a" / "a.bms"), false).size(), 1);
+    EXPECT_EQ(song_db.findChartByHash(md5file(folder / "songs" / "b" / "b.bme"), false).size(), 1);
+
+    // Finished this time, nothing is checked again.
+    song_db.resetAddSummary();
+    song_db.addSubFolder(folder / "songs");
+    song_db.waitLoadingFinish();
+    EXPECT_EQ(song_db.addChartTaskCount, 0);
+
+    fs::remove_all(folder);
+}
+
+TEST(SongDb, SearchByName)
+{
+    const Path folder = fs::temp_directory_path() / "lunaticvibes_test_song_db_search";
+    fs::remove_all(folder);
+    fs::create_directories(folder);
+    fs::copy_file("bms/5k.bms", folder / "a.bms");
+    fs::copy_file(Path{u8"bms/5k_世界.bms"}, folder / "b.bms");
+
+    SongDB song_db{IN_MEMORY_DB_PATH};
+    song_db.addSubFolder(folder);
+    song_db.waitLoadingFinish();
+    ASSERT_EQ(song_db.addChartSuccess, 2);
+    const HashMD5 folderHash = song_db.getFolderHash(folder);
+
+    // Index lookup, case insensitive.
+    EXPECT_EQ(song_db.findChartByName(ROOT_FOLDER_HASH, "TiTl").size(), 1);
+    EXPECT_EQ(song_db.findChartByName(folderHash, "itl").size(), 1);
+    EXPECT_EQ(song_db.findChartByName(md5("somewhere else"), "itl").size(), 0);
+    EXPECT_EQ(song_db.findChartByName(ROOT_FOLDER_HASH, "ワールド").size(), 1);
+    EXPECT_EQ(song_db.findChartByName(ROOT_FOLDER_HASH, "\"ワールド").size(), 0);
+    // Too short for the index.
+    EXPECT_EQ(song_db.findChartByName(ROOT_FOLDER_HASH, "ワー").size(), 1);
+    EXPECT_EQ(song_db.findChartByName(ROOT_FOLDER_HASH, "ti").size(), 1);
+
+    // Removed charts are removed from the index.
+    fs::remove(folder / "b.bms");
+    fs::last_write_time(folder, fs::last_write_time(folder) + std::chrono::seconds(10));
+    song_db.addSubFolder(folder);
+    song_db.waitLoadingFinish();
+    EXPECT_EQ(song_db.findChartByName(ROOT_FOLDER_HASH, "ワールド").size(), 0);
+    EXPECT_EQ(song_db.findChartByName(ROOT_FOLDER_HASH, "title").size(), 1);
+
+    fs::remove_all(folder);
+}
+
+TEST(SongDb, SearchWithoutIndex)
+{
+    const Path folder = fs::temp_directory_path() / "lunaticvibes_test_song_db_no_index";
+    fs::remove_all(folder);
+    fs::create_directories(folder / "charts");
+    fs::copy_file("bms/5k.bms", folder / "charts" / "a.bms");
+    fs::copy_file(Path{u8"bms/5k_世界.bms"}, folder / "charts" / "b.bms");
+    const Path dbPath = folder / "song.db";
+
+    // A table in the way of the search index makes the migration fail.
+    {
+        struct BlockingSQLite : public SQLite
+        {
+            BlockingSQLite(const Path& path) : SQLite(path, "SearchWithoutIndex")
+            {
+                EXPECT_EQ(exec("CREATE TABLE song_fts(id INTEGER);"), SQLITE_OK);
+            }
+        };
+        BlockingSQLite db{dbPath};
+    }
+
+    {
+        SongDB song_db{dbPath};
+        song_db.addSubFolder(folder / "charts");
+        song_db.waitLoadingFinish();
+        ASSERT_EQ(song_db.addChartSuccess, 2);
+
+        EXPECT_EQ(song_db.findChartByName(ROOT_FOLDER_HASH, "TiTl").size(), 1);
+        EXPECT_EQ(song_db.findChartByName(ROOT_FOLDER_HASH, "ワールド").size(), 1);
+        EXPECT_EQ(song_db.findChartByName(ROOT_FOLDER_HASH, "ti").size(), 1);
+    }
+
+    fs::remove_all(folder);
+}
@@ -88,6 +88,171 @@ TEST(Rect, add_normal)
     EXPECT_EQ(res, Rect(0, 0, 80, 120));
 }
 
+namespace
+{
+
+// In-memory BMP, bottom-up rows. 8-bit images take a BGRA palette, 32-bit pixels keep their alpha byte.
+std::vector<uint8_t> makeBmp(int w, int h, int bpp, const std::vector<uint32_t>& palette,
+                             const std::vector<uint32_t>& pixels)
+{
+    const int stride = (w * bpp / 8 + 3) & ~3;
+    const uint32_t offset = 54 + static_cast<uint32_t>(palette.size()) * 4;
+    std::vector<uint8_t> out;
+    auto put = [&out](uint32_t v, int bytes) {
+        for (int i = 0; i < bytes; ++i)
+            out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+    };
+    out.push_back('B');
+    out.push_back('M');
+    put(offset + stride * h, 4);
+    put(0, 4);
+    put(offset, 4);
+    put(40, 4);
+    put(w, 4);
+    put(h, 4);
+    put(1, 2);
+    put(bpp, 2);
+    put(0, 4); // BI_RGB
+    put(stride * h, 4);
+    put(0, 4);
+    put(0, 4);
+    put(static_cast<uint32_t>(palette.size()), 4);
+    put(0, 4);
+    for (uint32_t c : palette)
+        put(c, 4);
+    for (int y = h - 1; y >= 0; --y)
+    {
+        const size_t rowStart = out.size();
+        for (int x = 0; x < w; ++x)
+            put(pixels[y * w + x], bpp / 8);
+        out.resize(rowStart + stride);
+    }
+    return out;
+}
+
+void expectSameAsSetTransparentColor(std::vector<uint8_t> bmp, Color key)
+{
+    Image source("bmp", bmp.data(), bmp.size());
+    ASSERT_TRUE(source.isLoaded());
+    const auto before = source.getARGB();
+
+    Image copy = source.withTransparentColorRGB(key);
+    Image expected("bmp", bmp.data(), bmp.size());
+    expected.setTransparentColorRGB(key);
+
+    EXPECT_EQ(copy.getARGB(), expected.getARGB());
+    EXPECT_EQ(source.getARGB(), before);
+}
+
+} // namespace
+
+TEST(Image, transparentColorPalettized)
+{
+    // black, red, green, blue
+    const std::vector<uint32_t> palette{0x00000000, 0x00FF0000, 0x0000FF00, 0x000000FF};
+    expectSameAsSetTransparentColor(makeBmp(4, 2, 8, palette, {0, 1, 2, 3, 1, 1, 3, 0}), Color(0xFF0000FF));
+}
+
+TEST(Image, transparentColorTruecolor)
+{
+    expectSameAsSetTransparentColor(
+        makeBmp(4, 2, 24, {}, {0x000000, 0xFF0000, 0x00FF00, 0x0000FF, 0xFF0000, 0xFF0000, 0xFE0000, 0xFFFFFF}),
+        Color(0xFF0000FF));
+}
+
+TEST(Image, transparentColorWithAlpha)
+{
+    expectSameAsSetTransparentColor(makeBmp(4, 2, 32, {},
+                                            {0xFF000000, 0x80FF0000, 0xFF00FF00, 0x400000FF, 0xFFFF0000, 0x01FF0000,
+                                             0xFFFE0000, 0x00FFFFFF}),
+                                    Color(0xFF0000FF));
+}
+
+// No font file is opened, only the atlas bookkeeping is used.
+class mock_TTFFont : public TTFFont
+{
+public:
+    mock_TTFFont() : TTFFont(Path{}, 12) { loaded = true; }
+
+    using TTFFont::_atlasPages;
+    using TTFFont::ATLAS_MAX_PAGES;
+    using TTFFont::ATLAS_PAGE_SIZE;
+    using TTFFont::placeAtlasGlyph;
+};
+
+TEST(TTFFont, atlasShelfPacking)
+{
+    mock_TTFFont font;
+    EXPECT_EQ(font.placeAtlasGlyph(10, 20)->rect, Rect(0, 0, 10, 20));
+    EXPECT_EQ(font.placeAtlasGlyph(10, 30)->rect, Rect(11, 0, 10, 30));
+
+    // starts a shelf below the tallest glyph
+    const auto placement = font.placeAtlasGlyph(mock_TTFFont::ATLAS_PAGE_SIZE - 5, 10);
+    ASSERT_TRUE(placement.has_value());
+    EXPECT_EQ(placement->page, 0u);
+    EXPECT_EQ(placement->rect, Rect(0, 31, mock_TTFFont::ATLAS_PAGE_SIZE - 5, 10));
+}
+
+TEST(TTFFont, atlasKeptWhenFull)
+{
+    // 15 rows of 15 glyphs per page, with the padding between them
+    constexpr int GLYPH_SIZE = 64;
+    constexpr size_t GLYPHS_PER_PAGE = 15 * 15;
+    mock_TTFFont font;
+    const unsigned generation = font.getAtlasGeneration();
+
+    size_t placed = 0;
+    for (size_t i = 0; i < GLYPHS_PER_PAGE * mock_TTFFont::ATLAS_MAX_PAGES + 100; ++i)
+    {
+        const auto placement = font.placeAtlasGlyph(GLYPH_SIZE, GLYPH_SIZE);
+        if (!placement)
+            continue;
+        EXPECT_EQ(placement->page, placed / GLYPHS_PER_PAGE);
+        ++placed;
+    }
+    EXPECT_EQ(placed, GLYPHS_PER_PAGE * mock_TTFFont::ATLAS_MAX_PAGES);
+
+    // glyphs already placed stay valid, the rest is drawn from composed text
+    EXPECT_EQ(font._atlasPages.size(), mock_TTFFont::ATLAS_MAX_PAGES);
+    EXPECT_EQ(font.getAtlasGeneration(), generation);
+}
+
+TEST(TTFFont, outlineChangeInvalidatesLayout)
+{
+    mock_TTFFont font;
+    unsigned generation = font.getAtlasGeneration();
+
+    font.setOutline(2, Color(0xFF0000FF));
+    EXPECT_NE(font.getAtlasGeneration(), generation);
+    generation = font.getAtlasGeneration();
+
+    font.setOutline(2, Color(0xFF0000FF));
+    EXPECT_EQ(font.getAtlasGeneration(), generation);
+
+    font.setOutline(2, Color(0x0000FFFF));
+    EXPECT_NE(font.getAtlasGeneration(), generation);
+    generation = font.getAtlasGeneration();
+
+    font.setOutline(0, Color(0x0000FFFF));
+    EXPECT_NE(font.getAtlasGeneration(), generation);
+}
+
+class mock_SpriteText : public SpriteText
+{
+public:
+    using SpriteText::needsComposedText;
+};
+
+TEST(SpriteText, composedWhenQuadsBlendDifferently)
+{
+    EXPECT_FALSE(mock_SpriteText::needsComposedText(false, BlendMode::ADD, Color(0xFFFFFF80)));
+    EXPECT_FALSE(mock_SpriteText::needsComposedText(true, BlendMode::ALPHA, Color(0x00FF00FF)));
+    EXPECT_TRUE(mock_SpriteText::needsComposedText(true, BlendMode::ALPHA, Color(0xFFFFFF80)));
+    EXPECT_TRUE(mock_SpriteText::needsComposedText(true, BlendMode::ADD, Color(0xFFFFFFFF)));
+    EXPECT_TRUE(mock_SpriteText::needsComposedText(true, BlendMode::NONE, Color(0xFFFFFFFF)));
+    EXPECT_TRUE(mock_SpriteText::needsComposedText(true, BlendMode::MOD, Color(0xFFFFFFFF)));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Render interface
 
@@ -99,6 +264,7 @@ public:
     MOCK_CONST_METHOD0(draw, void());
     FRIEND_TEST(test_SpriteBase, rectConstruct);
     FRIEND_TEST(test_SpriteBase, func_update);
+    FRIEND_TEST(test_SpriteBase, func_update_sections);
 };
 
 class test_SpriteBase : public ::testing::Test
@@ -189,6 +355,32 @@ TEST_F(test_SpriteBase, func_update)
     ASSERT_EQ(ss1_2._current.color, Color(253, 253, 253, 253));
     ASSERT_EQ(ss1_2._current.angle, 0);
 }
+
+TEST_F(test_SpriteBase, func_update_sections)
+{
+    mock_SpriteBase s{builder};
+    s.setMotionStartTimer(IndexTimer::K11_BOMB);
+    for (auto [time, x] : {std::pair{0, 0}, {100, 100}, {200, 100}, {300, 400}})
+        s.appendMotionKeyFrame(
+            {time, {Rect(x, 0, 0, 0), MotionKeyFrameParams::CONSTANT, Color(0xFFFFFFFF), BlendMode::ALPHA, 0, 0}});
+    s.setMotionLoopTo(-1);
+
+    State::set(IndexTimer::K11_BOMB, 0);
+    // forward, backward and jumping over sections
+    for (auto [time, x] : {std::pair{50, 50}, {150, 100}, {250, 250}, {120, 100}, {299, 397}, {0, 0}, {100, 100}})
+    {
+        s.update(lunaticvibes::Time(time));
+        ASSERT_TRUE(s._draw);
+        EXPECT_EQ(s._current.rect.x, x) << "time " << time;
+    }
+
+    // prefetched start timer is used once
+    s.setMotionStartTime(100);
+    s.update(lunaticvibes::Time(150));
+    EXPECT_EQ(s._current.rect.x, 50);
+    s.update(lunaticvibes::Time(150));
+    EXPECT_EQ(s._current.rect.x, 100);
+}
 #pragma endregion
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1,12 +1,21 @@
+#include "game/runtime/state.h"
 #include "game/skin/skin_lr2.h"
+#include "game/skin/skin_lr2_cache.h"
 #include "gmock/gmock.h"
 
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include <common/str_utils.h>
 
+#include "../temp_dir.h"
+
 class mock_SkinLR2 : public SkinLR2
 {
 public:
@@ -18,7 +27,28 @@ public:
     ~mock_SkinLR2() override = default;
 
     const std::vector<element>& getDrawQueue() { return drawQueue; }
+    bool isLoadedFromCSVCache() const { return loadedFromCSVCache; }
+};
+
+namespace
+{
+
+// Every skin loaded here writes its CSV cache, keep those out of gamedata.
+class CSVCacheEnvironment : public ::testing::Environment
+{
+    std::unique_ptr<TempDir> folder;
+
+public:
+    void SetUp() override
+    {
+        folder = std::make_unique<TempDir>("skin_cache");
+        lunaticvibes::SkinLR2CSVCache::setCacheFolder(folder->path());
+    }
+    void TearDown() override { folder.reset(); }
 };
+const auto* const csvCacheEnvironment = ::testing::AddGlobalTestEnvironment(new CSVCacheEnvironment);
+
+} // namespace
 
 TEST(tLR2Skin, IF1)
 {
@@ -119,3 +149,135 @@ TEST(tLR2Skin, CustomFile)
         EXPECT_EQ(lunaticvibes::join(',', opt.entries), "1,2,RANDOM");
     }
 }
+
+TEST(tLR2Skin, DstOptConditionMatchesGetDstOpt)
+{
+    DstOptBits bits{};
+    auto setBit = [&bits](size_t idx) { bits[idx / 64] |= uint64_t{1} << (idx % 64); };
+    setBit(0);
+    setBit(2);
+    setBit(65);
+    setBit(1401);
+
+    using V = std::vector<dst_option>;
+    EXPECT_TRUE(DstOptCondition::compile(V{}).eval(bits));
+    EXPECT_TRUE(DstOptCondition::compile(V{dst_option(2), dst_option(65), dst_option(1401)}).eval(bits));
+    EXPECT_TRUE(DstOptCondition::compile(V{dst_option(2), dst_option(-3), dst_option(-9999)}).eval(bits));
+    EXPECT_FALSE(DstOptCondition::compile(V{dst_option(2), dst_option(-65)}).eval(bits));
+    EXPECT_FALSE(DstOptCondition::compile(V{dst_option(3)}).eval(bits));
+    EXPECT_FALSE(DstOptCondition::compile(V{DST_FALSE}).eval(bits));
+    EXPECT_FALSE(DstOptCondition::compile(V{dst_option(3000)}).eval(bits));
+
+    DstOptBits changed{};
+    changed[1] = uint64_t{1} << 1; // option 65
+    EXPECT_TRUE(DstOptCondition::compile(V{dst_option(-65)}).affectedBy(changed));
+    EXPECT_FALSE(DstOptCondition::compile(V{dst_option(64)}).affectedBy(changed)); // same word, other bit
+    EXPECT_FALSE(DstOptCondition::compile(V{dst_option(2)}).affectedBy(changed));
+}
+
+TEST(tLR2Skin, CSVCacheReplaysSameBody)
+{
+    // the first load writes the cache if an earlier test has not already
+    mock_SkinLR2 parsed{"lr2skin/if2.lr2skin"};
+    ASSERT_EQ(parsed.isLoaded(), true);
+    mock_SkinLR2 cached{"lr2skin/if2.lr2skin"};
+    ASSERT_EQ(cached.isLoaded(), true);
+    EXPECT_TRUE(cached.isLoadedFromCSVCache());
+
+    ASSERT_EQ(cached.getDrawQueue().size(), parsed.getDrawQueue().size());
+    for (size_t i = 0; i < cached.getDrawQueue().size(); ++i)
+        EXPECT_EQ(cached.getDrawQueue()[i].dstOpt, parsed.getDrawQueue()[i].dstOpt);
+}
+
+TEST(tLR2Skin, CSVCacheInvalidatedByEdit)
+{
+    const TempDir dir{"csvcache"};
+    const Path path = dir / "csvcache.lr2skin";
+    std::filesystem::copy_file("lr2skin/if1.lr2skin", path);
+    {
+        mock_SkinLR2 s{path};
+        ASSERT_EQ(s.isLoaded(), true);
+    }
+    {
+        mock_SkinLR2 s{path};
+        EXPECT_TRUE(s.isLoadedFromCSVCache());
+    }
+
+    std::ofstream(path, std::ios::app) << "\n#SRC_IMAGE,0,0,1237,431,14,13,1,1,0,0,0,0,0,,,,,,,,\n"
+                                          "#DST_IMAGE,0,300,348,315,14,13,0,0,255,255,255,1,0,0,0,600,0,0,0,0\n";
+    {
+        mock_SkinLR2 s{path};
+        ASSERT_EQ(s.isLoaded(), true);
+        EXPECT_FALSE(s.isLoadedFromCSVCache());
+        EXPECT_EQ(s.getDrawQueue().size(), 2);
+    }
+}
+
+TEST(tLR2Skin, CSVCacheHashesOnlyTouchedFiles)
+{
+    const TempDir dir{"csvcache"};
+    const Path path = dir / "include.csv";
+    std::ofstream(path) << "#IMAGE,a.png\n";
+
+    lunaticvibes::SkinLR2CSVCache cache;
+    cache.addFile(path, "#IMAGE,a.png\n");
+    EXPECT_TRUE(cache.filesUnchanged());
+
+    // a wrong digest goes unnoticed while size and write time match
+    const std::string digest = cache.files[0].md5;
+    cache.files[0].md5 = "0123456789abcdef0123456789abcdef";
+    EXPECT_TRUE(cache.filesUnchanged());
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(1));
+    EXPECT_FALSE(cache.filesUnchanged());
+
+    // touched but not edited
+    cache.files[0].md5 = digest;
+    EXPECT_TRUE(cache.filesUnchanged());
+
+    // edited, same size
+    std::ofstream(path) << "#IMAGE,b.png\n";
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(2));
+    EXPECT_FALSE(cache.filesUnchanged());
+}
+
+TEST(tLR2Skin, FlipResultSurvivesPreloadedPlaySkin)
+{
+    // The play skin is built in the background while select is shown, before decide resets the flags.
+    const TempDir dir{"flipresult"};
+    const auto writeSkin = [&dir](const char* name, int type, const char* extra) {
+        const auto path = dir / name;
+        std::ofstream(path) << "#INFORMATION," << type << ",testskin,testcreator\n" << extra << "#ENDOFHEADER\n";
+        return path;
+    };
+    const auto selectPath = writeSkin("select.lr2skin", 5, "");
+    const auto decidePath = writeSkin("decide.lr2skin", 6, "");
+    const auto playPath = writeSkin("play.lr2skin", 0, "#FLIPRESULT\n");
+    const auto resultPath = writeSkin("result.lr2skin", 7, "");
+
+    mock_SkinLR2 select{selectPath};
+    ASSERT_TRUE(select.isLoaded());
+    EXPECT_FALSE(State::get(IndexSwitch::FLIP_RESULT));
+
+    State::set(IndexSwitch::FLIP_RESULT, true);
+    std::unique_ptr<mock_SkinLR2> play;
+    std::thread([&] { play = std::make_unique<mock_SkinLR2>(playPath); }).join();
+    ASSERT_TRUE(play && play->isLoaded());
+    EXPECT_TRUE(State::get(IndexSwitch::FLIP_RESULT)) << "switch written by a background build";
+    State::set(IndexSwitch::FLIP_RESULT, false);
+
+    mock_SkinLR2 decide{decidePath};
+    ASSERT_TRUE(decide.isLoaded());
+    EXPECT_FALSE(State::get(IndexSwitch::FLIP_RESULT));
+
+    EXPECT_TRUE(play->activate());
+    EXPECT_FALSE(State::get(IndexSwitch::FLIP_RESULT));
+
+    mock_SkinLR2 result{resultPath};
+    ASSERT_TRUE(result.isLoaded());
+    EXPECT_TRUE(State::get(IndexSwitch::FLIP_RESULT));
+
+    // the next decide screen starts over
+    mock_SkinLR2 decide2{decidePath};
+    mock_SkinLR2 result2{resultPath};
+    EXPECT_FALSE(State::get(IndexSwitch::FLIP_RESULT));
+}
@@ -1,11 +1,21 @@
 #include <gmock/gmock.h>
 
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "common/chartformat/chartformat_bms.h"
 #include "game/replay/replay_chart.h"
 #include "game/ruleset/ruleset.h"
 #include "game/ruleset/ruleset_bms_replay.h"
+#include "game/scene/scene_context.h"
+
+#include "../temp_dir.h"
 
 TEST(RulesetBmsReplay, SkipToEndWorks)
 {
@@ -37,3 +47,176 @@ TEST(RulesetBmsReplay, SkipToEndWorks)
     EXPECT_EQ(data.comboDisplay, 0);
     EXPECT_EQ(data.maxComboDisplay, 3);
 }
+
+namespace
+{
+
+struct Key
+{
+    long long press, release; // ms
+    Input::Pad pad;
+};
+
+struct LaneSkipResult
+{
+    std::vector<unsigned> judges; // by JudgeIndex
+    unsigned exScore;
+    std::vector<std::pair<long long, ReplayChart::Commands::Type>> commands;
+};
+
+// Plays a chart with every kind of lane update() may skip, one tick per ms like the play loop.
+LaneSkipResult playLaneSkipChart(const std::vector<Key>& keys, bool autoScratch)
+{
+    // 120 BPM, a measure is 2000 ms
+    const TempDir dir{"lane_skip"};
+    const Path path = dir / "lane_skip.bme";
+    {
+        std::ofstream f{path};
+        f << "#PLAYER 1\n#BPM 120\n#LNTYPE 1\n"
+             "#00111:01000000\n"                         // K1 2000, missed
+             "#00112:00010000\n"                         // K2 2500
+             "#00253:01000001\n"                         // K3 LN 4000-5500, missed at head + BAD
+             "#00354:01010000000000000000000000000000\n" // K4 LN 6000-6125, missed at the tail before head + BAD
+             "#00455:01000001\n"                         // K5 LN 8000-9500, held
+             "#005D8:01\n"                               // K6 mine 10000, held over
+             "#005D9:0001\n"                             // K7 mine 10500
+             "#00631:01\n"                               // K1 hidden 12000, pressed
+             "#00716:01010000\n"                         // scratch 14000 and 14500
+             "#00756:00000101\n"                         // scratch LN 15000-15500
+             "#00819:01\n";                              // K7 16000
+    }
+    auto bms = std::make_shared<ChartFormatBMS>(path);
+    auto obj = ChartObjectBase::createFromChartFormat(PLAYER_SLOT_PLAYER, bms);
+    PlayModifiers mods;
+    if (autoScratch)
+        mods.assist_mask |= PLAY_MOD_ASSIST_AUTOSCR;
+    auto replayNew = std::make_shared<PlayContextParams::MutexReplayChart>();
+    replayNew->replay = std::make_shared<ReplayChart>();
+    RulesetBMS ruleset(bms, obj, mods, bms->gamemode, RulesetBMS::LR2_DEFAULT_RANK, 1.0, RulesetBMS::PlaySide::SINGLE,
+                       -1, replayNew);
+
+    const long long end = obj->getTotalLength().norm() + 2000;
+    for (long long t = 0; t < end; ++t)
+    {
+        InputMask press, hold, release;
+        for (const Key& k : keys)
+        {
+            press[k.pad] = press[k.pad] || t == k.press;
+            hold[k.pad] = hold[k.pad] || (t >= k.press && t < k.release);
+            release[k.pad] = release[k.pad] || t == k.release;
+        }
+        obj->update(t);
+        if (press.any())
+            ruleset.updatePress(press, t);
+        if (hold.any())
+            ruleset.updateHold(hold, t);
+        if (release.any())
+            ruleset.updateRelease(release, t);
+        ruleset.update(t);
+    }
+
+    LaneSkipResult res;
+    for (int i = 0; i <= RulesetBMS::JUDGE_MINE_POOR; ++i)
+        res.judges.push_back(ruleset.getJudgeCountEx(static_cast<RulesetBMS::JudgeIndex>(i)));
+    res.exScore = ruleset.getExScore();
+    for (const auto& cmd : replayNew->replay->commands)
+        res.commands.emplace_back(cmd.ms, cmd.type);
+    EXPECT_TRUE(ruleset.isFinished());
+    return res;
+}
+
+} // namespace
+
+TEST(RulesetBms, LaneSkipKeepsJudges)
+{
+    const std::vector<Key> keys = {
+        {2510, 2600, Input::K12},   // late PERFECT
+        {8005, 9510, Input::K15},   // LN held to the end
+        {9900, 10100, Input::K16},  // over the mine
+        {12000, 12050, Input::K11}, // hidden note, no judge
+        {16000, 16050, Input::K17}, // exact PERFECT
+    };
+    using Cmd = ReplayChart::Commands::Type;
+    for (const bool autoScratch : {false, true})
+    {
+        SCOPED_TRACE(autoScratch ? "auto scratch" : "scratch judged");
+        const auto res = playLaneSkipChart(keys, autoScratch);
+
+        // K1, K3 and K4 are missed, and without auto scratch the two scratch notes and the scratch LN
+        const unsigned missed = autoScratch ? 3 : 6;
+        // the held key hits the mine on every tick from 18 to 3 ms before it
+        const unsigned mineHits = 16;
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_PERFECT], 3);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_EXACT_PERFECT], 1);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_LATE_PERFECT], 2);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_GREAT], 0);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_GOOD], 0);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_BAD], 0);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_MISS], missed);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_KPOOR], mineHits);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_POOR], missed + mineHits);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_BP], missed + mineHits);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_CB], missed);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_LATE], missed);
+        EXPECT_EQ(res.judges[RulesetBMS::JUDGE_EARLY], 0);
+        EXPECT_EQ(res.exScore, 6);
+
+        std::vector<std::pair<long long, Cmd>> expected = {
+            {2200, Cmd::JUDGE_LEFT_LATE_4}, {2510, Cmd::JUDGE_LEFT_LATE_0}, {4200, Cmd::JUDGE_LEFT_LATE_3},
+            {6125, Cmd::JUDGE_LEFT_LATE_3}, {9482, Cmd::JUDGE_LEFT_LATE_0},
+        };
+        for (unsigned i = 0; i < mineHits; ++i)
+            expected.emplace_back(9982 + i, Cmd::JUDGE_LEFT_LANDMINE);
+        if (!autoScratch)
+        {
+            expected.emplace_back(14200, Cmd::JUDGE_LEFT_LATE_4);
+            expected.emplace_back(14700, Cmd::JUDGE_LEFT_LATE_4);
+            expected.emplace_back(15200, Cmd::JUDGE_LEFT_LATE_3);
+        }
+        expected.emplace_back(16000, Cmd::JUDGE_LEFT_EXACT_0);
+        EXPECT_EQ(res.commands, expected);
+    }
+}
+
+TEST(RulesetBms, DISABLED_DenseDoublePlayUpdateCost)
+{
+    // 16 sixteenths on every lane of both sides, nothing is pressed so every note ends up as MISS.
+    constexpr int MEASURES = 48;
+    const TempDir dir{"dense_14k"};
+    const Path path = dir / "dense_14k.bme";
+    {
+        std::ofstream f{path};
+        f << "#PLAYER 3\n#BPM 180\n";
+        for (int m = 1; m <= MEASURES; ++m)
+            for (const char* ch : {"11", "12", "13", "14", "15", "16", "18", "19", "21", "22", "23", "24", "25", "26",
+                                   "28", "29"})
+            {
+                f << "#" << std::setw(3) << std::setfill('0') << m << ch << ":";
+                for (int i = 0; i < 16; ++i)
+                    f << "01";
+                f << "\n";
+            }
+    }
+    auto bms = std::make_shared<ChartFormatBMS>(path);
+    ASSERT_EQ(bms->gamemode, 14);
+    auto obj = ChartObjectBase::createFromChartFormat(PLAYER_SLOT_PLAYER, bms);
+    RulesetBMS ruleset(bms, obj, PlayModifiers{}, bms->gamemode, RulesetBMS::LR2_DEFAULT_RANK, 1.0,
+                       RulesetBMS::PlaySide::DOUBLE, -1, nullptr);
+    ASSERT_EQ(ruleset.getNoteCount(), MEASURES * 16 * 16);
+
+    // one tick per ms, like the play loop
+    const long long ticks = obj->getTotalLength().norm() + 1000;
+    std::chrono::nanoseconds elapsed{0};
+    for (long long t = 0; t < ticks; ++t)
+    {
+        obj->update(t);
+        const auto begin = std::chrono::steady_clock::now();
+        ruleset.update(t);
+        elapsed += std::chrono::steady_clock::now() - begin;
+    }
+    std::cout << "RulesetBMS::update: " << elapsed.count() / ticks << " ns/tick over " << ticks << " ticks"
+              << std::endl;
+
+    EXPECT_EQ(ruleset.getJudgeCount(RulesetBMS::JudgeType::MISS), ruleset.getNoteCount());
+    EXPECT_TRUE(ruleset.isFinished());
+}
@@ -0,0 +1,190 @@
+#include "game/runtime/state.h"
+#include "game/runtime/state_container.h"
+#include "gmock/gmock.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <shared_mutex>
+#include <thread>
+
+using lunaticvibes::StateContainer;
+
+namespace
+{
+
+enum class Key
+{
+    A,
+    B,
+    C,
+    COUNT
+};
+
+// The shared_mutex container State used before it went lock-free, kept as a baseline for the benchmark below.
+template <class Value, size_t _size> class MutexStateContainer
+{
+    std::array<Value, _size> _data{};
+    mutable std::shared_mutex _mutex;
+
+public:
+    Value get(Key n) const
+    {
+        size_t idx = (size_t)n;
+        if (idx < _size)
+        {
+            std::shared_lock l{_mutex};
+            return _data[idx];
+        }
+        return {};
+    }
+
+    bool set(Key n, const Value& value)
+    {
+        size_t idx = (size_t)n;
+        if (idx < _size)
+        {
+            std::unique_lock l{_mutex};
+            _data[idx] = value;
+            return true;
+        }
+        return false;
+    }
+};
+
+// One writer and three readers, like the update loop writing while render/input/update threads read.
+template <class Container> double readsPerSecond(Container& c)
+{
+    std::atomic<bool> stop = false;
+    std::atomic<long long> reads = 0;
+    std::atomic<int> sum = 0; // keeps the reads from being optimized out
+    std::thread writer([&] {
+        int v = 0;
+        while (!stop)
+            c.set(Key::B, ++v);
+    });
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i)
+        readers.emplace_back([&] {
+            long long n = 0;
+            int sink = 0;
+            while (!stop)
+            {
+                for (int k = 0; k < 64; ++k)
+                    sink += c.get(Key::B);
+                n += 64;
+            }
+            reads += n;
+            sum += sink;
+        });
+
+    const auto begin = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    stop = true;
+    writer.join();
+    for (auto& t : readers)
+        t.join();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    return reads / elapsed.count();
+}
+
+} // namespace
+
+TEST(StateContainer, GetSetReset)
+{
+    StateContainer<Key, int, (size_t)Key::COUNT> c{7};
+    EXPECT_EQ(c.get(Key::A), 7);
+    EXPECT_TRUE(c.set(Key::A, 1));
+    EXPECT_EQ(c.get(Key::A), 1);
+    EXPECT_FALSE(c.set(Key::COUNT, 1));
+    EXPECT_EQ(c.get(Key::COUNT), 0);
+
+    EXPECT_TRUE(c.setDefault(Key::B, 3));
+    c.reset();
+    EXPECT_EQ(c.get(Key::A), 7);
+    EXPECT_EQ(c.get(Key::B), 3);
+}
+
+TEST(StateContainer, Text)
+{
+    StateContainer<Key, std::string, (size_t)Key::COUNT> c;
+    EXPECT_EQ(c.get(Key::A), "");
+    EXPECT_TRUE(c.set(Key::A, "hello"));
+    EXPECT_EQ(c.get(Key::A), "hello");
+    EXPECT_FALSE(c.set(Key::COUNT, "x"));
+
+    EXPECT_TRUE(c.setDefault(Key::B, "default"));
+    c.reset();
+    EXPECT_EQ(c.get(Key::A), "");
+    EXPECT_EQ(c.get(Key::B), "default");
+}
+
+TEST(StateContainer, TextReadsAreNeverTorn)
+{
+    StateContainer<Key, std::string, (size_t)Key::COUNT> c;
+    const std::string a(200, 'a');
+    const std::string b(300, 'b');
+    c.set(Key::A, a);
+
+    std::atomic<bool> stop = false;
+    std::atomic<int> torn = 0;
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i)
+        readers.emplace_back([&] {
+            while (!stop)
+            {
+                const std::string s = c.get(Key::A);
+                if (s != a && s != b)
+                    ++torn;
+            }
+        });
+    for (int i = 0; i < 20000; ++i)
+        c.set(Key::A, (i & 1) ? a : b);
+    stop = true;
+    for (auto& t : readers)
+        t.join();
+    EXPECT_EQ(torn, 0);
+}
+
+// Microbenchmark, run with --gtest_also_run_disabled_tests --gtest_filter=*ReaderThroughput
+TEST(StateContainer, DISABLED_ReaderThroughput)
+{
+    MutexStateContainer<int, (size_t)Key::COUNT> locked;
+    StateContainer<Key, int, (size_t)Key::COUNT> lockFree;
+    const double lockedRate = readsPerSecond(locked);
+    const double lockFreeRate = readsPerSecond(lockFree);
+    std::cout << "shared_mutex: " << lockedRate / 1e6 << " M reads/s" << std::endl;
+    std::cout << "atomic:       " << lockFreeRate / 1e6 << " M reads/s" << std::endl;
+    EXPECT_GT(lockFreeRate, lockedRate);
+}
+
+TEST(State, SnapshotScope)
+{
+    State::invalidateSnapshot();
+    EXPECT_EQ(State::acquireSnapshot(), nullptr);
+
+    State::set(IndexNumber::_TEST3, 1);
+    State::set(IndexSwitch::_TEST1, true);
+    State::publishSnapshot();
+    State::set(IndexNumber::_TEST3, 2);
+    State::set(IndexSwitch::_TEST1, false);
+
+    const State::Snapshot* snapshot = State::acquireSnapshot();
+    ASSERT_NE(snapshot, nullptr);
+    {
+        State::SnapshotScope scope(snapshot);
+        EXPECT_EQ(State::get(IndexNumber::_TEST3), 1);
+        EXPECT_TRUE(State::get(IndexSwitch::_TEST1));
+    }
+    EXPECT_EQ(State::get(IndexNumber::_TEST3), 2);
+    EXPECT_FALSE(State::get(IndexSwitch::_TEST1));
+
+    // Nothing new published, the same snapshot is handed out again.
+    EXPECT_EQ(State::acquireSnapshot(), snapshot);
+    State::publishSnapshot();
+    {
+        State::SnapshotScope scope(State::acquireSnapshot());
+        EXPECT_EQ(State::get(IndexNumber::_TEST3), 2);
+    }
+    State::invalidateSnapshot();
+}
@@ -0,0 +1,62 @@
+#include "game/graphics/texture_atlas.h"
+#include "gmock/gmock.h"
+
+using lunaticvibes::graphics::TextureAtlas;
+
+TEST(TextureAtlas, ShelfPacking)
+{
+    TextureAtlas atlas{64, 32};
+    constexpr int B = TextureAtlas::BORDER;
+
+    auto a = atlas.place(20, 10);
+    ASSERT_TRUE(a);
+    EXPECT_EQ(a->page, 0);
+    EXPECT_EQ(a->rect, Rect(B, B, 20, 10));
+
+    // same shelf, after the border of a
+    auto b = atlas.place(20, 16);
+    ASSERT_TRUE(b);
+    EXPECT_EQ(b->page, 0);
+    EXPECT_EQ(b->rect, Rect(20 + 3 * B, B, 20, 16));
+
+    // no room left on the shelf, the next one starts below the tallest image
+    auto c = atlas.place(30, 8);
+    ASSERT_TRUE(c);
+    EXPECT_EQ(c->page, 0);
+    EXPECT_EQ(c->rect, Rect(B, 16 + 3 * B, 30, 8));
+
+    EXPECT_EQ(atlas.getPageCount(), 1);
+}
+
+TEST(TextureAtlas, NewPageWhenFull)
+{
+    TextureAtlas atlas{64, 32};
+    for (int i = 0; i < 4; ++i)
+    {
+        auto p = atlas.place(30, 30);
+        ASSERT_TRUE(p);
+        EXPECT_EQ(p->page, 0);
+    }
+    auto p = atlas.place(30, 30);
+    ASSERT_TRUE(p);
+    EXPECT_EQ(p->page, 1);
+    EXPECT_EQ(p->rect, Rect(TextureAtlas::BORDER, TextureAtlas::BORDER, 30, 30));
+
+    auto q = atlas.place(2, 2);
+    ASSERT_TRUE(q);
+    EXPECT_EQ(q->page, 1);
+    EXPECT_EQ(q->rect, Rect(30 + 3 * TextureAtlas::BORDER, TextureAtlas::BORDER, 2, 2));
+    EXPECT_EQ(atlas.getPageCount(), 2);
+}
+
+TEST(TextureAtlas, LargeImagesStandalone)
+{
+    TextureAtlas atlas{64, 32};
+    EXPECT_FALSE(atlas.place(33, 1));
+    EXPECT_FALSE(atlas.place(1, 33));
+    EXPECT_FALSE(atlas.place(0, 10));
+    EXPECT_EQ(atlas.getPageCount(), 0);
+
+    TextureAtlas tight{32, 32};
+    EXPECT_FALSE(tight.place(32, 32)); // no room for the border
+}
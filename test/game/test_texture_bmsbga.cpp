@@ -0,0 +1,196 @@
+#include "common/sysutil.h"
+#include "game/graphics/texture_extra.h"
+#include "gmock/gmock.h"
+
+#include <chrono>
+#include <climits>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+
+#include "../temp_dir.h"
+
+namespace
+{
+
+// 16x16 is 2048 bytes per texture in the budget's accounting, the layer being another texture
+constexpr size_t PICTURE_BYTES = 16 * 16 * 4 * 2;
+
+class mock_TextureBmsBga : public TextureBmsBga
+{
+public:
+    using TextureBmsBga::residentBytes;
+    using TextureBmsBga::streamStep;
+    using TextureBmsBga::timeline;
+
+    bool isResident(size_t idx, bool layer = false) const
+    {
+        const auto& m = layer ? objs_layer : objs;
+        auto it = m.find(idx);
+        return it != m.end() && it->second.pt != nullptr;
+    }
+};
+
+// Writes a black 24-bit BMP.
+void writeBmp(const Path& path, int w, int h)
+{
+    const int stride = (w * 3 + 3) & ~3;
+    const uint32_t dataSize = stride * h;
+    auto u16 = [](std::ofstream& f, uint16_t v) { f.put(char(v & 0xFF)).put(char(v >> 8)); };
+    auto u32 = [&u16](std::ofstream& f, uint32_t v) {
+        u16(f, uint16_t(v & 0xFFFF));
+        u16(f, uint16_t(v >> 16));
+    };
+    std::ofstream f(path, std::ios::binary);
+    f << "BM";
+    u32(f, 54 + dataSize);
+    u32(f, 0);
+    u32(f, 54);
+    u32(f, 40);
+    u32(f, uint32_t(w));
+    u32(f, uint32_t(h));
+    u16(f, 1);
+    u16(f, 24);
+    for (int i = 0; i < 6; ++i)
+        u32(f, 0);
+    f << std::string(dataSize, '\0');
+}
+
+class tTextureBmsBga : public ::testing::Test
+{
+protected:
+    TempDir dir{"bga"};
+
+    // Loads the pictures the way ScenePlay does.
+    void load(mock_TextureBmsBga& bga, const std::vector<std::pair<size_t, Path>>& files)
+    {
+        std::vector<TextureBmsBga::DecodedBmp> batch;
+        for (const auto& [idx, path] : files)
+            batch.push_back(bga.decodeBmp(idx, path));
+        bga.addDecoded(batch);
+    }
+};
+
+} // namespace
+
+TEST_F(tTextureBmsBga, TimelineEndsAtNextSlotOfChannel)
+{
+    mock_TextureBmsBga bga;
+    bga.setSlot(1, 0, true, false, false);
+    bga.setSlot(2, 1000, true, false, false);
+    bga.setSlot(3, 500, false, true, false);
+    bga.setSlot(1, 2000, false, false, true);
+    bga.sortSlot();
+
+    ASSERT_EQ(bga.timeline.size(), 4);
+    EXPECT_EQ(bga.timeline[0].start, 0);
+    EXPECT_EQ(bga.timeline[0].end, 1000);
+    EXPECT_EQ(bga.timeline[0].idx, 1);
+    EXPECT_FALSE(bga.timeline[0].layer);
+    EXPECT_EQ(bga.timeline[1].start, 500);
+    EXPECT_EQ(bga.timeline[1].end, LLONG_MAX);
+    EXPECT_EQ(bga.timeline[1].idx, 3);
+    EXPECT_TRUE(bga.timeline[1].layer);
+    EXPECT_EQ(bga.timeline[2].start, 1000);
+    EXPECT_EQ(bga.timeline[2].end, LLONG_MAX);
+    EXPECT_EQ(bga.timeline[2].idx, 2);
+    EXPECT_EQ(bga.timeline[3].start, 2000);
+    EXPECT_EQ(bga.timeline[3].idx, 1);
+
+    EXPECT_EQ(bga.getFirstUse(1), 0);
+    EXPECT_EQ(bga.getFirstUse(2), 1000);
+    EXPECT_EQ(bga.getFirstUse(3), 500);
+    EXPECT_EQ(bga.getFirstUse(4), LLONG_MAX);
+}
+
+TEST_F(tTextureBmsBga, DecodeReservesBudget)
+{
+    for (int i = 0; i < 2; ++i)
+        writeBmp(dir / ("pic" + std::to_string(i) + ".bmp"), 16, 16);
+
+    mock_TextureBmsBga bga;
+    bga.setTextureBudget(PICTURE_BYTES * 3);
+    auto fits = bga.decodeBmp(0, dir / "pic0.bmp");
+    EXPECT_TRUE(fits.image.has_value());
+    EXPECT_EQ(fits.bytes, PICTURE_BYTES);
+    EXPECT_EQ(bga.residentBytes.load(), PICTURE_BYTES * 2);
+
+    // image and layer do not fit in what is left, the size still comes from the header
+    auto deferred = bga.decodeBmp(1, dir / "pic1.bmp");
+    EXPECT_FALSE(deferred.image.has_value());
+    EXPECT_EQ(deferred.bytes, PICTURE_BYTES);
+    EXPECT_EQ(bga.residentBytes.load(), PICTURE_BYTES * 2);
+}
+
+TEST_F(tTextureBmsBga, StreamsWindowAndEvictsPictureNotNeeded)
+{
+    for (int i = 0; i < 3; ++i)
+        writeBmp(dir / ("pic" + std::to_string(i) + ".bmp"), 16, 16);
+    writeBmp(dir / "big.bmp", 64, 64);
+
+    mock_TextureBmsBga bga;
+    bga.setTextureBudget(PICTURE_BYTES * 2);
+    bga.setSlot(0, 0, true, false, false);
+    bga.setSlot(1, 1000, true, false, false);
+    bga.setSlot(2, 10000, true, false, false);
+    bga.setSlot(3, 20000, true, false, false);
+    bga.sortSlot();
+    // streamStep() is called directly instead of from the streaming thread setLoaded() would start
+    load(bga, {{0, dir / "pic0.bmp"}, {1, dir / "pic1.bmp"}, {2, dir / "pic2.bmp"}, {3, dir / "big.bmp"}});
+
+    // only the first picture fits at load
+    EXPECT_TRUE(bga.isResident(0));
+    EXPECT_TRUE(bga.isResident(0, true));
+    EXPECT_FALSE(bga.isResident(1));
+    EXPECT_EQ(bga.residentBytes.load(), PICTURE_BYTES * 2);
+
+    // the unused layer makes room for what is shown next
+    std::stop_source stop;
+    bga.streamStep(0, stop.get_token());
+    EXPECT_TRUE(bga.isResident(0));
+    EXPECT_FALSE(bga.isResident(0, true));
+    EXPECT_TRUE(bga.isResident(1));
+    EXPECT_FALSE(bga.isResident(2));
+    EXPECT_EQ(bga.residentBytes.load(), PICTURE_BYTES * 2);
+
+    // pictures over before the window are evicted
+    bga.streamStep(12000, stop.get_token());
+    EXPECT_FALSE(bga.isResident(0));
+    EXPECT_TRUE(bga.isResident(2));
+    EXPECT_EQ(bga.residentBytes.load(), PICTURE_BYTES * 2);
+
+    // a picture larger than the budget is not loaded, and nothing is evicted for it
+    bga.streamStep(19000, stop.get_token());
+    EXPECT_FALSE(bga.isResident(3));
+    EXPECT_EQ(bga.residentBytes.load(), PICTURE_BYTES * 2);
+    EXPECT_TRUE(bga.isResident(1));
+    EXPECT_TRUE(bga.isResident(2));
+}
+
+TEST_F(tTextureBmsBga, StopUpdateDoesNotWaitForMainThread)
+{
+    for (int i = 0; i < 2; ++i)
+        writeBmp(dir / ("pic" + std::to_string(i) + ".bmp"), 16, 16);
+
+    mock_TextureBmsBga bga;
+    bga.setTextureBudget(PICTURE_BYTES * 2);
+    bga.setSlot(0, 0, true, false, false);
+    bga.setSlot(1, 1000, true, false, false);
+    bga.sortSlot();
+    load(bga, {{0, dir / "pic0.bmp"}, {1, dir / "pic1.bmp"}});
+    ASSERT_FALSE(bga.isResident(1));
+
+    // the streaming thread asks the main thread to upload pic1, which is busy stopping it instead
+    bga.setLoaded();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    auto stopped = std::async(std::launch::async, [&bga] { bga.stopUpdate(); });
+    EXPECT_EQ(stopped.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    while (stopped.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready)
+        doMainThreadTask();
+
+    // the abandoned upload is skipped
+    doMainThreadTask();
+    EXPECT_FALSE(bga.isResident(1));
+}
@@ -0,0 +1,199 @@
+#include "game/graphics/texture_cache.h"
+#include "gmock/gmock.h"
+
+#include <future>
+#include <thread>
+
+using lunaticvibes::graphics::TextureCache;
+
+namespace
+{
+
+class mock_Image : public Image
+{
+public:
+    mock_Image() : Image("") {}
+};
+
+// 16x16, 2048 bytes in the cache's accounting
+class mock_Texture : public Texture
+{
+public:
+    mock_Texture() : Texture(mock_Image())
+    {
+        textureRect = {0, 0, 16, 16};
+        loaded = true;
+    }
+};
+
+constexpr size_t TEXTURE_BYTES = 16 * 16 * 4 * 2;
+
+// Stands in for a texture whose destruction waits for the main thread.
+class mock_BlockingTexture : public mock_Texture
+{
+public:
+    mock_BlockingTexture(std::promise<void>& destroying, std::shared_future<void> mayFinish)
+        : destroying(destroying), mayFinish(std::move(mayFinish))
+    {
+    }
+    ~mock_BlockingTexture() override
+    {
+        destroying.set_value();
+        mayFinish.wait();
+    }
+
+private:
+    std::promise<void>& destroying;
+    std::shared_future<void> mayFinish;
+};
+
+// stands in for an atlas page
+class mock_Page : public Texture
+{
+public:
+    mock_Page() : Texture(mock_Image())
+    {
+        textureRect = {0, 0, 64, 64};
+        loaded = true;
+    }
+};
+
+constexpr size_t PAGE_BYTES = 64 * 64 * 4 * 2;
+
+struct CountingLoader
+{
+    int loads = 0;
+    TextureCache::Loader fn()
+    {
+        return [this](const Path&, std::optional<Color>) {
+            ++loads;
+            return std::make_shared<mock_Texture>();
+        };
+    }
+};
+
+} // namespace
+
+TEST(TextureCache, SharedWhileReferenced)
+{
+    CountingLoader loader;
+    TextureCache cache{0, loader.fn()};
+
+    auto a = cache.get("lr2skin/if1.lr2skin");
+    auto b = cache.get("lr2skin/if1.lr2skin");
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(loader.loads, 1);
+
+    // different transparent color is a different texture
+    auto c = cache.get("lr2skin/if1.lr2skin", Color(0xFF00FFFF));
+    EXPECT_NE(a, c);
+    EXPECT_EQ(loader.loads, 2);
+
+    // referenced textures survive even a zero budget
+    const auto stats = cache.getStats();
+    EXPECT_EQ(stats.entries, 2);
+    EXPECT_EQ(stats.referenced, 2);
+    EXPECT_EQ(stats.referencedBytes, 2 * TEXTURE_BYTES);
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 2);
+
+    a.reset();
+    b.reset();
+    cache.purge();
+    EXPECT_EQ(cache.getStats().entries, 1);
+    EXPECT_EQ(cache.getStats().evictions, 1);
+}
+
+TEST(TextureCache, UnreferencedSurviveUnderBudget)
+{
+    CountingLoader loader;
+    TextureCache cache{2 * TEXTURE_BYTES, loader.fn()};
+
+    // previous scene
+    cache.get("lr2skin/if1.lr2skin");
+    cache.get("lr2skin/if2.lr2skin");
+    EXPECT_EQ(cache.getStats().referenced, 0);
+
+    // next scene picks if1 up again without reloading
+    auto a = cache.get("lr2skin/if1.lr2skin");
+    EXPECT_EQ(loader.loads, 2);
+
+    // over budget: if2 is the least recently used unreferenced one
+    cache.get("lr2skin/if3.lr2skin");
+    EXPECT_EQ(loader.loads, 3);
+    const auto entries = cache.getEntries();
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries[0].path, "lr2skin/if3.lr2skin");
+    EXPECT_EQ(entries[1].path, "lr2skin/if1.lr2skin");
+    EXPECT_EQ(entries[1].refs, 1);
+
+    cache.get("lr2skin/if1.lr2skin");
+    EXPECT_EQ(loader.loads, 3);
+}
+
+TEST(TextureCache, MissingFileNotCached)
+{
+    CountingLoader loader;
+    TextureCache cache{TextureCache::DEFAULT_BUDGET, loader.fn()};
+    cache.get("lr2skin/does_not_exist.png");
+    cache.get("lr2skin/does_not_exist.png");
+    EXPECT_EQ(loader.loads, 2);
+    EXPECT_EQ(cache.getStats().entries, 0);
+}
+
+TEST(TextureCache, AtlasPageCountedOnce)
+{
+    auto page = std::make_shared<mock_Page>();
+    TextureCache::Loader regionLoader = [&page](const Path&, std::optional<Color>) {
+        return std::make_shared<TextureRegion>(page, Rect{0, 0, 16, 16});
+    };
+    TextureCache cache{PAGE_BYTES, regionLoader};
+
+    auto a = cache.get("lr2skin/if1.lr2skin");
+    auto b = cache.get("lr2skin/if2.lr2skin");
+    auto stats = cache.getStats();
+    EXPECT_EQ(stats.entries, 2);
+    EXPECT_EQ(stats.pages, 1);
+    EXPECT_EQ(stats.bytes, PAGE_BYTES);
+    EXPECT_EQ(stats.referencedBytes, PAGE_BYTES);
+
+    // b still pins the page, dropping a would free nothing
+    a.reset();
+    cache.setBudget(0);
+    EXPECT_EQ(cache.getStats().entries, 2);
+    EXPECT_EQ(cache.getStats().bytes, PAGE_BYTES);
+
+    b.reset();
+    page.reset();
+    cache.purge();
+    stats = cache.getStats();
+    EXPECT_EQ(stats.entries, 0);
+    EXPECT_EQ(stats.pages, 0);
+    EXPECT_EQ(stats.bytes, 0);
+}
+
+TEST(TextureCache, EvictedTexturesReleasedOutsideLock)
+{
+    std::promise<void> destroying;
+    std::promise<void> mayFinish;
+    int loads = 0;
+    TextureCache::Loader loader = [&](const Path&, std::optional<Color>) -> std::shared_ptr<Texture> {
+        if (loads++ == 0)
+            return std::make_shared<mock_BlockingTexture>(destroying, mayFinish.get_future().share());
+        return std::make_shared<mock_Texture>();
+    };
+    TextureCache cache{0, loader};
+    cache.get("lr2skin/if1.lr2skin");
+
+    // a worker evicts if1, whose destruction is stuck until the main thread gets to it
+    std::thread worker([&cache] { cache.get("lr2skin/if2.lr2skin"); });
+    ASSERT_EQ(destroying.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+
+    // meanwhile the main thread still gets through to the cache
+    auto stats = std::async(std::launch::async, [&cache] { return cache.getStats(); });
+    EXPECT_EQ(stats.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+
+    mayFinish.set_value();
+    worker.join();
+    EXPECT_EQ(stats.get().evictions, 1);
+}
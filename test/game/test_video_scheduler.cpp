@@ -0,0 +1,168 @@
+#include "game/graphics/video_scheduler.h"
+#include "gmock/gmock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using lunaticvibes::graphics::VideoScheduler;
+
+namespace
+{
+
+class mock_Source : public VideoScheduler::Source
+{
+public:
+    mock_Source(int id, int64_t deadline, int frames, std::mutex& m, std::vector<int>& order)
+        : id(id), deadline(deadline), remaining(frames), m(m), order(order)
+    {
+    }
+
+    bool wantsDecode() const override
+    {
+        ++polls;
+        return remaining > 0;
+    }
+    int64_t getDecodeDeadline() const override { return deadline; }
+    void decodeStep() override
+    {
+        EXPECT_FALSE(inStep.exchange(true));
+        {
+            std::unique_lock l{m};
+            order.push_back(id);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        --remaining;
+        inStep = false;
+    }
+
+    int id;
+    std::atomic<int64_t> deadline;
+    std::atomic<int> remaining;
+    std::atomic<bool> inStep = false;
+    mutable std::atomic<int> polls = 0;
+    std::mutex& m;
+    std::vector<int>& order;
+};
+
+void waitUntilDone(const std::vector<mock_Source*>& sources)
+{
+    for (int i = 0; i < 2000; ++i)
+    {
+        if (std::none_of(sources.begin(), sources.end(), [](auto* s) { return s->wantsDecode(); }))
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+} // namespace
+
+TEST(VideoScheduler, EarliestDeadlineFirst)
+{
+    std::mutex m;
+    std::vector<int> order;
+    mock_Source late{1, 100, 3, m, order};
+    mock_Source urgent{2, 10, 3, m, order};
+
+    VideoScheduler scheduler{1};
+    {
+        // queue both before the single worker can look at either
+        std::unique_lock l{m};
+        scheduler.add(&late);
+        scheduler.add(&urgent);
+    }
+    waitUntilDone({&late, &urgent});
+    scheduler.remove(&late);
+    scheduler.remove(&urgent);
+
+    std::unique_lock l{m};
+    ASSERT_EQ(order.size(), 6);
+    // the worker may have started on the first source before the second one was added
+    const size_t first = order[0] == 1 ? 1 : 0;
+    for (size_t i = first; i < first + 3; ++i)
+        EXPECT_EQ(order[i], 2);
+}
+
+TEST(VideoScheduler, SourceNeverDecodedConcurrently)
+{
+    std::mutex m;
+    std::vector<int> order;
+    mock_Source a{1, 0, 50, m, order};
+    mock_Source b{2, 0, 50, m, order};
+
+    VideoScheduler scheduler{4};
+    EXPECT_EQ(scheduler.getWorkerCount(), 4);
+    scheduler.add(&a);
+    scheduler.add(&b);
+    waitUntilDone({&a, &b});
+
+    // remove() waits for a running step
+    scheduler.remove(&a);
+    scheduler.remove(&b);
+    EXPECT_EQ(a.remaining, 0);
+    EXPECT_EQ(b.remaining, 0);
+    EXPECT_EQ(order.size(), 100);
+}
+
+TEST(VideoScheduler, IdleSourcesStayParked)
+{
+    std::mutex m;
+    std::vector<int> order;
+    mock_Source a{1, 0, 0, m, order};
+
+    VideoScheduler scheduler{2};
+    scheduler.add(&a);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_TRUE(order.empty());
+
+    a.remaining = 1;
+    scheduler.wake();
+    waitUntilDone({&a});
+    scheduler.remove(&a);
+    EXPECT_EQ(order.size(), 1);
+}
+
+TEST(VideoScheduler, IdleWorkersDoNotPoll)
+{
+    std::mutex m;
+    std::vector<int> order;
+    mock_Source a{1, 0, 0, m, order};
+
+    VideoScheduler scheduler{4};
+    scheduler.add(&a);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const int polls = a.polls;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(a.polls, polls);
+
+    // every worker woken looks once
+    scheduler.wake();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_GE(a.polls, polls + 1);
+    EXPECT_LE(a.polls, polls + 4);
+    scheduler.remove(&a);
+}
+
+TEST(VideoScheduler, RemoveBusySourceTwice)
+{
+    std::mutex m;
+    std::vector<int> order;
+    mock_Source a{1, 0, 1000, m, order};
+
+    VideoScheduler scheduler{1};
+    scheduler.add(&a);
+    for (int i = 0; i < 2000 && !a.inStep; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_TRUE(a.inStep);
+
+    // both wait for the running step, only one of them finds the job afterwards
+    std::thread t1([&] { scheduler.remove(&a); });
+    std::thread t2([&] { scheduler.remove(&a); });
+    t1.join();
+    t2.join();
+    EXPECT_FALSE(a.inStep);
+    EXPECT_GT(a.remaining, 0);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "common/types.h"
+
+// Empty directory of its own under the system temp folder, removed with everything in it on destruction.
+class TempDir
+{
+    Path _path;
+
+public:
+    explicit TempDir(std::string_view name)
+    {
+        static std::atomic<unsigned> counter{0};
+        _path = std::filesystem::temp_directory_path() /
+                ("lunaticvibes_test_" + std::string(name) + "_" +
+                 std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_" +
+                 std::to_string(counter++));
+        std::filesystem::create_directories(_path);
+    }
+    ~TempDir()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(_path, ec);
+    }
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    [[nodiscard]] const Path& path() const { return _path; }
+    [[nodiscard]] Path operator/(std::string_view name) const { return _path / name; }
+};